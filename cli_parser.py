@@ -6,12 +6,37 @@ import ctypes
 import numpy as np
 import re
 
+# Mirrors query_options_t in marshaller.h
+class QueryOptions(ctypes.Structure):
+    _fields_ = [("precision", ctypes.c_int),
+                ("quantiles", ctypes.c_char_p),
+                ("axis", ctypes.c_int)]
+
+# Mirrors query_axis_t, no --axis folds the whole subregion into one result
+AXES = {None: 0, "columns": 1, "rows": 2}
+
+# Mirrors quantile_t and final_args_t in marshaller.h
+MAX_NUMBER_LENGTH = 4096
+MAX_QUANTILES = 16
+
+class Quantile(ctypes.Structure):
+    _fields_ = [("numerator", ctypes.c_uint64),
+                ("digits", ctypes.c_int),
+                ("text", ctypes.c_char * 26)]
+
+class QueryResults(ctypes.Structure):
+    _fields_ = [("max_result", ctypes.c_char * MAX_NUMBER_LENGTH),
+                ("min_result", ctypes.c_char * MAX_NUMBER_LENGTH),
+                ("mean_result", ctypes.c_char * MAX_NUMBER_LENGTH),
+                ("median_result", ctypes.c_char * MAX_NUMBER_LENGTH),
+                ("mode_result", ctypes.c_char * MAX_NUMBER_LENGTH),
+                ("num_quantiles", ctypes.c_int),
+                ("quantiles", Quantile * MAX_QUANTILES),
+                ("quantile_results", (ctypes.c_char * MAX_NUMBER_LENGTH) * MAX_QUANTILES)]
+
 def process_input(args):
 
-    # Maximum or specified
-    file = args.filename    
-    rows = args.yrange # if args.yrange else "full"
-    columns = args.xrange # if args.xrange else "full"
+    file = args.filename
 
     if not file:
         print("Error: No filename provided.")
@@ -42,47 +67,67 @@ def process_input(args):
             end_header = "full"
             return (start_header, end_header)
         
-    rows_starting_header = None
-    rows_ending_header = None
-    columns_starting_header = None
-    columns_ending_header = None
-
-    # Assume full if not provided
-    if (not rows or validate_index(rows) == "full"):
-        rows_starting_header = "full"
-        rows_ending_header = "full"
-    else: 
-        # Grab the values from the tuple
-        rows_starting_header, rows_ending_header = validate_index(rows)[:2]
-
-    if (not columns or validate_index(columns) == "full"):
-        columns_starting_header = "full"
-        columns_ending_header = "full"
-    else:
-        # Grab the values from the tuple
-        columns_starting_header, columns_ending_header = validate_index(columns)[:2]
-
-    # Encode the values in preperation for shared library
-    rows_starting_header = rows_starting_header.encode('utf-8')
-    rows_ending_header = rows_ending_header.encode('utf-8')
-    columns_starting_header = columns_starting_header.encode('utf-8')
-    columns_ending_header = columns_ending_header.encode('utf-8')
+    # Maximum or specified, each side of a range encoded for the shared library
+    def encode_range(rows, columns):
+        rows_starting_header = None
+        rows_ending_header = None
+        columns_starting_header = None
+        columns_ending_header = None
+
+        # Assume full if not provided
+        if (not rows or validate_index(rows) == "full"):
+            rows_starting_header = "full"
+            rows_ending_header = "full"
+        else: 
+            # Grab the values from the tuple
+            rows_starting_header, rows_ending_header = validate_index(rows)[:2]
+
+        if (not columns or validate_index(columns) == "full"):
+            columns_starting_header = "full"
+            columns_ending_header = "full"
+        else:
+            # Grab the values from the tuple
+            columns_starting_header, columns_ending_header = validate_index(columns)[:2]
+
+        # Encode the values in preperation for shared library
+        return (rows_starting_header.encode('utf-8'), rows_ending_header.encode('utf-8'),
+                columns_starting_header.encode('utf-8'), columns_ending_header.encode('utf-8'))
+
+    # Ranges pair up in order, a lone --yrange or --xrange applies to every range of the other
+    row_ranges = args.yrange or [None]
+    column_ranges = args.xrange or [None]
+    if len(row_ranges) > 1 and len(column_ranges) > 1 and len(row_ranges) != len(column_ranges):
+        print("Error: Give one --xrange, one --yrange or the same number of each.")
+        return "Operation exited with error."
+    count = max(len(row_ranges), len(column_ranges))
+    ranges = [encode_range(row_ranges[i % len(row_ranges)], column_ranges[i % len(column_ranges)]) for i in range(count)]
+
     file = file.encode('utf-8')
 
     # Load the C library and define argument types
     matrix_lib = ctypes.CDLL('./shared_libraries/libmatrix_lib.so')
-    matrix_lib.load_data.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int]
-    matrix_lib.load_data.restype = ctypes.c_int
+    matrix_lib.load_data_with_options.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.POINTER(QueryOptions)]
+    matrix_lib.load_data_with_options.restype = ctypes.c_int
 
     operations = 0
     thread_count = args.thread_count
 
+    # One-time conversion, later queries on this file map the sidecar instead of parsing the CSV
+    if args.cache:
+        matrix_lib.build_sidecar.argtypes = [ctypes.c_char_p, ctypes.c_int]
+        matrix_lib.build_sidecar.restype = ctypes.c_int
+        if matrix_lib.build_sidecar(file, thread_count) != 0:
+            return "Operation exited with error."
+
     # Bitwise flag definitions
     MAX_FLAG = 1 << 0     # 000001 (1)
     MIN_FLAG = 1 << 1     # 000010 (2)
     MEAN_FLAG = 1 << 2    # 000100 (4)
     MEDIAN_FLAG = 1 << 3  # 001000 (8)
     MODE_FLAG = 1 << 4    # 010000 (16)
+    STREAM_FLAG = 1 << 5  # 100000 (32)
+    QUANTILES_FLAG = 1 << 6  # 1000000 (64)
+    PIPELINE_FLAG = 1 << 7   # 10000000 (128)
 
     # Set bitwise flags based on user input
     if args.max:
@@ -95,14 +140,57 @@ def process_input(args):
         operations |= MEDIAN_FLAG
     if args.mode:
         operations |= MODE_FLAG
-
-    # Call the C function that prepares the data for operation
-    result = matrix_lib.load_data(file, rows_starting_header, rows_ending_header, 
-                                  columns_starting_header, columns_ending_header, 
-                                  operations, thread_count)
-
-    # Returns result of stat operation from shared library
-    return "Completed operation from shared library." if result == 0 else "Operation exited with error."
+    if args.stream:
+        operations |= STREAM_FLAG
+    if args.quantiles:
+        operations |= QUANTILES_FLAG
+    if args.pipeline:
+        operations |= PIPELINE_FLAG
+
+    options = QueryOptions(precision=args.precision,
+                           quantiles=args.quantiles.encode('utf-8') if args.quantiles else None,
+                           axis=AXES[args.axis])
+
+    # A single range is a one-off query that only tokenizes the rows it needs
+    if len(ranges) == 1:
+        result = matrix_lib.load_data_with_options(file, *ranges[0], operations, thread_count, ctypes.byref(options))
+
+        # Returns result of stat operation from shared library
+        return "Completed operation from shared library." if result == 0 else "Operation exited with error."
+
+    # Several ranges share one parse of the file through a dataframe handle
+    matrix_lib.fd_open.argtypes = [ctypes.c_char_p, ctypes.c_int]
+    matrix_lib.fd_open.restype = ctypes.c_void_p
+    matrix_lib.fd_query.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.POINTER(QueryOptions), ctypes.POINTER(QueryResults)]
+    matrix_lib.fd_query.restype = ctypes.c_int
+    matrix_lib.fd_close.argtypes = [ctypes.c_void_p]
+    matrix_lib.fd_close.restype = None
+
+    frame = matrix_lib.fd_open(file, thread_count)
+    if not frame:
+        return "Operation exited with error."
+
+    failures = 0
+    summary = []
+    results = QueryResults()
+    for starting_row, ending_row, starting_column, ending_column in ranges:
+        result = matrix_lib.fd_query(frame, starting_row, ending_row, starting_column, ending_column,
+                                     operations, thread_count, ctypes.byref(options), ctypes.byref(results))
+        failures += result != 0
+
+        label = f"rows {starting_row.decode()}-{ending_row.decode()}, columns {starting_column.decode()}-{ending_column.decode()}"
+        values = [(name, getattr(results, field).decode()) for name, field, flag in
+                  (("max", "max_result", MAX_FLAG), ("min", "min_result", MIN_FLAG), ("mean", "mean_result", MEAN_FLAG),
+                   ("median", "median_result", MEDIAN_FLAG), ("mode", "mode_result", MODE_FLAG)) if operations & flag]
+        summary.append(f"   {label}: " + ("error" if result != 0 else ", ".join(f"{name} {value}" for name, value in values)))
+
+    matrix_lib.fd_close(frame)
+
+    if args.axis is None:
+        print(f"\n📋 {len(ranges)} queries on one parse")
+        print("\n".join(summary))
+
+    return "Completed operation from shared library." if failures == 0 else "Operation exited with error."
 
 def main():
     # Create the main parser
@@ -112,8 +200,8 @@ def main():
     parser.add_argument('filename', help='Path to the data file (CSV, TSV, etc.)')
 
     # Optional arguments for x and y ranges in format x0tox2, y0toy2
-    parser.add_argument('--xrange', help='Specify the x-range (column name or index)')
-    parser.add_argument('--yrange', help='Specify the y-range (column name or index)')
+    parser.add_argument('--xrange', action='append', help='Specify the x-range (column name or index), repeat to query several ranges on one parse')
+    parser.add_argument('--yrange', action='append', help='Specify the y-range (column name or index), repeat to query several ranges on one parse')
 
     # Flags for max/min operation
     parser.add_argument('--max', action='store_true', help='Find the maximum of the selected dataset')
@@ -124,6 +212,12 @@ def main():
     parser.add_argument('--median', action='store_true', help='Calculate the median of the dataset')
     parser.add_argument('--mode', action='store_true', help='Calculate the mode of the dataset')
     parser.add_argument('--thread-count', type=int, default=1, help='Number of threads to use')
+    parser.add_argument('--precision', type=int, default=6, help='Digits after the decimal point for the mean, median and quantiles (0 to 1000)')
+    parser.add_argument('--quantiles', help='Comma-separated fractions to report, such as 0.5,0.9,0.99')
+    parser.add_argument('--axis', choices=['columns', 'rows'], help='Report every operation for each column or each row of the selection')
+    parser.add_argument('--stream', action='store_true', help='Aggregate while reading the file in bounded memory (no median or quantiles)')
+    parser.add_argument('--pipeline', action='store_true', help='Aggregate batches of rows while the file is still being parsed (no median, quantiles or axis)')
+    parser.add_argument('--cache', action='store_true', help='Write a binary columnar sidecar (<file>.fdc) that later queries read instead of the CSV')
 
     # Parse the arguments
     args = parser.parse_args()
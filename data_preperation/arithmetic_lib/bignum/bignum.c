@@ -0,0 +1,745 @@
+#include "bignum.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_LIMBS 4
+
+void bignum_init(bignum_t *n) {
+    n->limbs = NULL;
+    n->length = 0;
+    n->capacity = 0;
+    n->negative = false;
+}
+
+void bignum_free(bignum_t *n) {
+    if (!n) return;
+    free(n->limbs);
+    bignum_init(n);
+}
+
+static bool reserve(bignum_t *n, int limbs) {
+    if (limbs <= n->capacity) return true;
+
+    int capacity = n->capacity ? n->capacity : INITIAL_LIMBS;
+    while (capacity < limbs) capacity *= 2;
+
+    uint32_t *grown = realloc(n->limbs, capacity * sizeof(uint32_t));
+    if (!grown) {
+        fprintf(stderr, "Failed to allocate memory for bignum limbs\n");
+        return false;
+    }
+    n->limbs = grown;
+    n->capacity = capacity;
+    return true;
+}
+
+// Drop high zero limbs so length and sign stay canonical
+static void trim(bignum_t *n) {
+    while (n->length > 0 && n->limbs[n->length - 1] == 0) n->length--;
+    if (n->length == 0) n->negative = false;
+}
+
+void bignum_set_zero(bignum_t *n) {
+    n->length = 0;
+    n->negative = false;
+}
+
+bool bignum_set_int64(bignum_t *n, int64_t value) {
+    if (!reserve(n, 3)) return false;
+
+    // Negate in unsigned space so INT64_MIN is representable
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    n->length = 0;
+    while (magnitude) {
+        n->limbs[n->length++] = (uint32_t)(magnitude % BIGNUM_BASE);
+        magnitude /= BIGNUM_BASE;
+    }
+    n->negative = value < 0;
+    return true;
+}
+
+bool bignum_copy(bignum_t *dest, const bignum_t *src) {
+    if (dest == src) return true;
+    if (!reserve(dest, src->length)) return false;
+    if (src->length) memcpy(dest->limbs, src->limbs, src->length * sizeof(uint32_t));
+    dest->length = src->length;
+    dest->negative = src->negative;
+    return true;
+}
+
+bool bignum_parse(bignum_t *n, const char *str, size_t len) {
+    const char *end = str + len;
+    while (str < end && isspace((unsigned char)*str)) str++;
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+
+    bool negative = false;
+    if (str < end && (*str == '+' || *str == '-')) {
+        negative = *str == '-';
+        str++;
+    }
+    while (str < end && *str == '0') str++;
+
+    for (const char *c = str; c < end; c++) {
+        if (*c < '0' || *c > '9') return false;
+    }
+
+    size_t digits = (size_t)(end - str);
+    if (digits / BIGNUM_BASE_DIGITS >= (size_t)INT32_MAX / 2) return false;
+    if (!reserve(n, (int)((digits + BIGNUM_BASE_DIGITS - 1) / BIGNUM_BASE_DIGITS))) return false;
+
+    // Nine digits per limb, starting from the least significant end
+    n->length = 0;
+    const char *chunk_end = end;
+    while (chunk_end > str) {
+        const char *chunk_start = chunk_end - str > BIGNUM_BASE_DIGITS ? chunk_end - BIGNUM_BASE_DIGITS : str;
+        uint32_t limb = 0;
+        for (const char *c = chunk_start; c < chunk_end; c++) limb = limb * 10 + (uint32_t)(*c - '0');
+        n->limbs[n->length++] = limb;
+        chunk_end = chunk_start;
+    }
+
+    n->negative = negative;
+    trim(n);
+    return true;
+}
+
+int bignum_to_string(const bignum_t *n, char *out, size_t size) {
+    if (n->length == 0) {
+        if (size < 2) return -1;
+        out[0] = '0';
+        out[1] = '\0';
+        return 1;
+    }
+
+    char top[16];
+    int top_length = snprintf(top, sizeof(top), "%u", n->limbs[n->length - 1]);
+    size_t total = (n->negative ? 1 : 0) + (size_t)top_length + (size_t)(n->length - 1) * BIGNUM_BASE_DIGITS;
+    if (total + 1 > size) return -1;
+
+    char *cursor = out;
+    if (n->negative) *cursor++ = '-';
+    memcpy(cursor, top, top_length);
+    cursor += top_length;
+
+    // Lower limbs are always nine digits wide
+    for (int i = n->length - 2; i >= 0; i--) {
+        uint32_t limb = n->limbs[i];
+        for (int d = BIGNUM_BASE_DIGITS - 1; d >= 0; d--) {
+            cursor[d] = (char)('0' + limb % 10);
+            limb /= 10;
+        }
+        cursor += BIGNUM_BASE_DIGITS;
+    }
+    *cursor = '\0';
+
+    return (int)total;
+}
+
+static int compare_magnitudes(const bignum_t *a, const bignum_t *b) {
+    if (a->length != b->length) return a->length > b->length ? 1 : -1;
+    for (int i = a->length - 1; i >= 0; i--) {
+        if (a->limbs[i] != b->limbs[i]) return a->limbs[i] > b->limbs[i] ? 1 : -1;
+    }
+    return 0;
+}
+
+int bignum_compare(const bignum_t *a, const bignum_t *b) {
+    if (a->negative != b->negative) return a->negative ? -1 : 1;
+    int cmp = compare_magnitudes(a, b);
+    return a->negative ? -cmp : cmp;
+}
+
+// |result| = |a| + |b|, operands are read before each limb is written so aliasing is safe
+static bool add_magnitudes(bignum_t *result, const bignum_t *a, const bignum_t *b) {
+    int a_length = a->length, b_length = b->length;
+    int longest = a_length > b_length ? a_length : b_length;
+    if (!reserve(result, longest + 1)) return false;
+
+    uint32_t carry = 0;
+    for (int i = 0; i < longest; i++) {
+        uint32_t sum = carry + (i < a_length ? a->limbs[i] : 0) + (i < b_length ? b->limbs[i] : 0);
+        carry = sum >= BIGNUM_BASE;
+        result->limbs[i] = carry ? sum - BIGNUM_BASE : sum;
+    }
+    result->limbs[longest] = carry;
+    result->length = longest + 1;
+    return true;
+}
+
+// |result| = |a| - |b| for |a| >= |b|
+static bool subtract_magnitudes(bignum_t *result, const bignum_t *a, const bignum_t *b) {
+    int a_length = a->length, b_length = b->length;
+    if (!reserve(result, a_length)) return false;
+
+    uint32_t borrow = 0;
+    for (int i = 0; i < a_length; i++) {
+        uint32_t subtrahend = borrow + (i < b_length ? b->limbs[i] : 0);
+        uint32_t limb = a->limbs[i];
+        borrow = limb < subtrahend;
+        result->limbs[i] = borrow ? limb + BIGNUM_BASE - subtrahend : limb - subtrahend;
+    }
+    result->length = a_length;
+    return true;
+}
+
+static bool add_signed(bignum_t *result, const bignum_t *a, const bignum_t *b, bool b_negative) {
+    bool a_negative = a->negative;
+    bool success;
+    bool negative;
+
+    if (a_negative == b_negative) {
+        success = add_magnitudes(result, a, b);
+        negative = a_negative;
+    } else if (compare_magnitudes(a, b) >= 0) {
+        success = subtract_magnitudes(result, a, b);
+        negative = a_negative;
+    } else {
+        success = subtract_magnitudes(result, b, a);
+        negative = b_negative;
+    }
+
+    if (!success) return false;
+    result->negative = negative;
+    trim(result);
+    return true;
+}
+
+bool bignum_add(bignum_t *result, const bignum_t *a, const bignum_t *b) {
+    return add_signed(result, a, b, b->negative);
+}
+
+bool bignum_sub(bignum_t *result, const bignum_t *a, const bignum_t *b) {
+    return add_signed(result, a, b, !b->negative && b->length > 0);
+}
+
+bool bignum_add_int128(bignum_t *n, __int128 value, bignum_t *scratch) {
+    if (value == 0) return true;
+    if (!reserve(scratch, 5)) return false;
+
+    unsigned __int128 magnitude = value < 0 ? 0 - (unsigned __int128)value : (unsigned __int128)value;
+    scratch->length = 0;
+    while (magnitude) {
+        scratch->limbs[scratch->length++] = (uint32_t)(magnitude % BIGNUM_BASE);
+        magnitude /= BIGNUM_BASE;
+    }
+    scratch->negative = value < 0;
+
+    return bignum_add(n, n, scratch);
+}
+
+bool bignum_mul_small(bignum_t *n, uint32_t factor, uint32_t addend) {
+    if (!reserve(n, n->length + 2)) return false;
+
+    uint64_t carry = addend;
+    for (int i = 0; i < n->length; i++) {
+        uint64_t product = (uint64_t)n->limbs[i] * factor + carry;
+        n->limbs[i] = (uint32_t)(product % BIGNUM_BASE);
+        carry = product / BIGNUM_BASE;
+    }
+    while (carry) {
+        n->limbs[n->length++] = (uint32_t)(carry % BIGNUM_BASE);
+        carry /= BIGNUM_BASE;
+    }
+
+    trim(n);
+    return true;
+}
+
+static const uint32_t powers_of_ten[BIGNUM_BASE_DIGITS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+bool bignum_mul_pow10(bignum_t *n, int exponent) {
+    if (n->length == 0 || exponent <= 0) return true;
+
+    // Whole limbs shift in as zeros, the rest is one small multiply
+    int shift = exponent / BIGNUM_BASE_DIGITS;
+    if (shift) {
+        if (!reserve(n, n->length + shift)) return false;
+        memmove(n->limbs + shift, n->limbs, n->length * sizeof(uint32_t));
+        memset(n->limbs, 0, shift * sizeof(uint32_t));
+        n->length += shift;
+    }
+
+    int rest = exponent % BIGNUM_BASE_DIGITS;
+    return rest == 0 || bignum_mul_small(n, powers_of_ten[rest], 0);
+}
+
+bool bignum_append_digits(bignum_t *n, const char *digits, size_t len) {
+    while (len) {
+        size_t chunk = len < BIGNUM_BASE_DIGITS ? len : BIGNUM_BASE_DIGITS;
+        uint32_t value = 0;
+        for (size_t i = 0; i < chunk; i++) value = value * 10 + (uint32_t)(digits[i] - '0');
+
+        if (!bignum_mul_small(n, powers_of_ten[chunk], value)) return false;
+        digits += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+int bignum_digits(const bignum_t *n) {
+    if (n->length == 0) return 0;
+
+    int digits = (n->length - 1) * BIGNUM_BASE_DIGITS;
+    for (uint32_t top = n->limbs[n->length - 1]; top; top /= 10) digits++;
+    return digits;
+}
+
+uint32_t bignum_divmod_small(bignum_t *n, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (int i = n->length - 1; i >= 0; i--) {
+        uint64_t current = remainder * BIGNUM_BASE + n->limbs[i];
+        n->limbs[i] = (uint32_t)(current / divisor);
+        remainder = current % divisor;
+    }
+    trim(n);
+    return (uint32_t)remainder;
+}
+
+/*
+    Multiplication kernels over raw limb arrays. Products go to a buffer that does not overlap
+    the operands and every temporary is carved out of one arena sized before the first call.
+ */
+
+// Karatsuba recursion needs at least four limbs to shrink, see karatsuba_scratch
+#define KARATSUBA_CUTOFF (BIGNUM_KARATSUBA_THRESHOLD < 4 ? 4 : BIGNUM_KARATSUBA_THRESHOLD)
+
+// r[0 .. na + nb) = a * b
+static void mul_schoolbook(uint32_t *r, const uint32_t *a, size_t na, const uint32_t *b, size_t nb) {
+    memset(r, 0, (na + nb) * sizeof(uint32_t));
+    for (size_t i = 0; i < na; i++) {
+        uint64_t multiplier = a[i];
+        if (multiplier == 0) continue;
+
+        uint64_t carry = 0;
+        for (size_t j = 0; j < nb; j++) {
+            uint64_t current = r[i + j] + multiplier * b[j] + carry;
+            r[i + j] = (uint32_t)(current % BIGNUM_BASE);
+            carry = current / BIGNUM_BASE;
+        }
+        r[i + nb] = (uint32_t)carry;
+    }
+}
+
+// r[0 .. n + 1) = a[0 .. n) + b[0 .. m), m <= n
+static void add_limbs(uint32_t *r, const uint32_t *a, size_t n, const uint32_t *b, size_t m) {
+    uint32_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t sum = a[i] + (i < m ? b[i] : 0) + carry;
+        carry = sum >= BIGNUM_BASE;
+        r[i] = carry ? sum - BIGNUM_BASE : sum;
+    }
+    r[n] = carry;
+}
+
+// r[0 .. n) += a[0 .. m), m <= n and the sum must fit in n limbs
+static void add_into(uint32_t *r, size_t n, const uint32_t *a, size_t m) {
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i < m; i++) {
+        uint32_t sum = r[i] + a[i] + carry;
+        carry = sum >= BIGNUM_BASE;
+        r[i] = carry ? sum - BIGNUM_BASE : sum;
+    }
+    for (; carry && i < n; i++) {
+        carry = r[i] == BIGNUM_BASE - 1;
+        r[i] = carry ? 0 : r[i] + 1;
+    }
+}
+
+// r[0 .. n) -= a[0 .. m), m <= n and r must not drop below zero
+static void subtract_from(uint32_t *r, size_t n, const uint32_t *a, size_t m) {
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i < m; i++) {
+        uint32_t subtrahend = a[i] + borrow;
+        borrow = r[i] < subtrahend;
+        r[i] = borrow ? r[i] + BIGNUM_BASE - subtrahend : r[i] - subtrahend;
+    }
+    for (; borrow && i < n; i++) {
+        borrow = r[i] == 0;
+        r[i] = borrow ? BIGNUM_BASE - 1 : r[i] - 1;
+    }
+}
+
+// Arena limbs mul_karatsuba needs for n-limb operands, only the middle product's chain stays live
+static size_t karatsuba_scratch(size_t n) {
+    size_t total = 0;
+    while (n >= KARATSUBA_CUTOFF) {
+        size_t high = n - n / 2;
+        total += 4 * (high + 1);
+        n = high + 1;
+    }
+    return total;
+}
+
+// r[0 .. 2n) = a * b for two n-limb operands
+static void mul_karatsuba(uint32_t *r, const uint32_t *a, const uint32_t *b, size_t n, uint32_t *scratch) {
+    if (n < KARATSUBA_CUTOFF) {
+        mul_schoolbook(r, a, n, b, n);
+        return;
+    }
+
+    // a = a1 * B^low + a0, the outer products land straight in r
+    size_t low = n / 2, high = n - low;
+    mul_karatsuba(r, a, b, low, scratch);
+    mul_karatsuba(r + 2 * low, a + low, b + low, high, scratch);
+
+    uint32_t *sum_a = scratch;
+    uint32_t *sum_b = sum_a + high + 1;
+    uint32_t *middle = sum_b + high + 1;
+    size_t middle_length = 2 * (high + 1);
+    add_limbs(sum_a, a + low, high, a, low);
+    add_limbs(sum_b, b + low, high, b, low);
+    mul_karatsuba(middle, sum_a, sum_b, high + 1, middle + middle_length);
+
+    // (a0 + a1)(b0 + b1) - a0 b0 - a1 b1 = a0 b1 + a1 b0, which is below 2 B^n
+    subtract_from(middle, middle_length, r, 2 * low);
+    subtract_from(middle, middle_length, r + 2 * low, 2 * high);
+    while (middle_length > 0 && middle[middle_length - 1] == 0) middle_length--;
+    add_into(r + low, 2 * n - low, middle, middle_length);
+}
+
+// r[0 .. na + nb) = a * b for na >= nb, the longer operand is cut into nb-limb chunks
+static void mul_karatsuba_unbalanced(uint32_t *r, const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+    uint32_t *scratch) {
+    if (nb < KARATSUBA_CUTOFF) {
+        mul_schoolbook(r, a, na, b, nb);
+        return;
+    }
+    if (na == nb) {
+        mul_karatsuba(r, a, b, nb, scratch);
+        return;
+    }
+
+    uint32_t *piece = scratch;
+    uint32_t *product = piece + nb;
+    uint32_t *rest = product + 2 * nb;
+    memset(r, 0, (na + nb) * sizeof(uint32_t));
+
+    for (size_t offset = 0; offset < na; offset += nb) {
+        size_t length = na - offset < nb ? na - offset : nb;
+        const uint32_t *chunk = a + offset;
+        if (length < nb) {
+            // Zero pad the short tail so every chunk takes the balanced path
+            memcpy(piece, chunk, length * sizeof(uint32_t));
+            memset(piece + length, 0, (nb - length) * sizeof(uint32_t));
+            chunk = piece;
+        }
+        mul_karatsuba(product, chunk, b, nb, rest);
+        add_into(r + offset, na + nb - offset, product, length + nb);
+    }
+}
+
+/*
+    Number-theoretic transform modulo three primes below 2^30, each 3 generates its group.
+    A coefficient of the limb convolution is below min(na, nb) * 10^18, under the product of the
+    primes for every length the transforms support, so the CRT recovers it exactly.
+ */
+static const uint32_t ntt_primes[3] = {
+    998244353u,   // 119 * 2^23 + 1
+    167772161u,   // 5 * 2^25 + 1
+    469762049u,   // 7 * 2^26 + 1
+};
+
+// The smallest power of two dividing p - 1 across the primes bounds the transform length
+#define NTT_MAX_LENGTH ((size_t)1 << 23)
+
+// Montgomery arithmetic with R = 2^32, values stay below mod
+typedef struct {
+    uint32_t mod;
+    uint32_t negated_inverse;   // -mod^-1 mod 2^32
+    uint32_t one;               // R mod mod
+    uint32_t r_squared;         // R^2 mod mod
+} montgomery_t;
+
+static montgomery_t montgomery_for(uint32_t mod) {
+    uint32_t inverse = mod;
+    for (int i = 0; i < 5; i++) inverse *= 2 - mod * inverse;
+
+    uint64_t r = ((uint64_t)1 << 32) % mod;
+    return (montgomery_t){ mod, 0 - inverse, (uint32_t)r, (uint32_t)(r * r % mod) };
+}
+
+static inline uint32_t montgomery_reduce(const montgomery_t *m, uint64_t t) {
+    uint32_t factor = (uint32_t)t * m->negated_inverse;
+    uint32_t reduced = (uint32_t)((t + (uint64_t)factor * m->mod) >> 32);
+    return reduced >= m->mod ? reduced - m->mod : reduced;
+}
+
+static inline uint32_t montgomery_mul(const montgomery_t *m, uint32_t a, uint32_t b) {
+    return montgomery_reduce(m, (uint64_t)a * b);
+}
+
+static inline uint32_t montgomery_from(const montgomery_t *m, uint32_t value) {
+    return montgomery_mul(m, value % m->mod, m->r_squared);
+}
+
+static uint32_t montgomery_pow(const montgomery_t *m, uint32_t base, uint64_t exponent) {
+    uint32_t result = m->one;
+    for (; exponent; exponent >>= 1) {
+        if (exponent & 1) result = montgomery_mul(m, result, base);
+        base = montgomery_mul(m, base, base);
+    }
+    return result;
+}
+
+// In-place iterative transform of n (a power of two) values in Montgomery form
+static void ntt(uint32_t *values, size_t n, const montgomery_t *m, bool inverse, uint32_t *twiddles) {
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            uint32_t swap = values[i];
+            values[i] = values[j];
+            values[j] = swap;
+        }
+    }
+
+    uint32_t mod = m->mod;
+    uint32_t generator = montgomery_from(m, 3);
+    for (size_t length = 2; length <= n; length <<= 1) {
+        uint32_t step = montgomery_pow(m, generator, (mod - 1) / length);
+        if (inverse) step = montgomery_pow(m, step, mod - 2);
+
+        size_t half = length / 2;
+        twiddles[0] = m->one;
+        for (size_t j = 1; j < half; j++) twiddles[j] = montgomery_mul(m, twiddles[j - 1], step);
+
+        for (size_t i = 0; i < n; i += length) {
+            uint32_t *lower = values + i, *upper = values + i + half;
+            for (size_t j = 0; j < half; j++) {
+                uint32_t u = lower[j], v = montgomery_mul(m, upper[j], twiddles[j]);
+                uint32_t sum = u + v;
+                lower[j] = sum >= mod ? sum - mod : sum;
+                upper[j] = u >= v ? u - v : u + mod - v;
+            }
+        }
+    }
+
+    if (inverse) {
+        uint32_t scale = montgomery_pow(m, montgomery_from(m, (uint32_t)(n % mod)), mod - 2);
+        for (size_t i = 0; i < n; i++) values[i] = montgomery_mul(m, values[i], scale);
+    }
+}
+
+static uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t mod) {
+    uint64_t result = 1;
+    base %= mod;
+    for (; exponent; exponent >>= 1) {
+        if (exponent & 1) result = result * base % mod;
+        base = base * base % mod;
+    }
+    return result;
+}
+
+// Arena limbs mul_ntt needs for a transform of the given length
+static size_t ntt_scratch(size_t length) {
+    return 4 * length + length / 2;
+}
+
+// r[0 .. na + nb) = a * b, length is a power of two of at least na + nb
+static void mul_ntt(uint32_t *r, const uint32_t *a, size_t na, const uint32_t *b, size_t nb, size_t length,
+    uint32_t *scratch) {
+    uint32_t *residues[3] = { scratch, scratch + length, scratch + 2 * length };
+    uint32_t *other = scratch + 3 * length;
+    uint32_t *twiddles = other + length;
+
+    for (int k = 0; k < 3; k++) {
+        montgomery_t m = montgomery_for(ntt_primes[k]);
+        uint32_t *values = residues[k];
+
+        for (size_t i = 0; i < length; i++) values[i] = i < na ? montgomery_from(&m, a[i]) : 0;
+        for (size_t i = 0; i < length; i++) other[i] = i < nb ? montgomery_from(&m, b[i]) : 0;
+        ntt(values, length, &m, false, twiddles);
+        ntt(other, length, &m, false, twiddles);
+
+        for (size_t i = 0; i < length; i++) values[i] = montgomery_mul(&m, values[i], other[i]);
+        ntt(values, length, &m, true, twiddles);
+        for (size_t i = 0; i < length; i++) values[i] = montgomery_reduce(&m, values[i]);
+    }
+
+    // Garner's CRT rebuilds each coefficient, the carry then folds it back into base 10^9 limbs
+    uint64_t p0 = ntt_primes[0], p1 = ntt_primes[1], p2 = ntt_primes[2];
+    uint64_t inverse_p0 = pow_mod(p0, p1 - 2, p1);
+    uint64_t inverse_p0_p1 = pow_mod(p0 * p1 % p2, p2 - 2, p2);
+
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < na + nb; i++) {
+        uint64_t x0 = residues[0][i];
+        uint64_t t1 = (residues[1][i] + p1 - x0 % p1) % p1 * inverse_p0 % p1;
+        uint64_t x1 = x0 + t1 * p0;
+        uint64_t t2 = (residues[2][i] + p2 - x1 % p2) % p2 * inverse_p0_p1 % p2;
+
+        carry += x1 + (unsigned __int128)t2 * (p0 * p1);
+        r[i] = (uint32_t)(carry % BIGNUM_BASE);
+        carry /= BIGNUM_BASE;
+    }
+}
+
+bool bignum_mul(bignum_t *result, const bignum_t *a, const bignum_t *b) {
+    return bignum_mul_using(result, a, b, BIGNUM_MUL_AUTO);
+}
+
+bool bignum_mul_using(bignum_t *result, const bignum_t *a, const bignum_t *b, bignum_mul_method_t method) {
+    if (a->length == 0 || b->length == 0) {
+        bignum_set_zero(result);
+        return true;
+    }
+
+    const bignum_t *longer = a->length >= b->length ? a : b;
+    const bignum_t *shorter = longer == a ? b : a;
+    size_t na = longer->length, nb = shorter->length, total = na + nb;
+    if (total > (size_t)INT32_MAX / 2) return false;
+
+    if (method == BIGNUM_MUL_AUTO) {
+        method = nb < BIGNUM_KARATSUBA_THRESHOLD ? BIGNUM_MUL_SCHOOLBOOK :
+                 nb < BIGNUM_NTT_THRESHOLD ? BIGNUM_MUL_KARATSUBA : BIGNUM_MUL_NTT;
+    }
+
+    size_t transform = 1;
+    while (transform < total) transform <<= 1;
+    if (method == BIGNUM_MUL_NTT && transform > NTT_MAX_LENGTH) method = BIGNUM_MUL_KARATSUBA;
+
+    size_t arena_limbs = total;
+    if (method == BIGNUM_MUL_KARATSUBA) arena_limbs += 3 * nb + karatsuba_scratch(nb);
+    if (method == BIGNUM_MUL_NTT) arena_limbs += ntt_scratch(transform);
+
+    uint32_t *arena = malloc(arena_limbs * sizeof(uint32_t));
+    if (!arena) {
+        fprintf(stderr, "Failed to allocate memory for bignum multiplication\n");
+        return false;
+    }
+    uint32_t *product = arena, *scratch = arena + total;
+
+    switch (method) {
+    case BIGNUM_MUL_NTT:
+        mul_ntt(product, longer->limbs, na, shorter->limbs, nb, transform, scratch);
+        break;
+    case BIGNUM_MUL_KARATSUBA:
+        mul_karatsuba_unbalanced(product, longer->limbs, na, shorter->limbs, nb, scratch);
+        break;
+    default:
+        mul_schoolbook(product, longer->limbs, na, shorter->limbs, nb);
+        break;
+    }
+
+    // Operands are no longer read, so the result can take over either one's storage
+    bool negative = a->negative != b->negative;
+    if (!reserve(result, (int)total)) {
+        free(arena);
+        return false;
+    }
+    memcpy(result->limbs, product, total * sizeof(uint32_t));
+    result->length = (int)total;
+    result->negative = negative;
+    trim(result);
+
+    free(arena);
+    return true;
+}
+
+/*
+    Knuth's algorithm D (TAOCP 4.3.1) in base 10^9, one quotient limb per step from a
+    two-limb estimate that is at most one too large after the correction loop
+    b has at least two limbs and |a| >= |b|
+ */
+static bool divide_long(bignum_t *quotient, bignum_t *remainder, const bignum_t *a, const bignum_t *b) {
+    int n = b->length, m = a->length - b->length;
+    bignum_t u, v;
+    bignum_init(&u);
+    bignum_init(&v);
+
+    // Normalize so the top divisor limb is at least half the base, the remainder is scaled back at the end
+    uint32_t scale = BIGNUM_BASE / (b->limbs[n - 1] + 1);
+    bool ok = bignum_copy(&u, a) && bignum_copy(&v, b) &&
+              bignum_mul_small(&u, scale, 0) && bignum_mul_small(&v, scale, 0) &&
+              reserve(&u, a->length + 1) && reserve(quotient, m + 1);
+    if (!ok) goto cleanup;
+
+    for (int i = u.length; i <= a->length; i++) u.limbs[i] = 0;
+
+    uint32_t *un = u.limbs;
+    const uint32_t *vn = v.limbs;
+    uint64_t top_divisor = vn[n - 1], next_divisor = vn[n - 2];
+
+    for (int j = m; j >= 0; j--) {
+        uint64_t numerator = (uint64_t)un[j + n] * BIGNUM_BASE + un[j + n - 1];
+        uint64_t estimate = numerator / top_divisor;
+        uint64_t rest = numerator % top_divisor;
+
+        while (estimate >= BIGNUM_BASE || estimate * next_divisor > rest * BIGNUM_BASE + un[j + n - 2]) {
+            estimate--;
+            rest += top_divisor;
+            if (rest >= BIGNUM_BASE) break;
+        }
+
+        // un[j .. j + n] -= estimate * vn
+        uint64_t carry = 0;
+        int64_t borrow = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t product = estimate * vn[i] + carry;
+            carry = product / BIGNUM_BASE;
+            int64_t difference = (int64_t)un[i + j] - (int64_t)(product % BIGNUM_BASE) - borrow;
+            borrow = difference < 0;
+            un[i + j] = (uint32_t)(borrow ? difference + BIGNUM_BASE : difference);
+        }
+        int64_t top = (int64_t)un[j + n] - (int64_t)carry - borrow;
+
+        if (top < 0) {
+            // Rare: the estimate was still one too large, add the divisor back
+            estimate--;
+            uint32_t add_carry = 0;
+            for (int i = 0; i < n; i++) {
+                uint32_t sum = un[i + j] + vn[i] + add_carry;
+                add_carry = sum >= BIGNUM_BASE;
+                un[i + j] = add_carry ? sum - BIGNUM_BASE : sum;
+            }
+            top += add_carry;
+        }
+        un[j + n] = (uint32_t)top;
+        quotient->limbs[j] = (uint32_t)estimate;
+    }
+
+    quotient->length = m + 1;
+    quotient->negative = false;
+    trim(quotient);
+
+    if (remainder) {
+        u.length = n;
+        u.negative = false;
+        trim(&u);
+        bignum_divmod_small(&u, scale);
+        ok = bignum_copy(remainder, &u);
+    }
+
+cleanup:
+    bignum_free(&u);
+    bignum_free(&v);
+    return ok;
+}
+
+bool bignum_divmod(bignum_t *quotient, bignum_t *remainder, const bignum_t *a, const bignum_t *b) {
+    if (b->length == 0) return false;
+
+    if (compare_magnitudes(a, b) < 0) {
+        if (remainder && !bignum_copy(remainder, a)) return false;
+        if (remainder) remainder->negative = false;
+        bignum_set_zero(quotient);
+        return true;
+    }
+
+    if (b->length == 1) {
+        uint32_t divisor = b->limbs[0];
+        if (!bignum_copy(quotient, a)) return false;
+        quotient->negative = false;
+        uint32_t rest = bignum_divmod_small(quotient, divisor);
+        return !remainder || bignum_set_int64(remainder, rest);
+    }
+
+    return divide_long(quotient, remainder, a, b);
+}
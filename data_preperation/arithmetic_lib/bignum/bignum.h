@@ -0,0 +1,102 @@
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BIGNUM_BASE 1000000000u
+#define BIGNUM_BASE_DIGITS 9
+
+/*
+    Arbitrary precision signed integer stored as base 10^9 limbs, least significant first.
+    Decimal text is only parsed and formatted at the edges, arithmetic runs on the limbs.
+    Every function returning bool fails only on allocation failure or invalid input.
+ */
+typedef struct {
+    uint32_t *limbs;
+    int length;      // Limbs in use, 0 for zero
+    int capacity;
+    bool negative;   // Never set for zero
+} bignum_t;
+
+void bignum_init(bignum_t *n);
+void bignum_free(bignum_t *n);
+
+static inline bool bignum_is_zero(const bignum_t *n) {
+    return n->length == 0;
+}
+
+void bignum_set_zero(bignum_t *n);
+bool bignum_set_int64(bignum_t *n, int64_t value);
+bool bignum_copy(bignum_t *dest, const bignum_t *src);
+
+/*
+    Parse an integer: surrounding spaces, an optional sign and digits, empty text is zero
+    @param str: characters to parse, need not be NUL-terminated
+    @return false when the text is not a plain integer
+ */
+bool bignum_parse(bignum_t *n, const char *str, size_t len);
+
+/*
+    Format as decimal text
+    @return characters written excluding the NUL, -1 when size is too small
+ */
+int bignum_to_string(const bignum_t *n, char *out, size_t size);
+
+// -1, 0 or 1 as a is less than, equal to or greater than b
+int bignum_compare(const bignum_t *a, const bignum_t *b);
+
+// result = a + b and result = a - b, result may alias either operand
+bool bignum_add(bignum_t *result, const bignum_t *a, const bignum_t *b);
+bool bignum_sub(bignum_t *result, const bignum_t *a, const bignum_t *b);
+
+// n += value, scratch holds the converted value
+bool bignum_add_int128(bignum_t *n, __int128 value, bignum_t *scratch);
+
+// |n| = |n| * factor + addend
+bool bignum_mul_small(bignum_t *n, uint32_t factor, uint32_t addend);
+
+// |n| = |n| * 10^exponent
+bool bignum_mul_pow10(bignum_t *n, int exponent);
+
+// |n| = |n| * 10^len + digits, digits must all be '0'-'9'
+bool bignum_append_digits(bignum_t *n, const char *digits, size_t len);
+
+// Decimal digits in |n|, 0 for zero
+int bignum_digits(const bignum_t *n);
+
+// |n| /= divisor in place, divisor must be non-zero, returns the remainder
+uint32_t bignum_divmod_small(bignum_t *n, uint32_t divisor);
+
+// Multiplication kernels, picked from the shorter operand's limb count unless forced
+typedef enum {
+    BIGNUM_MUL_AUTO,
+    BIGNUM_MUL_SCHOOLBOOK,
+    BIGNUM_MUL_KARATSUBA,
+    BIGNUM_MUL_NTT        // Three-prime number-theoretic transform, falls back past its largest length
+} bignum_mul_method_t;
+
+// Limb counts where each kernel starts winning, measured with the multiply benchmark
+#ifndef BIGNUM_KARATSUBA_THRESHOLD
+#define BIGNUM_KARATSUBA_THRESHOLD 48
+#endif
+#ifndef BIGNUM_NTT_THRESHOLD
+#define BIGNUM_NTT_THRESHOLD 1280
+#endif
+
+/*
+    result = a * b, result may alias either operand
+    Temporaries come from one heap arena per call, recursion depth is logarithmic
+ */
+bool bignum_mul(bignum_t *result, const bignum_t *a, const bignum_t *b);
+bool bignum_mul_using(bignum_t *result, const bignum_t *a, const bignum_t *b, bignum_mul_method_t method);
+
+/*
+    Truncating division of magnitudes by Knuth's algorithm D, signs are ignored and left to the caller
+    @param remainder: may be NULL
+    @return false on a zero divisor or allocation failure
+ */
+bool bignum_divmod(bignum_t *quotient, bignum_t *remainder, const bignum_t *a, const bignum_t *b);
+
+#endif // BIGNUM_H
@@ -0,0 +1,256 @@
+#include "columnar.h"
+#include "../fat_data/fat_data.h"
+#include "../thread_pool/thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define INITIAL_COLUMN_BYTES 256
+#define INITIAL_COLUMN_VALUES 32
+
+// Values a transpose task moves, whole blocks so the class pass never splits one
+#define TRANSPOSE_BLOCK_VALUES (16 * COLUMNAR_BLOCK_VALUES)
+
+bool columnar_builder_init(columnar_builder_t *builder, int num_columns) {
+    builder->columns = calloc(num_columns, sizeof(column_builder_t));
+    builder->num_columns = builder->columns ? num_columns : 0;
+    if (!builder->columns) fprintf(stderr, "Failed to allocate column builders\n");
+    return builder->columns != NULL;
+}
+
+bool columnar_builder_append(columnar_builder_t *builder, int column, const char *value, size_t length) {
+    column_builder_t *col = &builder->columns[column];
+
+    if (col->size + length + 1 > col->capacity) {
+        size_t new_capacity = col->capacity ? col->capacity : INITIAL_COLUMN_BYTES;
+        while (new_capacity < col->size + length + 1) {
+            if (new_capacity > SIZE_MAX / 2) return false;
+            new_capacity *= 2;
+        }
+
+        char *new_bytes = realloc(col->bytes, new_capacity);
+        if (!new_bytes) return false;
+        col->bytes = new_bytes;
+        col->capacity = new_capacity;
+    }
+
+    if (col->num_values == col->offsets_capacity) {
+        if (col->offsets_capacity > INT32_MAX / 2) return false;
+        int new_capacity = col->offsets_capacity ? col->offsets_capacity * 2 : INITIAL_COLUMN_VALUES;
+
+        size_t *new_offsets = realloc(col->offsets, new_capacity * sizeof(size_t));
+        if (!new_offsets) return false;
+        col->offsets = new_offsets;
+
+        int64_t *new_ints = realloc(col->ints, new_capacity * sizeof(int64_t));
+        if (!new_ints) return false;
+        col->ints = new_ints;
+
+        unsigned char *new_classes = realloc(col->classes, new_capacity);
+        if (!new_classes) return false;
+        col->classes = new_classes;
+
+        col->offsets_capacity = new_capacity;
+    }
+
+    int64_t parsed = 0;
+    col->classes[col->num_values] = (unsigned char)classify_number(value, length, &parsed);
+    col->ints[col->num_values] = parsed;
+    col->offsets[col->num_values++] = col->size;
+    memcpy(col->bytes + col->size, value, length);
+    col->bytes[col->size + length] = '\0';
+    col->size += length + 1;
+
+    return true;
+}
+
+void columnar_builder_free(columnar_builder_t *builder) {
+    if (!builder || !builder->columns) return;
+    for (int c = 0; c < builder->num_columns; c++) {
+        free(builder->columns[c].bytes);
+        free(builder->columns[c].offsets);
+        free(builder->columns[c].ints);
+        free(builder->columns[c].classes);
+    }
+    free(builder->columns);
+    builder->columns = NULL;
+    builder->num_columns = 0;
+}
+
+// Release a band's column once it was copied, keeps the peak near one copy of the subregion
+static void release_column(column_builder_t *col) {
+    free(col->bytes);
+    free(col->offsets);
+    free(col->ints);
+    free(col->classes);
+    *col = (column_builder_t){0};
+}
+
+bool columnar_from_builders(columnar_builder_t *builders, int num_builders,
+    int num_rows, int num_columns, columnar_subregion_t *region) {
+
+    memset(region, 0, sizeof(*region));
+
+    size_t total_bytes = 0;
+    for (int b = 0; b < num_builders; b++) {
+        for (int c = 0; c < builders[b].num_columns; c++) total_bytes += builders[b].columns[c].size;
+    }
+
+    size_t num_values = (size_t)num_rows * num_columns;
+    region->bytes = malloc(total_bytes ? total_bytes : 1);
+    region->offsets = malloc(num_values * sizeof(size_t));
+    region->ints = malloc(num_values * sizeof(int64_t));
+    unsigned char *classes = malloc(num_values ? num_values : 1);
+    if (!region->bytes || !region->offsets || !region->ints || !classes) {
+        fprintf(stderr, "Failed to allocate columnar subregion\n");
+        free(classes);
+        free_columnar_subregion(region);
+        return false;
+    }
+
+    region->num_rows = num_rows;
+    region->num_columns = num_columns;
+
+    // Lay each column's bands out one after another
+    size_t position = 0;
+    for (int c = 0; c < num_columns; c++) {
+        size_t index = (size_t)c * num_rows;
+
+        for (int b = 0; b < num_builders; b++) {
+            if (c >= builders[b].num_columns) continue;
+            column_builder_t *col = &builders[b].columns[c];
+
+            if (index + col->num_values > (size_t)(c + 1) * num_rows) {
+                fprintf(stderr, "Column %d holds more values than the subregion has rows\n", c);
+                free(classes);
+                free_columnar_subregion(region);
+                return false;
+            }
+
+            if (col->size) memcpy(region->bytes + position, col->bytes, col->size);
+            if (col->num_values) {
+                memcpy(region->ints + index, col->ints, col->num_values * sizeof(int64_t));
+                memcpy(classes + index, col->classes, col->num_values);
+            }
+            for (int v = 0; v < col->num_values; v++) region->offsets[index++] = position + col->offsets[v];
+            position += col->size;
+            release_column(col);
+        }
+
+        if (index != (size_t)(c + 1) * num_rows) {
+            fprintf(stderr, "Column %d is missing values\n", c);
+            free(classes);
+            free_columnar_subregion(region);
+            return false;
+        }
+    }
+    region->bytes_size = position;
+
+    bool tagged = columnar_tag_blocks(region, classes);
+    free(classes);
+    if (!tagged) free_columnar_subregion(region);
+
+    return tagged;
+}
+
+bool columnar_tag_blocks(columnar_subregion_t *region, const unsigned char *classes) {
+    size_t num_values = (size_t)region->num_rows * region->num_columns;
+    size_t num_blocks = columnar_num_blocks(region);
+
+    // A region refilled in place keeps the classes it was allocated with
+    if (!region->block_classes) region->block_classes = malloc(num_blocks ? num_blocks : 1);
+    if (!region->block_classes) {
+        fprintf(stderr, "Failed to allocate columnar block classes\n");
+        return false;
+    }
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        size_t end = (b + 1) * COLUMNAR_BLOCK_VALUES < num_values ? (b + 1) * COLUMNAR_BLOCK_VALUES : num_values;
+        unsigned char widest = NUMBER_INT64;
+        for (size_t i = b * COLUMNAR_BLOCK_VALUES; i < end; i++) {
+            if (classes[i] > widest) widest = classes[i];
+        }
+        region->block_classes[b] = widest;
+    }
+
+    return true;
+}
+
+typedef struct {
+    const columnar_subregion_t *source;
+    columnar_subregion_t *transposed;
+} transpose_job_t;
+
+// Source rows [begin, end): read each column's stretch of them in order, write the rows contiguously
+static bool transpose_rows(void *args, size_t begin, size_t end, int worker) {
+    const transpose_job_t *job = (const transpose_job_t *)args;
+    const columnar_subregion_t *source = job->source;
+    columnar_subregion_t *transposed = job->transposed;
+    size_t num_rows = (size_t)source->num_rows, num_columns = (size_t)source->num_columns;
+
+    for (size_t c = 0; c < num_columns; c++) {
+        for (size_t r = begin; r < end; r++) {
+            transposed->offsets[r * num_columns + c] = source->offsets[c * num_rows + r];
+            transposed->ints[r * num_columns + c] = source->ints[c * num_rows + r];
+        }
+    }
+    return true;
+}
+
+// Transposed values [begin, end), whole blocks, each tagged with the widest class its values came from
+static bool transpose_classes(void *args, size_t begin, size_t end, int worker) {
+    const transpose_job_t *job = (const transpose_job_t *)args;
+    const columnar_subregion_t *source = job->source;
+    size_t num_rows = (size_t)source->num_rows, num_columns = (size_t)source->num_columns;
+
+    for (size_t b = begin / COLUMNAR_BLOCK_VALUES; b * COLUMNAR_BLOCK_VALUES < end; b++) {
+        size_t block_end = (b + 1) * COLUMNAR_BLOCK_VALUES < end ? (b + 1) * COLUMNAR_BLOCK_VALUES : end;
+        unsigned char widest = NUMBER_INT64;
+        for (size_t i = b * COLUMNAR_BLOCK_VALUES; i < block_end; i++) {
+            size_t index = (i % num_columns) * num_rows + i / num_columns;
+            unsigned char source_class = source->block_classes[index / COLUMNAR_BLOCK_VALUES];
+            if (source_class > widest) widest = source_class;
+        }
+        job->transposed->block_classes[b] = widest;
+    }
+    return true;
+}
+
+bool columnar_transpose(const columnar_subregion_t *region, columnar_subregion_t *transposed, int thread_count) {
+    memset(transposed, 0, sizeof(*transposed));
+    size_t num_values = (size_t)region->num_rows * region->num_columns;
+
+    transposed->bytes = region->bytes;
+    transposed->bytes_size = region->bytes_size;
+    transposed->borrowed_bytes = true;
+    transposed->num_rows = region->num_columns;
+    transposed->num_columns = region->num_rows;
+    transposed->offsets = malloc((num_values ? num_values : 1) * sizeof(size_t));
+    transposed->ints = malloc((num_values ? num_values : 1) * sizeof(int64_t));
+    transposed->block_classes = malloc(columnar_num_blocks(transposed) ? columnar_num_blocks(transposed) : 1);
+    if (!transposed->offsets || !transposed->ints || !transposed->block_classes) {
+        fprintf(stderr, "Failed to allocate transposed subregion\n");
+        free_columnar_subregion(transposed);
+        return false;
+    }
+
+    // Bands of rows sized so a task moves about a block's worth of values
+    size_t rows_per_task = TRANSPOSE_BLOCK_VALUES / (region->num_columns ? region->num_columns : 1);
+    transpose_job_t job = { region, transposed };
+    if (!thread_pool_for(region->num_rows, rows_per_task ? rows_per_task : 1, thread_count, transpose_rows, &job) ||
+        !thread_pool_for(num_values, TRANSPOSE_BLOCK_VALUES, thread_count, transpose_classes, &job)) {
+        free_columnar_subregion(transposed);
+        return false;
+    }
+    return true;
+}
+
+void free_columnar_subregion(columnar_subregion_t *region) {
+    if (!region) return;
+    if (!region->borrowed_bytes) free(region->bytes);
+    free(region->offsets);
+    free(region->ints);
+    free(region->block_classes);
+    memset(region, 0, sizeof(*region));
+}
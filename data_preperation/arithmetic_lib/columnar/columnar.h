@@ -0,0 +1,97 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Column-major values sharing one number class tag
+#define COLUMNAR_BLOCK_VALUES 1024
+
+/*
+    Subregion stored column-major: every column's values sit back to back in one
+    contiguous arena, NUL-terminated, and the arenas of the columns follow each other.
+    Value i (column-major) starts at bytes + offsets[i], so a range of indeces walks
+    forward through both arrays.
+ */
+typedef struct {
+    char *bytes;
+    size_t bytes_size;
+    size_t *offsets;      // num_rows * num_columns entries
+    int64_t *ints;        // Native copies of the values, only meaningful inside NUMBER_INT64 blocks
+    unsigned char *block_classes; // Widest number_class_t of each COLUMNAR_BLOCK_VALUES indeces
+    int num_rows;         // Values per column
+    int num_columns;
+    bool borrowed_bytes;  // bytes belong to a mapping, offsets, ints and classes are still owned
+} columnar_subregion_t;
+
+// Value at a column-major index
+static inline const char *columnar_value(const columnar_subregion_t *region, size_t index) {
+    return region->bytes + region->offsets[index];
+}
+
+static inline const char *columnar_cell(const columnar_subregion_t *region, int row, int column) {
+    return columnar_value(region, (size_t)column * region->num_rows + row);
+}
+
+static inline size_t columnar_num_blocks(const columnar_subregion_t *region) {
+    size_t values = (size_t)region->num_rows * region->num_columns;
+    return (values + COLUMNAR_BLOCK_VALUES - 1) / COLUMNAR_BLOCK_VALUES;
+}
+
+// One growable arena and its offsets, a column of a band of rows, values are classified as they arrive
+typedef struct {
+    char *bytes;
+    size_t size;
+    size_t capacity;
+    size_t *offsets;
+    int64_t *ints;          // Parsed value of each NUMBER_INT64 value
+    unsigned char *classes; // number_class_t of each value
+    int num_values;
+    int offsets_capacity;
+} column_builder_t;
+
+// Staging for a band of consecutive rows, filled by one thread
+typedef struct {
+    column_builder_t *columns;
+    int num_columns;
+} columnar_builder_t;
+
+bool columnar_builder_init(columnar_builder_t *builder, int num_columns);
+
+/*
+    @param value: characters of the value, need not be NUL-terminated
+    @return false on allocation failure
+ */
+bool columnar_builder_append(columnar_builder_t *builder, int column, const char *value, size_t length);
+
+void columnar_builder_free(columnar_builder_t *builder);
+
+/*
+    Concatenate row bands into one subregion, builders are given in row order and their
+    columns are released as they are copied, the builders must still be freed
+    @return false on allocation failure or when the bands don't add up to num_rows
+ */
+bool columnar_from_builders(columnar_builder_t *builders, int num_builders,
+    int num_rows, int num_columns, columnar_subregion_t *region);
+
+/*
+    Fill block_classes for a region whose values are set, a region refilled in place keeps
+    the block_classes it already has, which must cover its blocks
+    @param classes: number_class_t per column-major index, the widest of each block tags it
+    @return false on allocation failure
+ */
+bool columnar_tag_blocks(columnar_subregion_t *region, const unsigned char *classes);
+
+/*
+    View of region with rows and columns swapped, so each row's values sit back to back.
+    The bytes are borrowed from region, which must outlive the view; offsets and ints are
+    copied on the thread pool, each worker filling the rows of a contiguous band.
+    A block is tagged with the widest class of the blocks its values came from.
+    @return false on allocation failure
+ */
+bool columnar_transpose(const columnar_subregion_t *region, columnar_subregion_t *transposed, int thread_count);
+
+void free_columnar_subregion(columnar_subregion_t *region);
+
+#endif // COLUMNAR_H
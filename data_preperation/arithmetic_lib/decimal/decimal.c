@@ -0,0 +1,222 @@
+#include "decimal.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+void decimal_init(decimal_t *d) {
+    bignum_init(&d->mantissa);
+    d->scale = 0;
+}
+
+void decimal_free(decimal_t *d) {
+    if (!d) return;
+    bignum_free(&d->mantissa);
+    d->scale = 0;
+}
+
+void decimal_set_zero(decimal_t *d) {
+    bignum_set_zero(&d->mantissa);
+    d->scale = 0;
+}
+
+static inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool decimal_parse(decimal_t *d, const char *str, size_t len) {
+    const char *end = str + len;
+    while (str < end && isspace((unsigned char)*str)) str++;
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+
+    decimal_set_zero(d);
+    if (str == end) return true;
+
+    bool negative = false;
+    if (*str == '+' || *str == '-') {
+        negative = *str == '-';
+        str++;
+    }
+
+    const char *integer = str;
+    while (str < end && is_digit(*str)) str++;
+    const char *integer_end = str;
+
+    const char *fraction = str, *fraction_end = str;
+    if (str < end && *str == '.') {
+        fraction = ++str;
+        while (str < end && is_digit(*str)) str++;
+        fraction_end = str;
+    }
+    if (integer == integer_end && fraction == fraction_end) return false;
+
+    long exponent = 0;
+    if (str < end && (*str == 'e' || *str == 'E')) {
+        str++;
+        bool exponent_negative = false;
+        if (str < end && (*str == '+' || *str == '-')) exponent_negative = *str++ == '-';
+
+        const char *exponent_start = str;
+        for (; str < end && is_digit(*str); str++) {
+            if (exponent <= DECIMAL_MAX_EXPONENT) exponent = exponent * 10 + (*str - '0');
+        }
+        if (str == exponent_start || exponent > DECIMAL_MAX_EXPONENT) return false;
+        if (exponent_negative) exponent = -exponent;
+    }
+    if (str != end) return false;
+
+    while (integer < integer_end && *integer == '0') integer++;
+    if (!bignum_append_digits(&d->mantissa, integer, integer_end - integer) ||
+        !bignum_append_digits(&d->mantissa, fraction, fraction_end - fraction)) return false;
+
+    // The exponent is folded in once here, a positive one scales the mantissa up
+    long scale = (long)(fraction_end - fraction) - exponent;
+    if (scale < 0) {
+        if (!bignum_mul_pow10(&d->mantissa, (int)-scale)) return false;
+        scale = 0;
+    }
+    d->scale = (int)scale;
+
+    while (d->scale > 0 && d->mantissa.length > 0 && d->mantissa.limbs[0] % 10 == 0) {
+        bignum_divmod_small(&d->mantissa, 10);
+        d->scale--;
+    }
+    if (bignum_is_zero(&d->mantissa)) d->scale = 0;
+    d->mantissa.negative = negative && !bignum_is_zero(&d->mantissa);
+
+    return true;
+}
+
+static inline int sign_of(const decimal_t *d) {
+    return bignum_is_zero(&d->mantissa) ? 0 : (d->mantissa.negative ? -1 : 1);
+}
+
+int decimal_compare(const decimal_t *a, const decimal_t *b, bignum_t *scratch) {
+    if (a->scale == b->scale) return bignum_compare(&a->mantissa, &b->mantissa);
+
+    int sign_a = sign_of(a), sign_b = sign_of(b);
+    if (sign_a != sign_b || sign_a == 0) return (sign_a > sign_b) - (sign_a < sign_b);
+
+    // Different counts of integer digits settle it without aligning
+    int integer_a = bignum_digits(&a->mantissa) - a->scale;
+    int integer_b = bignum_digits(&b->mantissa) - b->scale;
+    if (integer_a != integer_b) return (integer_a > integer_b ? 1 : -1) * sign_a;
+
+    const decimal_t *coarse = a->scale < b->scale ? a : b;
+    const decimal_t *fine = coarse == a ? b : a;
+    if (!bignum_copy(scratch, &coarse->mantissa) || !bignum_mul_pow10(scratch, fine->scale - coarse->scale)) {
+        fprintf(stderr, "Failed to align decimals for comparison\n");
+        return 0;
+    }
+
+    int cmp = bignum_compare(scratch, &fine->mantissa);
+    return coarse == a ? cmp : -cmp;
+}
+
+bool decimal_add(decimal_t *acc, const decimal_t *value, bignum_t *scratch) {
+    if (value->scale > acc->scale) {
+        if (!bignum_mul_pow10(&acc->mantissa, value->scale - acc->scale)) return false;
+        acc->scale = value->scale;
+    }
+    if (value->scale == acc->scale) return bignum_add(&acc->mantissa, &acc->mantissa, &value->mantissa);
+
+    return bignum_copy(scratch, &value->mantissa) &&
+           bignum_mul_pow10(scratch, acc->scale - value->scale) &&
+           bignum_add(&acc->mantissa, &acc->mantissa, scratch);
+}
+
+bool decimal_add_integer(decimal_t *acc, const bignum_t *integer, bignum_t *scratch) {
+    if (bignum_is_zero(integer)) return true;
+    if (acc->scale == 0) return bignum_add(&acc->mantissa, &acc->mantissa, integer);
+
+    return bignum_copy(scratch, integer) &&
+           bignum_mul_pow10(scratch, acc->scale) &&
+           bignum_add(&acc->mantissa, &acc->mantissa, scratch);
+}
+
+bool decimal_mul_integer(decimal_t *d, const bignum_t *factor) {
+    return bignum_mul(&d->mantissa, &d->mantissa, factor);
+}
+
+/*
+    Rearrange the digits at the start of out into [sign][integer].[fraction] in place,
+    the last fraction_digits digits become the fraction and no point is written without any.
+    The integer part keeps at least one digit, "0.25" rather than ".25"
+    @return false when the result does not fit in size
+ */
+static bool place_point(char *out, size_t size, int length, int fraction_digits, bool negative) {
+    if (length <= fraction_digits) {
+        int padding = fraction_digits - length + 1;
+        if ((size_t)length + padding + 1 > size) return false;
+        memmove(out + padding, out, length + 1);
+        memset(out, '0', padding);
+        length += padding;
+    }
+
+    int integer_length = length - fraction_digits;
+    int sign = negative ? 1 : 0;
+    int point = fraction_digits > 0 ? 1 : 0;
+
+    size_t total = (size_t)sign + length + point;
+    if (total + 1 > size) return false;
+
+    // Right to left so nothing is overwritten before it moves
+    memmove(out + sign + integer_length + point, out + integer_length, fraction_digits);
+    memmove(out + sign, out, integer_length);
+    if (point) out[sign + integer_length] = '.';
+    if (negative) out[0] = '-';
+    out[total] = '\0';
+
+    return true;
+}
+
+bool decimal_to_string(const decimal_t *d, char *out, size_t size) {
+    bool negative = d->mantissa.negative;
+    bignum_t magnitude = d->mantissa;
+    magnitude.negative = false;
+
+    int length = bignum_to_string(&magnitude, out, size);
+    if (length < 0) return false;
+    if (d->scale == 0) {
+        if (!negative) return true;
+        if ((size_t)length + 2 > size) return false;
+        memmove(out + 1, out, length + 1);
+        out[0] = '-';
+        return true;
+    }
+
+    return place_point(out, size, length, d->scale, negative);
+}
+
+bool decimal_divide(const decimal_t *a, const decimal_t *b, int precision, char *out, size_t size) {
+    if (bignum_is_zero(&b->mantissa)) {
+        snprintf(out, size, "NaN");
+        return true;
+    }
+    if (bignum_is_zero(&a->mantissa)) {
+        if (size < 2) return false;
+        strcpy(out, "0");
+        return place_point(out, size, 1, precision, false);
+    }
+
+    // a / b = (ma * 10^(sb + precision)) / (mb * 10^sa), one truncating division gives every digit
+    bignum_t numerator, denominator, quotient;
+    bignum_init(&numerator);
+    bignum_init(&denominator);
+    bignum_init(&quotient);
+
+    bool ok = bignum_copy(&numerator, &a->mantissa) &&
+              bignum_mul_pow10(&numerator, b->scale + precision) &&
+              bignum_copy(&denominator, &b->mantissa) &&
+              bignum_mul_pow10(&denominator, a->scale) &&
+              bignum_divmod(&quotient, NULL, &numerator, &denominator);
+
+    int length = ok ? bignum_to_string(&quotient, out, size) : -1;
+    // Truncated to zero, such as -0.25 at precision 0, prints unsigned
+    bool negative = a->mantissa.negative != b->mantissa.negative && !bignum_is_zero(&quotient);
+    ok = length >= 0 && place_point(out, size, length, precision, negative);
+
+    bignum_free(&numerator);
+    bignum_free(&denominator);
+    bignum_free(&quotient);
+    return ok;
+}
@@ -0,0 +1,57 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../bignum/bignum.h"
+
+// Largest exponent accepted when parsing, past it a value is rejected rather than expanded
+#define DECIMAL_MAX_EXPONENT 4096
+
+/*
+    Exact fixed-point decimal: value = mantissa / 10^scale.
+    Exponents are folded into the scale when parsing, so arithmetic only has to align scales.
+    Parsed values are canonical: no trailing fraction zeros and scale 0 for zero.
+ */
+typedef struct {
+    bignum_t mantissa;
+    int scale;   // Never negative
+} decimal_t;
+
+void decimal_init(decimal_t *d);
+void decimal_free(decimal_t *d);
+void decimal_set_zero(decimal_t *d);
+
+/*
+    Parse anything is_valid_double accepts: spaces, sign, digits, one point and an exponent.
+    Spaces only or empty text is zero.
+    @return false when the text is not a number or its exponent exceeds DECIMAL_MAX_EXPONENT
+ */
+bool decimal_parse(decimal_t *d, const char *str, size_t len);
+
+// -1, 0 or 1 as a is less than, equal to or greater than b, scratch holds the aligned mantissa
+int decimal_compare(const decimal_t *a, const decimal_t *b, bignum_t *scratch);
+
+// acc += value, the scale of acc grows to the larger of the two
+bool decimal_add(decimal_t *acc, const decimal_t *value, bignum_t *scratch);
+
+// acc += integer
+bool decimal_add_integer(decimal_t *acc, const bignum_t *integer, bignum_t *scratch);
+
+// d *= factor, the scale is unchanged
+bool decimal_mul_integer(decimal_t *d, const bignum_t *factor);
+
+/*
+    Decimal text, with a point only when scale is positive
+    @return false when size is too small
+ */
+bool decimal_to_string(const decimal_t *d, char *out, size_t size);
+
+/*
+    a / b truncated after precision fraction digits, with no point at precision 0. The integer
+    part is at least "0", a result that truncates to zero has no sign, "NaN" for a zero divisor.
+    @return false on allocation failure or when size is too small
+ */
+bool decimal_divide(const decimal_t *a, const decimal_t *b, int precision, char *out, size_t size);
+
+#endif // DECIMAL_H
@@ -1,19 +1,22 @@
 #include "fat_data.h"
+#include "../bignum/bignum.h"
+#include "../decimal/decimal.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-int is_valid_double(const char *str) {
-    if (!str || !*str) return 0;
+int is_valid_double_n(const char *str, size_t len) {
+    if (!str || len == 0 || !*str) return 0;
 
+    const char *end = str + len;
     int seen_digit = 0, seen_dot = 0, seen_exp = 0;
 
-    while (isspace((unsigned char)*str)) str++;
+    while (str < end && isspace((unsigned char)*str)) str++;
 
-    if (*str == '+' || *str == '-') str++;
+    if (str < end && (*str == '+' || *str == '-')) str++;
 
-    for (; *str; str++) {
+    for (; str < end && *str; str++) {
         if (isdigit((unsigned char)*str)) {
             seen_digit = 1;
         } else if (*str == '.') {
@@ -23,7 +26,7 @@ int is_valid_double(const char *str) {
             if (seen_exp || !seen_digit) return 0;
             seen_exp = 1;
             seen_digit = 0;
-            if (*(str + 1) == '+' || *(str + 1) == '-') str++;
+            if (str + 1 < end && (*(str + 1) == '+' || *(str + 1) == '-')) str++;
         } else if (isspace((unsigned char)*str)) {
             break;
         } else {
@@ -31,12 +34,18 @@ int is_valid_double(const char *str) {
         }
     }
 
-    while (isspace((unsigned char)*str)) str++;
+    while (str < end && isspace((unsigned char)*str)) str++;
 
-    return seen_digit && *str == '\0';
+    return seen_digit && (str == end || *str == '\0');
 }
 
-int compare_big_numbers(const char *num1, const char *num2) {
+int is_valid_double(const char *str) {
+    if (!str) return 0;
+    return is_valid_double_n(str, strlen(str));
+}
+
+// Magnitudes only, leading zeros are ignored
+static int compare_magnitudes(const char *num1, const char *num2) {
     while (*num1 == '0') num1++;
     while (*num2 == '0') num2++;
 
@@ -50,6 +59,142 @@ int compare_big_numbers(const char *num1, const char *num2) {
     return 0;
 }
 
+// Digits with at most one point, leading zeros and trailing fraction zeros are ignored
+static int compare_decimal_magnitudes(const char *num1, const char *num2) {
+    while (*num1 == '0') num1++;
+    while (*num2 == '0') num2++;
+
+    size_t integer1 = strcspn(num1, "."), integer2 = strcspn(num2, ".");
+    if (integer1 != integer2) return integer1 > integer2 ? 1 : -1;
+
+    int cmp = memcmp(num1, num2, integer1);
+    if (cmp) return cmp > 0 ? 1 : -1;
+
+    num1 += integer1;
+    num2 += integer2;
+    if (*num1 == '.') num1++;
+    if (*num2 == '.') num2++;
+
+    while (*num1 || *num2) {
+        char digit1 = *num1 ? *num1++ : '0';
+        char digit2 = *num2 ? *num2++ : '0';
+        if (digit1 != digit2) return digit1 > digit2 ? 1 : -1;
+    }
+    return 0;
+}
+
+// Optional sign, then digits with at most one point
+static bool is_plain_decimal(const char *num) {
+    if (*num == '-' || *num == '+') num++;
+
+    bool seen_digit = false, seen_dot = false;
+    for (; *num; num++) {
+        if (*num >= '0' && *num <= '9') seen_digit = true;
+        else if (*num == '.' && !seen_dot) seen_dot = true;
+        else return false;
+    }
+    return seen_digit;
+}
+
+static int compare_signed(const char *num1, const char *num2, int (*compare)(const char *, const char *)) {
+    int neg1 = num1[0] == '-', neg2 = num2[0] == '-';
+    if (num1[0] == '-' || num1[0] == '+') num1++;
+    if (num2[0] == '-' || num2[0] == '+') num2++;
+
+    int cmp = compare(num1, num2);
+
+    // Zero compares equal whatever its sign
+    if (neg1 != neg2) {
+        if (cmp == 0 && strspn(num1, "0.") == strlen(num1)) return 0;
+        return neg1 ? -1 : 1;
+    }
+    return neg1 ? -cmp : cmp;
+}
+
+// Exponents and spaces need the parsed decimal_t
+static int compare_parsed(const char *num1, const char *num2) {
+    decimal_t a, b;
+    bignum_t scratch;
+    decimal_init(&a);
+    decimal_init(&b);
+    bignum_init(&scratch);
+
+    int cmp = decimal_parse(&a, num1, strlen(num1)) && decimal_parse(&b, num2, strlen(num2)) ?
+              decimal_compare(&a, &b, &scratch) : compare_signed(num1, num2, compare_magnitudes);
+
+    decimal_free(&a);
+    decimal_free(&b);
+    bignum_free(&scratch);
+    return cmp;
+}
+
+// Length of the run of digits at the start of num
+static inline size_t digit_run(const char *num) {
+    const char *end = num;
+    while (*end >= '0' && *end <= '9') end++;
+    return end - num;
+}
+
+int compare_big_numbers(const char *num1, const char *num2) {
+    const char *digits1 = num1 + (num1[0] == '-' || num1[0] == '+');
+    const char *digits2 = num2 + (num2[0] == '-' || num2[0] == '+');
+    size_t length1 = digit_run(digits1), length2 = digit_run(digits2);
+
+    // Plain integers, the common case, in one pass over each
+    if (length1 && length2 && !digits1[length1] && !digits2[length2]) {
+        int neg1 = num1[0] == '-', neg2 = num2[0] == '-';
+        size_t zeros1 = 0, zeros2 = 0;
+        while (zeros1 < length1 && digits1[zeros1] == '0') zeros1++;
+        while (zeros2 < length2 && digits2[zeros2] == '0') zeros2++;
+        length1 -= zeros1;
+        length2 -= zeros2;
+
+        if (neg1 != neg2) {
+            if (length1 == 0 && length2 == 0) return 0;
+            return neg1 ? -1 : 1;
+        }
+
+        int cmp = length1 != length2 ? (length1 > length2 ? 1 : -1) : memcmp(digits1 + zeros1, digits2 + zeros2, length1);
+        cmp = (cmp > 0) - (cmp < 0);
+        return neg1 ? -cmp : cmp;
+    }
+
+    // Plain decimals compare exactly on the text, without parsing
+    if (is_plain_decimal(num1) && is_plain_decimal(num2)) return compare_signed(num1, num2, compare_decimal_magnitudes);
+    if (is_valid_double(num1) && is_valid_double(num2)) return compare_parsed(num1, num2);
+
+    // Text keeps the integer ordering: length, then characters
+    return compare_signed(num1, num2, compare_magnitudes);
+}
+
+number_class_t classify_number(const char *str, size_t len, int64_t *value) {
+    const char *end = str + len;
+    bool negative = false;
+
+    if (str < end && (*str == '+' || *str == '-')) {
+        negative = *str == '-';
+        str++;
+    }
+    if (str == end) return NUMBER_DECIMAL;
+
+    // Accumulate negatively so INT64_MIN fits
+    int64_t accumulated = 0;
+    bool overflow = false;
+    for (; str < end; str++) {
+        if (*str < '0' || *str > '9') return NUMBER_DECIMAL;
+        if (overflow) continue;
+
+        int digit = *str - '0';
+        if (accumulated < (INT64_MIN + digit) / 10) overflow = true;
+        else accumulated = accumulated * 10 - digit;
+    }
+
+    if (overflow || (!negative && accumulated == INT64_MIN)) return NUMBER_BIGINT;
+
+    *value = negative ? accumulated : -accumulated;
+    return NUMBER_INT64;
+}
+
 int is_negative(const char *num) {
     return num[0] == '-';
 }
@@ -61,87 +206,46 @@ void strip_sign(const char *num, char *out) {
         strcpy(out, num);
 }
 
-void add_unsigned(const char *num1, const char *num2, char *result) {
-    int len1 = strlen(num1), len2 = strlen(num2);
-    int carry = 0, sum, i, j, k = 0;
-    char temp[MAX_NUMBER_LENGTH] = {0};
-
-    for (i = len1 - 1, j = len2 - 1; i >= 0 || j >= 0 || carry; i--, j--, k++) {
-        int digit1 = (i >= 0) ? num1[i] - '0' : 0;
-        int digit2 = (j >= 0) ? num2[j] - '0' : 0;
-        sum = digit1 + digit2 + carry;
-        carry = sum / 10;
-        temp[k] = (sum % 10) + '0';
-    }
-
-    for (i = 0; i < k; i++) result[i] = temp[k - i - 1];
-    result[k] = '\0';
+// Parse both operands into limbs, NaN when either is not a plain integer
+static bool parse_operands(const char *num1, const char *num2, bignum_t *a, bignum_t *b) {
+    bignum_init(a);
+    bignum_init(b);
+    return bignum_parse(a, num1, strlen(num1)) && bignum_parse(b, num2, strlen(num2));
 }
 
-void subtract_unsigned(const char *num1, const char *num2, char *result) {
-    int len1 = strlen(num1), len2 = strlen(num2);
-    int borrow = 0, diff, i, j, k = 0;
-    char temp[MAX_NUMBER_LENGTH] = {0};
-
-    for (i = len1 - 1, j = len2 - 1; i >= 0; i--, j--, k++) {
-        int digit1 = num1[i] - '0' - borrow;
-        int digit2 = (j >= 0) ? num2[j] - '0' : 0;
-        borrow = 0;
-        if (digit1 < digit2) {
-            digit1 += 10;
-            borrow = 1;
-        }
-        temp[k] = (digit1 - digit2) + '0';
+static void format_result(const bignum_t *n, char *result) {
+    if (bignum_to_string(n, result, MAX_NUMBER_LENGTH) < 0) {
+        fprintf(stderr, "Result exceeds %d digits\n", MAX_NUMBER_LENGTH - 1);
+        strcpy(result, "NaN");
     }
+}
+
+static void add_or_subtract(const char *num1, const char *num2, bool subtract, char *result) {
+    bignum_t a, b;
+    bool ok = parse_operands(num1, num2, &a, &b) &&
+              (subtract ? bignum_sub(&a, &a, &b) : bignum_add(&a, &a, &b));
+
+    if (ok) format_result(&a, result);
+    else strcpy(result, "NaN");
+
+    bignum_free(&a);
+    bignum_free(&b);
+}
 
-    while (k > 1 && temp[k - 1] == '0') k--;
+void add_unsigned(const char *num1, const char *num2, char *result) {
+    add_or_subtract(num1, num2, false, result);
+}
 
-    for (i = 0; i < k; i++) result[i] = temp[k - i - 1];
-    result[k] = '\0';
+void subtract_unsigned(const char *num1, const char *num2, char *result) {
+    add_or_subtract(num1, num2, true, result);
 }
 
 void add_big_integers(const char *num1, const char *num2, char *result) {
-    char a[MAX_NUMBER_LENGTH], b[MAX_NUMBER_LENGTH];
-    int neg1 = is_negative(num1), neg2 = is_negative(num2);
-    strip_sign(num1, a);
-    strip_sign(num2, b);
-
-    if (!neg1 && !neg2) {
-        add_unsigned(a, b, result);
-    } else if (neg1 && neg2) {
-        add_unsigned(a, b, result);
-        char tmp[MAX_NUMBER_LENGTH];
-        strcpy(tmp, result);
-        snprintf(result, MAX_NUMBER_LENGTH, "-%s", tmp);
-    } else if (neg1 && !neg2) {
-        if (compare_big_numbers(a, b) > 0) {
-            subtract_unsigned(a, b, result);
-            char tmp[MAX_NUMBER_LENGTH];
-            strcpy(tmp, result);
-            snprintf(result, MAX_NUMBER_LENGTH, "-%s", tmp);
-        } else {
-            subtract_unsigned(b, a, result);
-        }
-    } else {
-        if (compare_big_numbers(a, b) >= 0) {
-            subtract_unsigned(a, b, result);
-        } else {
-            subtract_unsigned(b, a, result);
-            char tmp[MAX_NUMBER_LENGTH];
-            strcpy(tmp, result);
-            snprintf(result, MAX_NUMBER_LENGTH, "-%s", tmp);
-        }
-    }
+    add_or_subtract(num1, num2, false, result);
 }
 
 void subtract_big_integers(const char *num1, const char *num2, char *result) {
-    char negated[MAX_NUMBER_LENGTH];
-    if (is_negative(num2)) {
-        strip_sign(num2, negated);
-    } else {
-        snprintf(negated, MAX_NUMBER_LENGTH, "-%s", num2);
-    }
-    add_big_integers(num1, negated, result);
+    add_or_subtract(num1, num2, true, result);
 }
 
 void pad_left_zeros(const char *src, int total_length, char *out) {
@@ -184,138 +288,32 @@ void strip_leading_zeros(char *num) {
 }
 
 void karatsuba_multiply(const char *num1, const char *num2, char *result) {
-    char a[MAX_NUMBER_LENGTH], b[MAX_NUMBER_LENGTH];
-    strip_sign(num1, a);
-    strip_sign(num2, b);
-    int neg = is_negative(num1) ^ is_negative(num2);
-
-    if (strlen(a) == 1 && strlen(b) == 1) {
-        int product = (a[0] - '0') * (b[0] - '0');
-        snprintf(result, MAX_NUMBER_LENGTH, "%d", product);
-        if (neg && product != 0) {
-            char temp[MAX_NUMBER_LENGTH];
-            snprintf(temp, MAX_NUMBER_LENGTH, "-%s", result);
-            strcpy(result, temp);
-        }
-        return;
-    }
-
-    int n = strlen(a) > strlen(b) ? strlen(a) : strlen(b);
-    if (n % 2 != 0) n++;
-
-    char a_padded[MAX_NUMBER_LENGTH], b_padded[MAX_NUMBER_LENGTH];
-    pad_left_zeros(a, n, a_padded);
-    pad_left_zeros(b, n, b_padded);
-
-    int m = n / 2;
-
-    char a1[MAX_NUMBER_LENGTH], a0[MAX_NUMBER_LENGTH];
-    char b1[MAX_NUMBER_LENGTH], b0[MAX_NUMBER_LENGTH];
-    strncpy(a1, a_padded, m); a1[m] = '\0';
-    strcpy(a0, a_padded + m);
-    strncpy(b1, b_padded, m); b1[m] = '\0';
-    strcpy(b0, b_padded + m);
-
-    char z2[MAX_NUMBER_LENGTH * 2]; karatsuba_multiply(a1, b1, z2);
-    char z0[MAX_NUMBER_LENGTH * 2]; karatsuba_multiply(a0, b0, z0);
+    bignum_t a, b;
+    bool ok = parse_operands(num1, num2, &a, &b) && bignum_mul(&a, &a, &b);
 
-    char a1_plus_a0[MAX_NUMBER_LENGTH]; add_big_integers(a1, a0, a1_plus_a0);
-    char b1_plus_b0[MAX_NUMBER_LENGTH]; add_big_integers(b1, b0, b1_plus_b0);
-    char z1[MAX_NUMBER_LENGTH * 2]; karatsuba_multiply(a1_plus_a0, b1_plus_b0, z1);
-
-    char temp[MAX_NUMBER_LENGTH * 2];
-    subtract_big_integers(z1, z2, temp);
-    subtract_big_integers(temp, z0, z1);
-
-    char z2_shifted[MAX_NUMBER_LENGTH * 2]; shift_left(z2, 2 * (n - m), z2_shifted);
-    char z1_shifted[MAX_NUMBER_LENGTH * 2]; shift_left(z1, n - m, z1_shifted);
-    char temp1[MAX_NUMBER_LENGTH * 2]; add_big_integers(z2_shifted, z1_shifted, temp1);
-    add_big_integers(temp1, z0, result);
-
-    if (neg && strcmp(result, "0") != 0) {
-        char tmp[MAX_NUMBER_LENGTH * 2];
-        snprintf(tmp, MAX_NUMBER_LENGTH * 2, "-%s", result);
-        strcpy(result, tmp);
+    if (!ok) {
+        strcpy(result, "NaN");
+    } else if (bignum_to_string(&a, result, MAX_NUMBER_LENGTH * 2) < 0) {
+        fprintf(stderr, "Product exceeds %d digits\n", MAX_NUMBER_LENGTH * 2 - 1);
+        strcpy(result, "NaN");
     }
 
-    // Remove leading zeros
-    strip_leading_zeros(result);
+    bignum_free(&a);
+    bignum_free(&b);
 }
 
 void divide_big_decimals(const char *num1, const char *num2, int precision, char *result) {
-    char dividend[MAX_NUMBER_LENGTH * 2];
-    char divisor[MAX_NUMBER_LENGTH];
-    char current[MAX_NUMBER_LENGTH * 2] = "0";
-    char quotient[MAX_NUMBER_LENGTH * 4] = "";
-    char sub_result[MAX_NUMBER_LENGTH * 2];
-    char remainder[MAX_NUMBER_LENGTH * 2] = "";
-    
-    int neg = is_negative(num1) ^ is_negative(num2);
-    strip_sign(num1, dividend);
-    strip_sign(num2, divisor);
-
-    if (strcmp(divisor, "0") == 0) {
-        strcpy(result, "NaN");
-        return;
-    }
-
-    if (strcmp(dividend, "0") == 0) {
-        snprintf(result, MAX_NUMBER_LENGTH * 2, "0.%0*d", precision, 0);
-        return;
-    }
-
-    size_t len = strlen(dividend);
-    int i = 0, q_index = 0;
-
-    while (i < len) {
-        size_t current_len = strlen(current);
-        current[current_len] = dividend[i++];
-        current[current_len + 1] = '\0';
-        strip_leading_zeros(current);
-
-        int count = 0;
-        while (compare_big_numbers(current, divisor) >= 0) {
-            subtract_unsigned(current, divisor, sub_result);
-            strcpy(current, sub_result);
-            strip_leading_zeros(current);
-            count++;
-        }
-        quotient[q_index++] = count + '0';
-    }
+    decimal_t dividend, divisor;
+    decimal_init(&dividend);
+    decimal_init(&divisor);
 
-    // Decimal point
-    quotient[q_index++] = '.';
-
-    int digits_generated = 0;
-    while (digits_generated < precision) {
-        if (strcmp(current, "0") == 0) {
-            quotient[q_index++] = '0';
-            digits_generated++;
-            continue;
-        }
-
-        // Multiply current remainder by 10
-        strcat(current, "0");
-
-        // Perform division again
-        int count = 0;
-        while (compare_big_numbers(current, divisor) >= 0) {
-            subtract_unsigned(current, divisor, sub_result);
-            strcpy(current, sub_result);
-            strip_leading_zeros(current);
-            count++;
-        }
-
-        quotient[q_index++] = count + '0';
-        digits_generated++;
+    if (!decimal_parse(&dividend, num1, strlen(num1)) || !decimal_parse(&divisor, num2, strlen(num2))) {
+        strcpy(result, "NaN");
+    } else if (!decimal_divide(&dividend, &divisor, precision, result, MAX_NUMBER_LENGTH)) {
+        fprintf(stderr, "Failed to divide %s by %s\n", num1, num2);
+        strcpy(result, "NaN");
     }
 
-    quotient[q_index] = '\0';
-    strip_leading_zeros(quotient);
-
-    if (neg && strcmp(quotient, "0.000000") != 0) {
-        snprintf(result, MAX_NUMBER_LENGTH * 4, "-%s", quotient);
-    } else {
-        strcpy(result, quotient);
-    }
+    decimal_free(&dividend);
+    decimal_free(&divisor);
 }
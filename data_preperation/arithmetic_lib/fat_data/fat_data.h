@@ -2,9 +2,12 @@
 #define FAT_DATA_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #define MAX_NUMBER_LENGTH 4096
 #define DEFAULT_PRECISION 6
+#define MAX_PRECISION 1000  // Fraction digits, keeps a mean within MAX_NUMBER_LENGTH
 
 /**
  * Checks if a string represents a valid floating-point number of arbitrary size.
@@ -16,7 +19,19 @@
 int is_valid_double(const char *str);
 
 /**
- * Compares two arbitrarily large non-negative integers represented as strings.
+ * Same as is_valid_double, but reads at most len characters so it can run
+ * on cells that are views into a mapped file rather than NUL-terminated strings.
+ *
+ * @param str The characters to check.
+ * @param len Number of characters in the view.
+ * @return 1 if valid, 0 otherwise.
+ */
+int is_valid_double_n(const char *str, size_t len);
+
+/**
+ * Compares two arbitrarily large numbers represented as strings.
+ * A leading '-' or '+' is honoured and -0 equals 0. Decimals compare exactly,
+ * exponents are expanded, text that is not a number orders by length then characters.
  *
  * @param num1 First number as a string.
  * @param num2 Second number as a string.
@@ -24,6 +39,23 @@ int is_valid_double(const char *str);
  */
 int compare_big_numbers(const char *num1, const char *num2);
 
+// Widest representation a value needs, ordered so the widest of a block is its maximum
+typedef enum {
+    NUMBER_INT64,   // Optional sign and digits only, fits in int64_t
+    NUMBER_BIGINT,  // Optional sign and digits only, past int64_t
+    NUMBER_DECIMAL  // Anything else: decimal points, exponents, spaces, text
+} number_class_t;
+
+/**
+ * Classifies a value for the native integer kernels.
+ *
+ * @param str The characters to classify, need not be NUL-terminated.
+ * @param len Number of characters.
+ * @param value Out, the parsed value when NUMBER_INT64 is returned.
+ * @return The narrowest number_class_t that holds the value.
+ */
+number_class_t classify_number(const char *str, size_t len, int64_t *value);
+
 /**
  * Returns true if the number has a leading minus sign.
  *
@@ -60,6 +92,7 @@ void subtract_unsigned(const char *num1, const char *num2, char *result);
 
 /**
  * Adds two arbitrarily large signed integers represented as strings.
+ * Runs on bignum limbs, the result is normalized and "NaN" when an operand is not an integer.
  *
  * @param num1 First number.
  * @param num2 Second number.
@@ -95,17 +128,26 @@ void shift_left(const char *num, int digits, char *result);
 void pad_left_zeros(const char *src, int total_length, char *out);
 
 /**
- * Multiplies two arbitrarily large integers using the Karatsuba algorithm.
+ * Removes leading zeros in place, keeping a leading minus sign and a single "0" for zero.
+ *
+ * @param num Number string to trim.
+ */
+void strip_leading_zeros(char *num);
+
+/**
+ * Multiplies two arbitrarily large integers on limbs, bignum_mul picks schoolbook,
+ * Karatsuba or a number-theoretic transform from the operand sizes.
  *
  * @param num1 First number.
  * @param num2 Second number.
- * @param result Output buffer (must be large enough).
+ * @param result Output buffer of MAX_NUMBER_LENGTH * 2, "NaN" for non-integers or a longer product.
  */
 void karatsuba_multiply(const char *num1, const char *num2, char *result);
 
 /**
- * Divides two big integers as strings and returns a string with decimal places.
- * 
+ * Divides two big numbers as strings and returns a string with decimal places.
+ * Either may be a decimal. Truncates after precision digits, "NaN" for a zero divisor.
+ *
  * @param num1 Dividend.
  * @param num2 Divisor.
  * @param precision Number of digits after the decimal point.
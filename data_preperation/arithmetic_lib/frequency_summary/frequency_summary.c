@@ -0,0 +1,233 @@
+#include "frequency_summary.h"
+#include "../fat_data/fat_data.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define EMPTY_SLOT -1
+
+typedef struct {
+    char *key;          // NUL-terminated copy
+    size_t length;
+    uint64_t hash;
+    long long count;
+} summary_entry_t;
+
+struct frequency_summary {
+    int capacity;          // Counters kept between prunes
+    int size;
+    int entry_capacity;    // Room for a merge before pruning
+    summary_entry_t *entries;
+
+    int *slots;            // Open addressing index into entries
+    int num_slots;         // Power of two, at least twice entry_capacity
+
+    bool pruned;
+};
+
+static uint64_t hash_key(const char *key, size_t length) {
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void rebuild_index(frequency_summary_t *summary) {
+    for (int i = 0; i < summary->num_slots; i++) summary->slots[i] = EMPTY_SLOT;
+
+    for (int e = 0; e < summary->size; e++) {
+        int slot = (int)(summary->entries[e].hash & (summary->num_slots - 1));
+        while (summary->slots[slot] != EMPTY_SLOT) slot = (slot + 1) & (summary->num_slots - 1);
+        summary->slots[slot] = e;
+    }
+}
+
+// Returns the slot holding key, or the empty slot it would go in
+static int find_slot(const frequency_summary_t *summary, const char *key, size_t length, uint64_t hash) {
+    int slot = (int)(hash & (summary->num_slots - 1));
+
+    while (summary->slots[slot] != EMPTY_SLOT) {
+        const summary_entry_t *entry = &summary->entries[summary->slots[slot]];
+        if (entry->hash == hash && entry->length == length && memcmp(entry->key, key, length) == 0) return slot;
+        slot = (slot + 1) & (summary->num_slots - 1);
+    }
+
+    return slot;
+}
+
+static frequency_summary_t *summary_alloc(int capacity) {
+    frequency_summary_t *summary = calloc(1, sizeof(frequency_summary_t));
+    if (!summary) return NULL;
+
+    summary->capacity = capacity > 0 ? capacity : 1;
+    summary->entry_capacity = summary->capacity * 2;
+    summary->num_slots = 1;
+    while (summary->num_slots < summary->entry_capacity * 2) summary->num_slots <<= 1;
+
+    summary->entries = calloc(summary->entry_capacity, sizeof(summary_entry_t));
+    summary->slots = malloc(summary->num_slots * sizeof(int));
+    if (!summary->entries || !summary->slots) {
+        free(summary->entries);
+        free(summary->slots);
+        free(summary);
+        return NULL;
+    }
+
+    rebuild_index(summary);
+    return summary;
+}
+
+frequency_summary_t *frequency_summary_create(int capacity) {
+    frequency_summary_t *summary = summary_alloc(capacity);
+    if (!summary) fprintf(stderr, "Failed to allocate memory for frequency summary\n");
+    return summary;
+}
+
+void frequency_summary_destroy(frequency_summary_t *summary) {
+    if (!summary) return;
+    for (int e = 0; e < summary->size; e++) free(summary->entries[e].key);
+    free(summary->entries);
+    free(summary->slots);
+    free(summary);
+}
+
+// Drop entries whose count fell to zero and reindex the survivors
+static void compact(frequency_summary_t *summary) {
+    int kept = 0;
+    for (int e = 0; e < summary->size; e++) {
+        if (summary->entries[e].count > 0) {
+            summary->entries[kept++] = summary->entries[e];
+        } else {
+            free(summary->entries[e].key);
+        }
+    }
+    summary->size = kept;
+    rebuild_index(summary);
+}
+
+static bool insert_entry(frequency_summary_t *summary, int slot, const char *key, size_t length, uint64_t hash, long long count) {
+    char *copy = malloc(length + 1);
+    if (!copy) {
+        fprintf(stderr, "Failed to allocate memory for frequency summary key\n");
+        return false;
+    }
+    memcpy(copy, key, length);
+    copy[length] = '\0';
+
+    summary->entries[summary->size] = (summary_entry_t){ copy, length, hash, count };
+    summary->slots[slot] = summary->size;
+    summary->size++;
+
+    return true;
+}
+
+bool frequency_summary_add(frequency_summary_t *summary, const char *key, size_t length) {
+    uint64_t hash = hash_key(key, length);
+    int slot = find_slot(summary, key, length, hash);
+
+    if (summary->slots[slot] != EMPTY_SLOT) {
+        summary->entries[summary->slots[slot]].count++;
+        return true;
+    }
+
+    if (summary->size < summary->capacity) {
+        return insert_entry(summary, slot, key, length, hash, 1);
+    }
+
+    // Every counter is taken, the new key cancels one occurrence of each
+    for (int e = 0; e < summary->size; e++) summary->entries[e].count--;
+    summary->pruned = true;
+    compact(summary);
+
+    return true;
+}
+
+static int compare_counts_descending(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x < y) - (x > y);
+}
+
+bool frequency_summary_merge(frequency_summary_t *dest, const frequency_summary_t *src) {
+    if (!dest || !src) {
+        fprintf(stderr, "Invalid frequency summary for merge\n");
+        return false;
+    }
+
+    dest->pruned |= src->pruned;
+
+    for (int e = 0; e < src->size; e++) {
+        const summary_entry_t *entry = &src->entries[e];
+        int slot = find_slot(dest, entry->key, entry->length, entry->hash);
+
+        if (dest->slots[slot] != EMPTY_SLOT) {
+            dest->entries[dest->slots[slot]].count += entry->count;
+            continue;
+        }
+
+        if (!insert_entry(dest, slot, entry->key, entry->length, entry->hash, entry->count)) return false;
+
+        // Stay within the entry array, prune back to capacity when it fills
+        if (dest->size < dest->entry_capacity) continue;
+
+        long long *counts = malloc(dest->size * sizeof(long long));
+        if (!counts) return false;
+        for (int k = 0; k < dest->size; k++) counts[k] = dest->entries[k].count;
+        qsort(counts, dest->size, sizeof(long long), compare_counts_descending);
+
+        long long cut = counts[dest->capacity];
+        free(counts);
+
+        for (int k = 0; k < dest->size; k++) dest->entries[k].count -= cut;
+        dest->pruned = true;
+        compact(dest);
+    }
+
+    return true;
+}
+
+bool frequency_summary_pruned(const frequency_summary_t *summary) {
+    return summary->pruned;
+}
+
+frequency_summary_t *frequency_summary_candidates(const frequency_summary_t *summary) {
+    frequency_summary_t *candidates = summary_alloc(summary->size > summary->capacity ? summary->size : summary->capacity);
+    if (!candidates) {
+        fprintf(stderr, "Failed to allocate memory for frequency summary\n");
+        return NULL;
+    }
+
+    for (int e = 0; e < summary->size; e++) {
+        const summary_entry_t *entry = &summary->entries[e];
+        int slot = find_slot(candidates, entry->key, entry->length, entry->hash);
+        if (!insert_entry(candidates, slot, entry->key, entry->length, entry->hash, 0)) {
+            frequency_summary_destroy(candidates);
+            return NULL;
+        }
+    }
+
+    return candidates;
+}
+
+void frequency_summary_count(frequency_summary_t *candidates, const char *key, size_t length) {
+    uint64_t hash = hash_key(key, length);
+    int slot = find_slot(candidates, key, length, hash);
+    if (candidates->slots[slot] != EMPTY_SLOT) candidates->entries[candidates->slots[slot]].count++;
+}
+
+const char *frequency_summary_mode(const frequency_summary_t *summary, long long *count) {
+    const summary_entry_t *best = NULL;
+
+    for (int e = 0; e < summary->size; e++) {
+        const summary_entry_t *entry = &summary->entries[e];
+        if (!best || entry->count > best->count ||
+            (entry->count == best->count && compare_big_numbers(entry->key, best->key) < 0)) {
+            best = entry;
+        }
+    }
+
+    if (count) *count = best ? best->count : 0;
+    return best ? best->key : NULL;
+}
@@ -0,0 +1,45 @@
+#ifndef FREQUENCY_SUMMARY_H
+#define FREQUENCY_SUMMARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+    Misra-Gries heavy hitter summary over string keys with a fixed number of counters.
+    Any key occurring more than n / (capacity + 1) times in a stream of n keys survives,
+    so memory stays bounded no matter how many distinct values the stream holds.
+ */
+typedef struct frequency_summary frequency_summary_t;
+
+frequency_summary_t *frequency_summary_create(int capacity);
+void frequency_summary_destroy(frequency_summary_t *summary);
+
+/*
+    @param key: characters of the key, need not be NUL-terminated
+    @return false on allocation failure
+ */
+bool frequency_summary_add(frequency_summary_t *summary, const char *key, size_t length);
+
+// Combine two summaries, pruning back down to dest's capacity
+bool frequency_summary_merge(frequency_summary_t *dest, const frequency_summary_t *src);
+
+// True once counters were decremented, the counts are then only lower bounds
+bool frequency_summary_pruned(const frequency_summary_t *summary);
+
+/*
+    Copy of the surviving keys with zeroed counts that only counts keys it already holds,
+    used for an exact recount of the candidates after a pruned pass
+ */
+frequency_summary_t *frequency_summary_candidates(const frequency_summary_t *summary);
+
+// Increment the count of key if it is a candidate, other keys are ignored
+void frequency_summary_count(frequency_summary_t *candidates, const char *key, size_t length);
+
+/*
+    Most frequent key, ties go to the numerically smaller key.
+    @param count: out, occurrences of the returned key
+    @return NULL when the summary is empty
+ */
+const char *frequency_summary_mode(const frequency_summary_t *summary, long long *count);
+
+#endif // FREQUENCY_SUMMARY_H
@@ -1,33 +1,50 @@
 #include <stdio.h>
 #include <string.h>
-#include <limits.h>
+#include <stdint.h>
 #include "./hashmap.h"
+#include "../fat_data/fat_data.h"
 #include <stdlib.h>
 
-// Implement hash function with static bucket size but seperate chaining
+#define INITIAL_SLOTS 256          // Power of two, small since every thread keeps a map per partition
+#define INITIAL_ARENA 4096
+#define MAX_LOAD_NUMERATOR 7       // Grow past 7/8 full, Robin Hood keeps probes short up to there
+#define MAX_LOAD_DENOMINATOR 8
 
-#define NUM_BUCKETS 2048 
-
-typedef struct entry {
-    char *key;
-    int value; // Count of key occurrences in this bucket
-    struct entry *next; // Pointer to next bucket in case of collision
-} entry_t;
+typedef struct {
+    uint64_t hash;   // 0 marks an empty slot
+    size_t key;      // Offset of the NUL-terminated key in the arena
+    unsigned int length;
+    int count;
+} slot_t;
 
 typedef struct hashmap {
-    int num_buckets; // Number of buckets already stored 
-    int mode; // Mode of the hashmap
-    char *mode_key;
-    entry_t *buckets[NUM_BUCKETS]; // Array of bucket linked lists
+    slot_t *slots;
+    size_t num_slots;   // Power of two
+    size_t size;        // Keys stored
+
+    char *arena;        // Keys back to back, each NUL-terminated
+    size_t arena_size;
+    size_t arena_capacity;
 } hashmap_t;
 
-// djb2 hash function
-unsigned long hash_function(const char *str) {
-    unsigned long hash = 5381;
-    int c;
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c;  // hash * 33 + c
-    return hash;
+// Eight bytes at a time with a multiply-xorshift mix, never 0 so 0 can mark empty slots
+uint64_t hashmap_hash(const char *key, size_t length) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ length;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, key, sizeof(word));
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+        key += 8;
+        length -= 8;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, key, length);
+    hash = (hash ^ tail) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 29;
+
+    return hash ? hash : 1;
 }
 
 hashmap_t* hashmap_create() {
@@ -36,82 +53,150 @@ hashmap_t* hashmap_create() {
         fprintf(stderr, "Failed to allocate memory for hashmap\n");
         return NULL;
     }
-    for (int i = 0; i < NUM_BUCKETS; i++) {
-        map->buckets[i] = NULL; // Initialize all buckets to NULL
-    }
 
-    map->mode = 0; // Default mode
-    map->num_buckets = 0;
+    map->num_slots = INITIAL_SLOTS;
+    map->slots = calloc(map->num_slots, sizeof(slot_t));
+    map->arena_capacity = INITIAL_ARENA;
+    map->arena = malloc(map->arena_capacity);
+    if (!map->slots || !map->arena) {
+        fprintf(stderr, "Failed to allocate memory for hashmap\n");
+        hashmap_destroy(map);
+        return NULL;
+    }
 
     return map;
 }
 
-void hashmap_put(hashmap_t* map, const char* key, int value) {
-    // Check for valid map and key
-    if (!map || !key) {
-        fprintf(stderr, "Invalid hashmap or key\n");
-        return;
+static inline size_t probe_distance(const hashmap_t *map, const slot_t *slot, size_t index) {
+    return (index - (slot->hash & (map->num_slots - 1))) & (map->num_slots - 1);
+}
+
+// Robin Hood placement of a key known to be absent: it takes the slot of any entry closer to its home
+static void place(hashmap_t *map, slot_t entry, size_t index, size_t distance) {
+    size_t mask = map->num_slots - 1;
+    for (;;) {
+        slot_t *slot = &map->slots[index];
+        if (!slot->hash) {
+            *slot = entry;
+            return;
+        }
+
+        size_t resident = probe_distance(map, slot, index);
+        if (resident < distance) {
+            slot_t displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+            distance = resident;
+        }
+        index = (index + 1) & mask;
+        distance++;
     }
+}
 
-    if (value > INT_MAX || value < 0) {
-        fprintf(stderr, "Invalid value for hashmap: %d\n", value);
-        return;
+// Double the slots until keys fit under the load limit
+static bool reserve(hashmap_t *map, size_t keys) {
+    size_t num_slots = map->num_slots;
+    while (keys * MAX_LOAD_DENOMINATOR > num_slots * MAX_LOAD_NUMERATOR) num_slots *= 2;
+    if (num_slots == map->num_slots) return true;
+
+    slot_t *old = map->slots;
+    size_t old_slots = map->num_slots;
+
+    slot_t *slots = calloc(num_slots, sizeof(slot_t));
+    if (!slots) {
+        fprintf(stderr, "Failed to grow hashmap\n");
+        return false;
+    }
+    map->slots = slots;
+    map->num_slots = num_slots;
+
+    // Keys stay where they are in the arena, only the slots move
+    for (size_t i = 0; i < old_slots; i++) {
+        if (old[i].hash) place(map, old[i], old[i].hash & (map->num_slots - 1), 0);
     }
 
-    unsigned long hash = hash_function(key);
-    int index = hash % NUM_BUCKETS;
+    free(old);
+    return true;
+}
 
-    entry_t *current = map->buckets[index];
-    while (current) {
-        if (strcmp(current->key, key) == 0) {
-            current->value = value; // Update count of occurrences if key already exists
-            if (value > map->mode) {
-                map->mode = value; // Update mode if new value is greater
-                map->mode_key = strdup(key); // Update mode key
-            }
+// Copy a key into the arena, @return its offset or SIZE_MAX on allocation failure
+static size_t store_key(hashmap_t *map, const char *key, size_t length) {
+    if (map->arena_size + length + 1 > map->arena_capacity) {
+        size_t capacity = map->arena_capacity * 2;
+        while (capacity < map->arena_size + length + 1) capacity *= 2;
 
-            return;
+        char *arena = realloc(map->arena, capacity);
+        if (!arena) {
+            fprintf(stderr, "Failed to grow hashmap key arena\n");
+            return SIZE_MAX;
         }
-        current = current->next;
+        map->arena = arena;
+        map->arena_capacity = capacity;
     }
 
-    // Create a new bucket for the new key
-    entry_t *new_bucket = malloc(sizeof(entry_t));
-    if (!new_bucket) {
-        fprintf(stderr, "Failed to allocate memory for new bucket\n");
-        return;
+    size_t offset = map->arena_size;
+    memcpy(map->arena + offset, key, length);
+    map->arena[offset + length] = '\0';
+    map->arena_size += length + 1;
+    return offset;
+}
+
+bool hashmap_add(hashmap_t* map, const char* key, size_t length, int count) {
+    return hashmap_add_hashed(map, hashmap_hash(key, length), key, length, count);
+}
+
+bool hashmap_add_hashed(hashmap_t* map, uint64_t hash, const char* key, size_t length, int count) {
+    // Check for valid map and key
+    if (!map || !key) {
+        fprintf(stderr, "Invalid hashmap or key\n");
+        return false;
     }
-    new_bucket->key = strdup(key);
-    new_bucket->value = value;
-    new_bucket->next = map->buckets[index];
-    
-    map->buckets[index] = new_bucket;
-    map->num_buckets++;
-    if (value > map->mode) { 
-        map->mode = value;
-        map->mode_key = strdup(key); // Allocate memory for mode key
+
+    if (!reserve(map, map->size + 1)) return false;
+
+    size_t mask = map->num_slots - 1;
+    size_t index = hash & mask;
+
+    // Stop at the key, an empty slot, or an entry closer to home than the key would be, which proves it absent
+    for (size_t distance = 0;; distance++, index = (index + 1) & mask) {
+        slot_t *slot = &map->slots[index];
+
+        if (slot->hash == hash && slot->length == length && memcmp(map->arena + slot->key, key, length) == 0) {
+            slot->count += count;
+            return true;
+        }
+
+        if (!slot->hash || probe_distance(map, slot, index) < distance) {
+            size_t offset = store_key(map, key, length);
+            if (offset == SIZE_MAX) return false;
+
+            slot_t entry = { hash, offset, (unsigned int)length, count };
+            place(map, entry, index, distance);
+            map->size++;
+            return true;
+        }
     }
 }
 
-int hashmap_get(hashmap_t* map, const char* key) {
+int hashmap_get(hashmap_t* map, const char* key, size_t length) {
     // Check for valid map and key
     if (!map || !key) {
         fprintf(stderr, "Invalid hashmap or key\n");
         return -1; // Indicate error
     }
 
-    unsigned long hash = hash_function(key);
-    int index = hash % NUM_BUCKETS;
+    uint64_t hash = hashmap_hash(key, length);
+    size_t mask = map->num_slots - 1;
+    size_t index = hash & mask;
+
+    for (size_t distance = 0;; distance++, index = (index + 1) & mask) {
+        const slot_t *slot = &map->slots[index];
+        if (!slot->hash || probe_distance(map, slot, index) < distance) return 0; // Key not found
 
-    entry_t *current = map->buckets[index];
-    while (current) {
-        if (strcmp(current->key, key) == 0) {
-            return current->value; // Return the count of occurrences
+        if (slot->hash == hash && slot->length == length && memcmp(map->arena + slot->key, key, length) == 0) {
+            return slot->count; // Return the count of occurrences
         }
-        current = current->next;
     }
-
-    return 0; // Key not found, return 0
 }
 
 void hashmap_print(hashmap_t* map) {
@@ -120,52 +205,77 @@ void hashmap_print(hashmap_t* map) {
         return;
     }
 
-    for (int i = 0; i < NUM_BUCKETS; i++) {
-        entry_t *current = map->buckets[i];
-        if (current) {
-            printf("Bucket %d:\n", i);
-            while (current) {
-                printf("  Key: %s, Value: %d\n", current->key, current->value);
-                current = current->next;
-            }
+    for (size_t i = 0; i < map->num_slots; i++) {
+        const slot_t *slot = &map->slots[i];
+        if (slot->hash) {
+            printf("Slot %zu (probe %zu): Key: %s, Value: %d\n", i, probe_distance(map, slot, i),
+                   map->arena + slot->key, slot->count);
         }
     }
 
-    printf("Hashmap mode: %d\n", map->mode);
-    printf("Hashmap mode key: %s\n", map->mode_key);
+    int mode = 0;
+    const char *mode_key = hashmap_mode(map, &mode);
+    printf("Hashmap mode: %d\n", mode);
+    printf("Hashmap mode key: %s\n", mode_key ? mode_key : "(none)");
 }
 
-void hashmap_destroy(hashmap_t* map) {
+void hashmap_clear(hashmap_t* map) {
     if (!map) return;
 
-    for (int i = 0; i < NUM_BUCKETS; i++) {
-        entry_t *current = map->buckets[i];
-        while (current) {
-            entry_t *temp = current;
-            current = current->next;
-            free(temp->key);
-            free(temp);
-        }
-    }
+    memset(map->slots, 0, map->num_slots * sizeof(slot_t));
+    map->size = 0;
+    map->arena_size = 0;
+}
+
+void hashmap_destroy(hashmap_t* map) {
+    if (!map) return;
 
-    free(map->mode_key); // Free mode key if allocated
+    free(map->slots);
+    free(map->arena);
     free(map);
 }
 
-void hashmap_merge(hashmap_t *dest, hashmap_t *src) {
+bool hashmap_merge(hashmap_t *dest, hashmap_t *src) {
     if (!dest || !src) {
         fprintf(stderr, "Invalid hashmap for merge\n");
-        return;
+        return false;
+    }
+
+    /*
+        Slot order is hash order, fed into a smaller table it lands as one growing cluster
+        and every insert probes to its end. With at least as many slots as src it spreads evenly.
+     */
+    if (!reserve(dest, dest->size + src->size)) return false;
+
+    for (size_t i = 0; i < src->num_slots; i++) {
+        const slot_t *slot = &src->slots[i];
+        if (slot->hash && !hashmap_add_hashed(dest, slot->hash, src->arena + slot->key, slot->length, slot->count)) {
+            return false;
+        }
     }
+    return true;
+}
+
+int hashmap_compare_keys(const char *a, const char *b) {
+    int cmp = compare_big_numbers(a, b);
+    return cmp ? cmp : strcmp(a, b);
+}
 
-    for (int i = 0; i < NUM_BUCKETS; i++) {
-        entry_t *current = src->buckets[i];
-        while (current) {
-            int count = hashmap_get(dest, current->key);
-            hashmap_put(dest, current->key, count + current->value);
-            current = current->next;
+const char *hashmap_mode(hashmap_t *map, int *count) {
+    const slot_t *best = NULL;
+    for (size_t i = 0; map && i < map->num_slots; i++) {
+        const slot_t *slot = &map->slots[i];
+
+        // Values seen once never are the mode, and with many distinct values nearly all tie at 1
+        if (slot->count < 2) continue;
+        if (!best || slot->count > best->count ||
+            (slot->count == best->count && hashmap_compare_keys(map->arena + slot->key, map->arena + best->key) < 0)) {
+            best = slot;
         }
     }
+
+    if (count) *count = best ? best->count : 0;
+    return best ? map->arena + best->key : NULL;
 }
 
 char *get_mode_key(hashmap_t *map) {
@@ -173,9 +283,11 @@ char *get_mode_key(hashmap_t *map) {
         fprintf(stderr, "Invalid hashmap\n");
         return NULL;
     }
-    if (map->mode == 1 || map->mode == 0) {
+
+    const char *key = hashmap_mode(map, NULL);
+    if (!key) {
         return "N/A"; // No mode or only one occurrence
     }
 
-    return map->mode_key; // Return the mode key
-}
\ No newline at end of file
+    return (char *)key; // Return the mode key
+}
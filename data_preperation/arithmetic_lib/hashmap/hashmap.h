@@ -1,14 +1,64 @@
 #ifndef HASHMAP_H
 #define HASHMAP_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Counts per string key for mode. Open addressing with Robin Hood probing: slots hold the
+    full hash, the count and the key's offset in one arena per map, and the table doubles
+    as it fills. The full hash is kept so merges and partitioning never hash a key twice.
+ */
 typedef struct hashmap hashmap_t;
+
 hashmap_t* hashmap_create();
-void hashmap_put(hashmap_t* map, const char* key, int value);
-int hashmap_get(hashmap_t* map, const char* key);
-unsigned long hash_function(const char *str);
+
+// Hash of a key, never 0
+uint64_t hashmap_hash(const char* key, size_t length);
+
+/*
+    Partition of a hash among num_partitions, from the high bits since the slots use the low ones
+    @return 0 to num_partitions - 1
+ */
+static inline int hashmap_partition(uint64_t hash, int num_partitions) {
+    return (int)(((hash >> 32) * (uint64_t)num_partitions) >> 32);
+}
+
+/*
+    Add count to key, inserting it first when it is new, in a single probe
+    @param key: characters of the key, need not be NUL-terminated
+    @return false on allocation failure
+ */
+bool hashmap_add(hashmap_t* map, const char* key, size_t length, int count);
+
+// hashmap_add with the key's hashmap_hash already known
+bool hashmap_add_hashed(hashmap_t* map, uint64_t hash, const char* key, size_t length, int count);
+
+// Count of key, 0 when it is absent
+int hashmap_get(hashmap_t* map, const char* key, size_t length);
+
+// Drop every key but keep the slots and arena, so one map can count lane after lane
+void hashmap_clear(hashmap_t* map);
+
 void hashmap_destroy(hashmap_t* map);
 void hashmap_print(hashmap_t* map);
-void hashmap_merge(hashmap_t *dest, hashmap_t *src);
+
+// Add every count of src into dest, @return false on allocation failure
+bool hashmap_merge(hashmap_t *dest, hashmap_t *src);
+
+// Order of mode ties, compare_big_numbers with the bytes deciding between equal values such as 1 and 1.0
+int hashmap_compare_keys(const char *a, const char *b);
+
+/*
+    Key with the highest count, the smallest by hashmap_compare_keys among equal counts, so the
+    answer doesn't depend on insertion or merge order. Scans the slots once.
+    @param count: out, its count, 0 when there is none
+    @return NULL when no key occurs twice, otherwise valid until the next insert
+ */
+const char *hashmap_mode(hashmap_t *map, int *count);
+
+// hashmap_mode's key, "N/A" when no key occurs twice
 char *get_mode_key(hashmap_t *map);
 
 #endif
@@ -0,0 +1,73 @@
+#include "ring_buffer.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+bool ring_buffer_init(ring_buffer_t *ring, size_t capacity) {
+    size_t slots = 2;
+    while (slots < capacity) slots *= 2;
+
+    ring->slots = malloc(slots * sizeof(ring_slot_t));
+    if (!ring->slots) {
+        fprintf(stderr, "Failed to allocate ring buffer\n");
+        return false;
+    }
+
+    ring->mask = slots - 1;
+    for (size_t i = 0; i < slots; i++) atomic_init(&ring->slots[i].sequence, i);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return true;
+}
+
+bool ring_buffer_push(ring_buffer_t *ring, size_t value) {
+    size_t position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        ring_slot_t *slot = &ring->slots[position & ring->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t turn = (intptr_t)sequence - (intptr_t)position;
+
+        if (turn == 0) {
+            // The slot is free for this position, claim the position before writing
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->value = value;
+                atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+                return true;
+            }
+        } else if (turn < 0) {
+            return false;   // Still holds the value from one lap ago
+        } else {
+            position = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+bool ring_buffer_pop(ring_buffer_t *ring, size_t *value) {
+    size_t position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;) {
+        ring_slot_t *slot = &ring->slots[position & ring->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t turn = (intptr_t)sequence - (intptr_t)(position + 1);
+
+        if (turn == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->tail, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *value = slot->value;
+                // Free for the push one lap later
+                atomic_store_explicit(&slot->sequence, position + ring->mask + 1, memory_order_release);
+                return true;
+            }
+        } else if (turn < 0) {
+            return false;   // Nothing pushed here yet
+        } else {
+            position = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+}
+
+void ring_buffer_free(ring_buffer_t *ring) {
+    if (!ring) return;
+    free(ring->slots);
+    ring->slots = NULL;
+}
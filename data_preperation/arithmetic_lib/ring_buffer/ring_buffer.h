@@ -0,0 +1,43 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// A slot's sequence says whose turn it is: pos for a push at pos, pos + 1 for a pop at pos
+typedef struct {
+    atomic_size_t sequence;
+    size_t value;
+} ring_slot_t;
+
+/*
+    Bounded lock-free queue of indexes, any number of threads push and pop.
+    Each slot carries a sequence number, so a push and a pop only race on the
+    position counter of their own end and never on each other's.
+ */
+typedef struct {
+    ring_slot_t *slots;
+    size_t mask;                  // Capacity - 1, the capacity is a power of two
+    char padding_head[64];
+    atomic_size_t head;           // Next push
+    char padding_tail[64];        // Keep producers and consumers off each other's cache line
+    atomic_size_t tail;           // Next pop
+    char padding_end[64];
+} ring_buffer_t;
+
+/*
+    @param capacity: rounded up to a power of two
+    @return false on allocation failure
+ */
+bool ring_buffer_init(ring_buffer_t *ring, size_t capacity);
+
+// @return false when the ring is full, or for a moment while a pop of the slot one lap back is finishing
+bool ring_buffer_push(ring_buffer_t *ring, size_t value);
+
+// @return false when the ring is empty
+bool ring_buffer_pop(ring_buffer_t *ring, size_t *value);
+
+void ring_buffer_free(ring_buffer_t *ring);
+
+#endif
@@ -1,6 +0,0 @@
-#ifndef K_WAY_H
-#define K_WAY_H
-
-char **k_way_merge(char ***concatenated_chunks, int *chunk_sizes, int num_threads, int subregion_length);
-
-#endif // K_WAY_H
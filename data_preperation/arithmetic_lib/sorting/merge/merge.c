@@ -1,51 +1,52 @@
 #include <stdio.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include "merge.h"
-#include "../../fat_data/fat_data.h"
 
-void merge(char **chunk, int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
+// Merge [left, mid] and [mid + 1, right] through the shared scratch buffer
+void merge(sort_key_t *chunk, sort_key_t *scratch, int left, int mid, int right) {
+    memcpy(scratch + left, chunk + left, (right - left + 1) * sizeof(sort_key_t));
 
-    char **L = malloc(n1 * sizeof(char *));
-    char **R = malloc(n2 * sizeof(char *));
-    if (!L || !R) {
-        fprintf(stderr, "malloc failed in merge\n");
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < n1; i++) L[i] = chunk[left + i];
-    for (int j = 0; j < n2; j++) R[j] = chunk[mid + 1 + j];
-
-    int i = 0, j = 0, k = left;
+    int i = left, j = mid + 1, k = left;
 
-    while (i < n1 && j < n2) {
-        if (compare_big_numbers(L[i], R[j]) <= 0) {
-            chunk[k++] = L[i++];
+    while (i <= mid && j <= right) {
+        if (sort_key_compare(&scratch[i], &scratch[j]) <= 0) {
+            chunk[k++] = scratch[i++];
         } else {
-            chunk[k++] = R[j++];
+            chunk[k++] = scratch[j++];
         }
     }
 
-    while (i < n1) chunk[k++] = L[i++];
-    while (j < n2) chunk[k++] = R[j++];
-
-    free(L);
-    free(R);
+    while (i <= mid) chunk[k++] = scratch[i++];
+    while (j <= right) chunk[k++] = scratch[j++];
 }
 
-void merge_sort_interface(char **chunk, int left, int right) {
+void merge_sort_interface(sort_key_t *chunk, sort_key_t *scratch, int left, int right) {
     if (left < right) {
         int mid = left + (right - left) / 2;
-        merge_sort_interface(chunk, left, mid);
-        merge_sort_interface(chunk, mid + 1, right);
-        merge(chunk, left, mid, right);
+        merge_sort_interface(chunk, scratch, left, mid);
+        merge_sort_interface(chunk, scratch, mid + 1, right);
+
+        // Halves that are already in order need no merge
+        if (sort_key_compare(&chunk[mid], &chunk[mid + 1]) > 0) merge(chunk, scratch, left, mid, right);
     }
 }
 
-void merge_sort(char **chunk, int chunk_size) {
-    int left = 0;
-    int right =  chunk_size - 1;
-    merge_sort_interface(chunk, left, right);
-} 
\ No newline at end of file
+void merge_sort_scratch(sort_key_t *chunk, sort_key_t *scratch, int chunk_size) {
+    merge_sort_interface(chunk, scratch, 0, chunk_size - 1);
+}
+
+bool merge_sort(sort_key_t *chunk, int chunk_size) {
+    if (chunk_size < 2) return true;
+
+    sort_key_t *scratch = malloc(chunk_size * sizeof(sort_key_t));
+    if (!scratch) {
+        fprintf(stderr, "malloc failed in merge\n");
+        return false;
+    }
+
+    merge_sort_scratch(chunk, scratch, chunk_size);
+    free(scratch);
+    return true;
+}
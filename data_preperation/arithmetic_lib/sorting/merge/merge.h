@@ -1,10 +1,22 @@
 #ifndef MERGE_H
 #define MERGE_H
 
+#include <stddef.h>
+#include <stdbool.h>
+#include "../sort_key/sort_key.h"
+
 /*
-    @param subregion: thread share of requested boundaries that gets modified in place
+    Stable sort by key
+    @param keys: thread share of requested values that gets modified in place
     @param chunk_size: size of chunk 
+    @return false when the scratch buffer can't be allocated, keys are left as they were
+ */
+bool merge_sort(sort_key_t *keys, int chunk_size);
+
+/*
+    Same as merge_sort with a caller-owned buffer instead of one allocation per call
+    @param scratch: at least chunk_size entries
  */
-void merge_sort(char **subregion, int chunk_size);
+void merge_sort_scratch(sort_key_t *keys, sort_key_t *scratch, int chunk_size);
 
-#endif // MERGE_H 
\ No newline at end of file
+#endif // MERGE_H 
@@ -0,0 +1,73 @@
+#include "radix.h"
+#include "../merge/merge.h"
+#include <stdint.h>
+#include <string.h>
+
+// One bucket per byte value plus bucket 0 for keys that already ended
+#define RADIX_BUCKETS 257
+
+// Shorter keys sort first, so a key that ended before depth takes the lowest bucket
+static inline int bucket_of(const sort_key_t *key, uint32_t depth) {
+    if (depth >= key->length) return 0;
+    if (depth < 8) return 1 + (int)((key->prefix >> (56 - 8 * depth)) & 0xFF);
+    return 1 + key->key[depth];
+}
+
+static void insertion_sort(sort_key_t *keys, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        sort_key_t key = keys[i];
+        size_t j = i;
+        while (j > 0 && sort_key_compare(&key, &keys[j - 1]) < 0) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+static void msd_sort(sort_key_t *keys, sort_key_t *scratch, size_t count, uint32_t depth) {
+    uint32_t counts[RADIX_BUCKETS];
+
+    for (;;) {
+        if (count < RADIX_SORT_THRESHOLD) {
+            insertion_sort(keys, count);
+            return;
+        }
+        if (depth >= RADIX_MAX_DEPTH) {
+            merge_sort_scratch(keys, scratch, (int)count);
+            return;
+        }
+
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < count; i++) counts[bucket_of(&keys[i], depth)]++;
+
+        // Shared bytes, such as the tag and exponent of same-sized numbers, move nothing
+        int only = bucket_of(&keys[0], depth);
+        if (counts[only] == count) {
+            if (only == 0) return;   // Every key ended here, they are all equal
+            depth++;
+            continue;
+        }
+
+        // Stable scatter through scratch, then back
+        uint32_t starts[RADIX_BUCKETS], position = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            starts[b] = position;
+            position += counts[b];
+        }
+        for (size_t i = 0; i < count; i++) scratch[starts[bucket_of(&keys[i], depth)]++] = keys[i];
+        memcpy(keys, scratch, count * sizeof(sort_key_t));
+
+        // Bucket 0 holds ended keys which are already equal
+        size_t start = counts[0];
+        for (int b = 1; b < RADIX_BUCKETS; b++) {
+            if (counts[b] > 1) msd_sort(keys + start, scratch + start, counts[b], depth + 1);
+            start += counts[b];
+        }
+        return;
+    }
+}
+
+void radix_sort(sort_key_t *keys, sort_key_t *scratch, int count) {
+    if (count > 1) msd_sort(keys, scratch, (size_t)count, 0);
+}
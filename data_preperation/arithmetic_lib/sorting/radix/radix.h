@@ -0,0 +1,19 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stddef.h>
+#include "../sort_key/sort_key.h"
+
+#define RADIX_SORT_THRESHOLD 32   // Buckets smaller than this finish with insertion sort
+#define RADIX_MAX_DEPTH 64        // Keys still tied after this many bytes finish with merge sort
+
+/*
+    Stable MSD radix sort on the key bytes, the same order as merge_sort. Keys are bucketed
+    by sign and magnitude through their tag and exponent bytes, then by packed digit pairs.
+    @param keys: sorted in place
+    @param scratch: at least count entries, reused across calls so a thread needs only one
+    @param count: number of keys
+ */
+void radix_sort(sort_key_t *keys, sort_key_t *scratch, int count);
+
+#endif // RADIX_H
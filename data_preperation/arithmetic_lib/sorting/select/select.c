@@ -0,0 +1,356 @@
+#include "select.h"
+#include "../merge/merge.h"
+#include "../radix/radix.h"
+#include "../../thread_pool/thread_pool.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INSERTION_CUTOFF 16
+#define NINTHER_CUTOFF 128
+#define SELECT_SERIAL_CUTOFF 16384   // Fewer keys than this are selected in one copy, no sampling
+
+// Keys from low to high inclusive, a NULL bound is open
+typedef struct {
+    const sort_key_t *low;
+    const sort_key_t *high;
+} bracket_t;
+
+typedef struct {
+    sort_key_t *keys;
+    size_t count;
+    size_t capacity;
+} key_vector_t;
+
+typedef struct {
+    const sort_key_t *run;
+    int run_size;
+    const bracket_t *brackets;
+    int num_brackets;
+
+    size_t *below;          // num_brackets + 1 counts: keys past bracket j - 1 and before bracket j, the last is above every bracket
+    key_vector_t *inside;   // Keys inside each bracket
+    bool failed;
+} partition_args_t;
+
+static inline void swap_keys(sort_key_t *a, sort_key_t *b) {
+    sort_key_t temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+static void insertion_sort(sort_key_t *keys, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        sort_key_t key = keys[i];
+        size_t j = i;
+        while (j > 0 && sort_key_compare(&key, &keys[j - 1]) < 0) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+static const sort_key_t *median_of_three(const sort_key_t *a, const sort_key_t *b, const sort_key_t *c) {
+    if (sort_key_compare(a, b) < 0) {
+        if (sort_key_compare(b, c) < 0) return b;
+        return sort_key_compare(a, c) < 0 ? c : a;
+    }
+    if (sort_key_compare(a, c) < 0) return a;
+    return sort_key_compare(b, c) < 0 ? c : b;
+}
+
+/*
+    Quickselect over [low, high) for every rank, falls back to sorting once depth runs out
+    @param ranks: absolute positions inside [low, high), ascending
+    @return false when the fallback sort can't allocate
+ */
+static bool introselect(sort_key_t *keys, size_t low, size_t high, const size_t *ranks, int num_ranks, int depth) {
+    while (num_ranks > 0) {
+        size_t count = high - low;
+        if (count <= INSERTION_CUTOFF) {
+            insertion_sort(keys + low, count);
+            return true;
+        }
+        if (depth-- == 0) return merge_sort(keys + low, (int)count);
+
+        // Ninther on larger ranges so sorted and organ-pipe inputs still split evenly
+        sort_key_t *base = keys + low;
+        size_t mid = count / 2, last = count - 1;
+        const sort_key_t *choice;
+        if (count >= NINTHER_CUTOFF) {
+            size_t step = count / 8;
+            choice = median_of_three(median_of_three(&base[0], &base[step], &base[2 * step]),
+                                     median_of_three(&base[mid - step], &base[mid], &base[mid + step]),
+                                     median_of_three(&base[last - 2 * step], &base[last - step], &base[last]));
+        } else {
+            choice = median_of_three(&base[0], &base[mid], &base[last]);
+        }
+        sort_key_t pivot = *choice;
+
+        // Three-way partition so runs of equal values settle at once: [low, lt) < pivot, [lt, gt) equal, [gt, high) >
+        size_t lt = low, i = low, gt = high;
+        while (i < gt) {
+            int cmp = sort_key_compare(&keys[i], &pivot);
+            if (cmp < 0) swap_keys(&keys[lt++], &keys[i++]);
+            else if (cmp > 0) swap_keys(&keys[i], &keys[--gt]);
+            else i++;
+        }
+
+        int below = 0;
+        while (below < num_ranks && ranks[below] < lt) below++;
+        int settled = below;
+        while (settled < num_ranks && ranks[settled] < gt) settled++;
+
+        if (below > 0 && !introselect(keys, low, lt, ranks, below, depth)) return false;
+
+        // Ranks past the equal run continue in the loop
+        ranks += settled;
+        num_ranks -= settled;
+        low = gt;
+    }
+    return true;
+}
+
+bool select_in_place(sort_key_t *keys, size_t count, const size_t *ranks, int num_ranks) {
+    int depth = 0;
+    for (size_t n = count; n > 1; n >>= 1) depth += 2;
+    return introselect(keys, 0, count, ranks, num_ranks, depth);
+}
+
+// Gather every run into one array and select there, for small inputs and unlucky samples
+static bool select_serial(sort_key_t **runs, const int *run_sizes, int num_runs, size_t total,
+                          const size_t *ranks, int num_ranks, sort_key_t *selected) {
+    sort_key_t *keys = malloc((total ? total : 1) * sizeof(sort_key_t));
+    if (!keys) {
+        fprintf(stderr, "Failed to allocate selection keys\n");
+        return false;
+    }
+
+    size_t at = 0;
+    for (int i = 0; i < num_runs; i++) {
+        memcpy(keys + at, runs[i], run_sizes[i] * sizeof(sort_key_t));
+        at += run_sizes[i];
+    }
+
+    bool success = select_in_place(keys, total, ranks, num_ranks);
+    for (int i = 0; success && i < num_ranks; i++) selected[i] = keys[ranks[i]];
+
+    free(keys);
+    return success;
+}
+
+static bool push_key(key_vector_t *vector, const sort_key_t *key) {
+    if (vector->count == vector->capacity) {
+        size_t capacity = vector->capacity ? vector->capacity * 2 : 64;
+        sort_key_t *grown = realloc(vector->keys, capacity * sizeof(sort_key_t));
+        if (!grown) return false;
+        vector->keys = grown;
+        vector->capacity = capacity;
+    }
+    vector->keys[vector->count++] = *key;
+    return true;
+}
+
+// One pass over a run: count the keys between brackets, keep the keys inside them
+static bool partition_run(partition_args_t *pargs) {
+    const bracket_t *brackets = pargs->brackets;
+    int num_brackets = pargs->num_brackets;
+
+    for (int k = 0; k < pargs->run_size; k++) {
+        const sort_key_t *key = &pargs->run[k];
+
+        // Brackets are disjoint and ascending, the first whose high bound is not below the key decides
+        int j = 0;
+        while (j < num_brackets && brackets[j].high && sort_key_compare(key, brackets[j].high) > 0) j++;
+
+        if (j < num_brackets && (!brackets[j].low || sort_key_compare(key, brackets[j].low) >= 0)) {
+            if (!push_key(&pargs->inside[j], key)) {
+                pargs->failed = true;
+                return false;
+            }
+        } else {
+            pargs->below[j]++;
+        }
+    }
+    return true;
+}
+
+// Pool task over runs [begin, end)
+static bool partition_runs(void *args, size_t begin, size_t end, int worker) {
+    partition_args_t *partitions = (partition_args_t *)args;
+    for (size_t i = begin; i < end; i++) {
+        if (!partition_run(&partitions[i])) return false;
+    }
+    return true;
+}
+
+static size_t isqrt(size_t n) {
+    size_t root = 0;
+    while ((root + 1) * (root + 1) <= n) root++;
+    return root;
+}
+
+// xorshift64, a fixed seed keeps repeated queries identical
+static inline uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+bool select_ranks(sort_key_t **runs, const int *run_sizes, int num_runs,
+                  const size_t *ranks, int num_ranks, sort_key_t *selected) {
+    size_t total = 0;
+    for (int i = 0; i < num_runs; i++) total += run_sizes[i];
+    if (num_ranks <= 0) return true;
+
+    if (num_runs == 1) {
+        if (!select_in_place(runs[0], total, ranks, num_ranks)) return false;
+        for (int i = 0; i < num_ranks; i++) selected[i] = runs[0][ranks[i]];
+        return true;
+    }
+    if (total < SELECT_SERIAL_CUTOFF) {
+        return select_serial(runs, run_sizes, num_runs, total, ranks, num_ranks, selected);
+    }
+
+    // Roughly 16 sqrt(n) samples, a rank lands within four standard deviations of its sample position
+    size_t sample_size = 16 * isqrt(total);
+    if (sample_size > total / 4) sample_size = total / 4;
+    size_t spread = 2 * isqrt(sample_size);
+
+    size_t *starts = malloc((num_runs + 1) * sizeof(size_t));
+    sort_key_t *sample = malloc(sample_size * sizeof(sort_key_t));
+    sort_key_t *sample_scratch = malloc(sample_size * sizeof(sort_key_t));
+    bracket_t *brackets = malloc(num_ranks * sizeof(bracket_t));
+    int *bracket_of = malloc(num_ranks * sizeof(int));
+    partition_args_t *partitions = calloc(num_runs, sizeof(partition_args_t));
+    size_t *before = NULL, *inside = NULL;
+    int num_brackets = 0;
+    bool success = false;
+
+    if (!starts || !sample || !sample_scratch || !brackets || !bracket_of || !partitions) {
+        fprintf(stderr, "Failed to allocate selection state\n");
+        goto cleanup;
+    }
+
+    starts[0] = 0;
+    for (int i = 0; i < num_runs; i++) starts[i + 1] = starts[i] + run_sizes[i];
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < sample_size; i++) {
+        size_t at = next_random(&state) % total;
+        int run = 0;
+        while (starts[run + 1] <= at) run++;
+        sample[i] = runs[run][at - starts[run]];
+    }
+    radix_sort(sample, sample_scratch, (int)sample_size);
+
+    // Neighbouring ranks whose brackets touch share one, so brackets never overlap
+    for (int i = 0; i < num_ranks; i++) {
+        size_t at = (size_t)((unsigned __int128)ranks[i] * sample_size / total);
+        const sort_key_t *low = at >= spread ? &sample[at - spread] : NULL;
+        const sort_key_t *high = at + spread < sample_size ? &sample[at + spread] : NULL;
+
+        bracket_t *last = num_brackets ? &brackets[num_brackets - 1] : NULL;
+        if (last && (!last->high || !low || sort_key_compare(low, last->high) <= 0)) {
+            last->high = high;
+        } else {
+            brackets[num_brackets++] = (bracket_t){ low, high };
+        }
+        bracket_of[i] = num_brackets - 1;
+    }
+
+    for (int i = 0; i < num_runs; i++) {
+        partitions[i] = (partition_args_t){ runs[i], run_sizes[i], brackets, num_brackets,
+                                            calloc(num_brackets + 1, sizeof(size_t)),
+                                            calloc(num_brackets, sizeof(key_vector_t)), false };
+        if (!partitions[i].below || !partitions[i].inside) {
+            fprintf(stderr, "Failed to allocate selection state\n");
+            goto cleanup;
+        }
+    }
+
+    // Each run is one pool task
+    if (!thread_pool_for(num_runs, 1, num_runs, partition_runs, partitions)) {
+        fprintf(stderr, "Failed to partition selection keys\n");
+        goto cleanup;
+    }
+
+    // Keys before each bracket and inside it across every run, then check each rank landed inside
+    before = calloc(num_brackets, sizeof(size_t));
+    inside = calloc(num_brackets, sizeof(size_t));
+    if (!before || !inside) {
+        fprintf(stderr, "Failed to allocate selection state\n");
+        goto cleanup;
+    }
+
+    size_t running = 0;
+    for (int j = 0; j < num_brackets; j++) {
+        for (int i = 0; i < num_runs; i++) {
+            running += partitions[i].below[j];
+            inside[j] += partitions[i].inside[j].count;
+        }
+        before[j] = running;
+        running += inside[j];
+    }
+
+    bool bracketed = true;
+    for (int i = 0; i < num_ranks; i++) {
+        int j = bracket_of[i];
+        if (ranks[i] < before[j] || ranks[i] >= before[j] + inside[j]) bracketed = false;
+    }
+
+    if (!bracketed) {
+        success = select_serial(runs, run_sizes, num_runs, total, ranks, num_ranks, selected);
+    } else {
+        success = true;
+        for (int first = 0; first < num_ranks && success;) {
+            int j = bracket_of[first];
+            int last = first;
+            while (last < num_ranks && bracket_of[last] == j) last++;
+
+            sort_key_t *keys = malloc(inside[j] * sizeof(sort_key_t));
+            size_t *local = malloc((last - first) * sizeof(size_t));
+            if (keys && local) {
+                size_t at = 0;
+                for (int i = 0; i < num_runs; i++) {
+                    memcpy(keys + at, partitions[i].inside[j].keys, partitions[i].inside[j].count * sizeof(sort_key_t));
+                    at += partitions[i].inside[j].count;
+                }
+                for (int i = first; i < last; i++) local[i - first] = ranks[i] - before[j];
+
+                success = select_in_place(keys, inside[j], local, last - first);
+                for (int i = first; success && i < last; i++) selected[i] = keys[local[i - first]];
+            } else {
+                fprintf(stderr, "Failed to allocate selection keys\n");
+                success = false;
+            }
+            free(keys);
+            free(local);
+            first = last;
+        }
+    }
+
+cleanup:
+    if (partitions) {
+        for (int i = 0; i < num_runs; i++) {
+            if (partitions[i].inside) {
+                for (int j = 0; j < num_brackets; j++) free(partitions[i].inside[j].keys);
+            }
+            free(partitions[i].inside);
+            free(partitions[i].below);
+        }
+    }
+    free(before);
+    free(inside);
+    free(starts);
+    free(sample);
+    free(sample_scratch);
+    free(brackets);
+    free(bracket_of);
+    free(partitions);
+    return success;
+}
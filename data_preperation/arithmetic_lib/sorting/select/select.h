@@ -0,0 +1,35 @@
+#ifndef SELECT_H
+#define SELECT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "../sort_key/sort_key.h"
+
+/*
+    Order statistics of keys split across unsorted runs, in expected linear time and
+    without sorting or merging the runs.
+
+    A sorted random sample brackets every requested rank between two splitters, one
+    thread per run then counts the keys below each bracket and collects the keys inside
+    it, and introselect finishes on the small bracket. Several ranks share the one pass.
+ */
+
+/*
+    @param runs: key runs, reordered in place
+    @param run_sizes: keys in each run
+    @param ranks: 0-based ranks in ascending order, each below the total key count
+    @param selected: out, the key at each rank
+    @return false on allocation failure
+ */
+bool select_ranks(sort_key_t **runs, const int *run_sizes, int num_runs,
+                  const size_t *ranks, int num_ranks, sort_key_t *selected);
+
+/*
+    Introselect on one array: afterwards keys[rank] holds the key of that rank for every
+    requested rank, with smaller keys before it and larger ones after
+    @param ranks: ascending, each below count
+    @return false on allocation failure
+ */
+bool select_in_place(sort_key_t *keys, size_t count, const size_t *ranks, int num_ranks);
+
+#endif // SELECT_H
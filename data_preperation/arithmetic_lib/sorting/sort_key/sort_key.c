@@ -0,0 +1,242 @@
+#include "sort_key.h"
+#include "../../decimal/decimal.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Tags order the classes: negatives, zero, positives, then text
+#define TAG_NEGATIVE 0x40
+#define TAG_ZERO     0x80
+#define TAG_POSITIVE 0xC0
+#define TAG_TEXT     0xFF
+
+static inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static size_t encode_text(const char *str, size_t len, unsigned char *key) {
+    key[0] = TAG_TEXT;
+    memcpy(key + 1, str, len);
+    return len + 1;
+}
+
+size_t sort_key_encode(const char *str, size_t len, unsigned char *key) {
+    const char *text = str, *end = str + len;
+    while (str < end && isspace((unsigned char)*str)) str++;
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+
+    if (str == end) {
+        key[0] = TAG_ZERO;
+        return 1;
+    }
+
+    // Same grammar as decimal_parse, anything else is text
+    bool negative = false;
+    if (*str == '+' || *str == '-') {
+        negative = *str == '-';
+        str++;
+    }
+
+    const char *integer = str;
+    while (str < end && is_digit(*str)) str++;
+    const char *integer_end = str;
+
+    const char *fraction = str, *fraction_end = str;
+    if (str < end && *str == '.') {
+        fraction = ++str;
+        while (str < end && is_digit(*str)) str++;
+        fraction_end = str;
+    }
+    if (integer == integer_end && fraction == fraction_end) return encode_text(text, len, key);
+
+    long exponent = 0;
+    if (str < end && (*str == 'e' || *str == 'E')) {
+        str++;
+        bool exponent_negative = false;
+        if (str < end && (*str == '+' || *str == '-')) exponent_negative = *str++ == '-';
+
+        const char *exponent_start = str;
+        for (; str < end && is_digit(*str); str++) {
+            if (exponent <= DECIMAL_MAX_EXPONENT) exponent = exponent * 10 + (*str - '0');
+        }
+        if (str == exponent_start || exponent > DECIMAL_MAX_EXPONENT) return encode_text(text, len, key);
+        if (exponent_negative) exponent = -exponent;
+    }
+    if (str != end) return encode_text(text, len, key);
+
+    // Significant digits run from the first to the last non-zero digit, the point is stepped over
+    const char *point_at = integer_end < fraction ? integer_end : NULL;
+    const char *last = (fraction_end > fraction ? fraction_end : integer_end) - 1;
+    while (last >= integer && (*last == '0' || last == point_at)) last--;
+    if (last < integer) {
+        key[0] = TAG_ZERO;
+        return 1;
+    }
+    const char *first = integer;
+    while (*first == '0' || first == point_at) first++;
+
+    // value = 0.d1 d2 ... * 10^point, a larger point is a larger magnitude
+    long point = (first < integer_end ? (long)(integer_end - first) : -(long)(first - fraction)) + exponent;
+    uint32_t biased = (uint32_t)(int32_t)point ^ 0x80000000u;
+    unsigned char flip = negative ? 0xFF : 0x00;
+
+    key[0] = negative ? TAG_NEGATIVE : TAG_POSITIVE;
+    key[1] = (unsigned char)(biased >> 24) ^ flip;
+    key[2] = (unsigned char)(biased >> 16) ^ flip;
+    key[3] = (unsigned char)(biased >> 8) ^ flip;
+    key[4] = (unsigned char)biased ^ flip;
+
+    // Pairs are 1 to 100 so the 0 terminator sorts a value before its extensions
+    size_t length = 5;
+    for (const char *digit = first; digit <= last;) {
+        int pair = (*digit++ - '0') * 10;
+        if (digit == point_at) digit++;
+        if (digit <= last) {
+            pair += *digit++ - '0';
+            if (digit == point_at) digit++;
+        }
+        key[length++] = (unsigned char)(1 + pair) ^ flip;
+    }
+    key[length++] = flip;
+
+    return length;
+}
+
+// Every key sits in at least SORT_KEY_BOUND bytes, so eight can be loaded and the tail masked off
+static inline uint64_t key_prefix(const unsigned char *key, size_t length) {
+    uint64_t prefix;
+    memcpy(&prefix, key, sizeof(prefix));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    prefix = __builtin_bswap64(prefix);
+#endif
+    return length >= 8 ? prefix : prefix & ~(UINT64_MAX >> (length * 8));
+}
+
+bool sort_keys_encode(sort_key_t *entries, unsigned char **bytes, const columnar_subregion_t *region,
+                      size_t start, size_t end) {
+    // Size the arena once so entries can point straight into it
+    size_t total = 0;
+    for (size_t i = start; i < end; i++) {
+        size_t length = strlen(columnar_value(region, i));
+        entries[i - start].length = (uint32_t)length;
+        total += SORT_KEY_BOUND(length);
+    }
+
+    *bytes = malloc(total ? total : 1);
+    if (!*bytes) {
+        fprintf(stderr, "Failed to allocate sort key bytes\n");
+        return false;
+    }
+
+    unsigned char *cursor = *bytes;
+    for (size_t i = start; i < end; i++) {
+        sort_key_t *entry = &entries[i - start];
+        size_t length = sort_key_encode(columnar_value(region, i), entry->length, cursor);
+
+        *entry = (sort_key_t){ key_prefix(cursor, length), cursor, (uint32_t)length, region->offsets[i] };
+        cursor += length;
+    }
+
+    return true;
+}
+
+bool sort_key_arena_append(sort_key_arena_t *arena, sort_key_t *entries, size_t num_entries,
+                           const char *str, size_t len, size_t value) {
+    size_t needed = arena->size + SORT_KEY_BOUND(len);
+    if (needed > arena->capacity) {
+        size_t capacity = arena->capacity ? arena->capacity * 2 : 4096;
+        while (capacity < needed) capacity *= 2;
+
+        // A fresh arena rather than realloc, so the old one is still there to repoint the entries from
+        unsigned char *bytes = malloc(capacity);
+        if (!bytes) {
+            fprintf(stderr, "Failed to grow sort key arena\n");
+            return false;
+        }
+        if (arena->size) memcpy(bytes, arena->bytes, arena->size);
+        for (size_t i = 0; i < num_entries; i++) entries[i].key = bytes + (entries[i].key - arena->bytes);
+
+        free(arena->bytes);
+        arena->bytes = bytes;
+        arena->capacity = capacity;
+    }
+
+    unsigned char *cursor = arena->bytes + arena->size;
+    size_t length = sort_key_encode(str, len, cursor);
+    entries[num_entries] = (sort_key_t){ key_prefix(cursor, length), cursor, (uint32_t)length, value };
+    arena->size += length;
+    return true;
+}
+
+bool sort_keys_build(sort_keys_t *keys, const columnar_subregion_t *region, size_t start, size_t end) {
+    size_t count = end > start ? end - start : 0;
+    keys->count = (int)count;
+    keys->bytes = NULL;
+    keys->entries = malloc((count ? count : 1) * sizeof(sort_key_t));
+    if (!keys->entries) {
+        fprintf(stderr, "Failed to allocate sort keys\n");
+        return false;
+    }
+
+    if (!sort_keys_encode(keys->entries, &keys->bytes, region, start, end)) {
+        sort_keys_free(keys);
+        return false;
+    }
+    return true;
+}
+
+void sort_keys_free(sort_keys_t *keys) {
+    if (!keys) return;
+    free(keys->entries);
+    free(keys->bytes);
+    keys->entries = NULL;
+    keys->bytes = NULL;
+    keys->count = 0;
+}
+
+void sort_key_buffer_init(sort_key_buffer_t *buffer) {
+    buffer->key = (sort_key_t){ 0 };
+    buffer->bytes = NULL;
+    buffer->capacity = 0;
+}
+
+void sort_key_buffer_free(sort_key_buffer_t *buffer) {
+    if (!buffer) return;
+    free(buffer->bytes);
+    sort_key_buffer_init(buffer);
+}
+
+static bool reserve(sort_key_buffer_t *buffer, size_t capacity) {
+    if (capacity <= buffer->capacity) return true;
+
+    unsigned char *grown = realloc(buffer->bytes, capacity);
+    if (!grown) {
+        fprintf(stderr, "Failed to allocate sort key buffer\n");
+        return false;
+    }
+    buffer->bytes = grown;
+    buffer->capacity = capacity;
+    return true;
+}
+
+bool sort_key_buffer_set(sort_key_buffer_t *buffer, const char *str, size_t len) {
+    if (!reserve(buffer, SORT_KEY_BOUND(len))) return false;
+
+    size_t length = sort_key_encode(str, len, buffer->bytes);
+    buffer->key = (sort_key_t){ key_prefix(buffer->bytes, length), buffer->bytes, (uint32_t)length, 0 };
+    return true;
+}
+
+bool sort_key_buffer_copy(sort_key_buffer_t *dest, const sort_key_buffer_t *src) {
+    if (dest == src) return true;
+    return sort_key_buffer_assign(dest, &src->key);
+}
+
+bool sort_key_buffer_assign(sort_key_buffer_t *dest, const sort_key_t *key) {
+    if (!reserve(dest, key->length ? key->length : 1)) return false;
+
+    memcpy(dest->bytes, key->key, key->length);
+    dest->key = *key;
+    dest->key.key = dest->bytes;
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef SORT_KEY_H
+#define SORT_KEY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../../columnar/columnar.h"
+
+/*
+    Order-preserving binary keys: memcmp of two keys, then the shorter first, orders the
+    values numerically across sign, magnitude and fraction, the same as compare_big_numbers.
+
+    A number is a tag byte, a 4-byte decimal exponent and its significant digits packed two
+    to a byte, closed by a terminator. Negative numbers store the complement so larger
+    magnitudes sort first. Zero in any spelling is the single zero tag, blank cells count as
+    zero like they do for the mean, and text that is not a number sorts after every number.
+ */
+
+// Bytes to reserve for the key of a value of length characters, room for the key plus an 8-byte prefix load
+#define SORT_KEY_BOUND(length) ((length) + 8)
+
+/*
+    @param str: characters of the value, need not be NUL-terminated
+    @param key: out, at least SORT_KEY_BOUND(len) bytes
+    @return key length
+ */
+size_t sort_key_encode(const char *str, size_t len, unsigned char *key);
+
+// One value's key with its first eight bytes as a big-endian integer, zero padded
+typedef struct {
+    uint64_t prefix;
+    const unsigned char *key;
+    uint32_t length;
+    size_t value;   // Offset of the value in the subregion arena
+} sort_key_t;
+
+static inline int sort_key_compare(const sort_key_t *a, const sort_key_t *b) {
+    if (a->prefix != b->prefix) return a->prefix < b->prefix ? -1 : 1;
+
+    // Equal prefixes cover every byte of keys up to eight long
+    uint32_t shorter = a->length < b->length ? a->length : b->length;
+    if (shorter > 8) {
+        int cmp = memcmp(a->key + 8, b->key + 8, shorter - 8);
+        if (cmp) return cmp < 0 ? -1 : 1;
+    }
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+// Keys of a stretch of subregion values, all in one byte arena
+typedef struct {
+    sort_key_t *entries;
+    unsigned char *bytes;
+    int count;
+} sort_keys_t;
+
+/*
+    Encode the column-major values [start, end) of the region, entries follow index order
+    @return false on allocation failure
+ */
+bool sort_keys_build(sort_keys_t *keys, const columnar_subregion_t *region, size_t start, size_t end);
+
+/*
+    sort_keys_build into entries the caller owns, so one array can be filled a block at a time
+    @param entries: out, end - start entries in index order
+    @param bytes: out, the keys' arena, the caller frees it
+ */
+bool sort_keys_encode(sort_key_t *entries, unsigned char **bytes, const columnar_subregion_t *region,
+                      size_t start, size_t end);
+void sort_keys_free(sort_keys_t *keys);
+
+// Byte arena keys are appended to one value at a time, for passes that don't know the lengths up front
+typedef struct {
+    unsigned char *bytes;
+    size_t size;
+    size_t capacity;
+} sort_key_arena_t;
+
+/*
+    Encode a value's key at the end of the arena into entries[num_entries]
+    @param entries: keys appended so far, repointed when the arena has to move
+    @param value: offset of the value in the subregion arena
+    @return false on allocation failure
+ */
+bool sort_key_arena_append(sort_key_arena_t *arena, sort_key_t *entries, size_t num_entries,
+                           const char *str, size_t len, size_t value);
+
+// Reusable key of a single value, for running max and min scans
+typedef struct {
+    sort_key_t key;
+    unsigned char *bytes;
+    size_t capacity;
+} sort_key_buffer_t;
+
+void sort_key_buffer_init(sort_key_buffer_t *buffer);
+void sort_key_buffer_free(sort_key_buffer_t *buffer);
+
+// @return false on allocation failure
+bool sort_key_buffer_set(sort_key_buffer_t *buffer, const char *str, size_t len);
+bool sort_key_buffer_copy(sort_key_buffer_t *dest, const sort_key_buffer_t *src);
+bool sort_key_buffer_assign(sort_key_buffer_t *dest, const sort_key_t *key);
+
+#endif // SORT_KEY_H
@@ -1,81 +1,307 @@
 #include "statistical_ops.h"
 #include "../fat_data/fat_data.h"
+#include "../bignum/bignum.h"
 #include "../hashmap/hashmap.h"
+#include "../sorting/sort_key/sort_key.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <float.h>  // For DBL_MIN
 #include <errno.h>
 
-void compute_local_max(char **chunk, int chunk_size, char *result) {
-    if (!chunk || chunk_size <= 0 || !result) {
-        if (result) result[0] = '\0';
-        fprintf(stderr, "Invalid call to compute local max function\n");
-        return;
+// Index range of block b clipped to [start, end)
+static inline void block_range(size_t b, size_t start, size_t end, size_t *from, size_t *to) {
+    size_t block_start = b * COLUMNAR_BLOCK_VALUES;
+    *from = block_start > start ? block_start : start;
+    *to = block_start + COLUMNAR_BLOCK_VALUES < end ? block_start + COLUMNAR_BLOCK_VALUES : end;
+}
+
+void sum_accumulator_init(sum_accumulator_t *sum) {
+    sum->native = 0;
+    bignum_init(&sum->spill);
+    decimal_init(&sum->decimals);
+    decimal_init(&sum->parsed);
+    bignum_init(&sum->scratch);
+    sum->invalid = false;
+}
+
+void sum_accumulator_free(sum_accumulator_t *sum) {
+    bignum_free(&sum->spill);
+    decimal_free(&sum->decimals);
+    decimal_free(&sum->parsed);
+    bignum_free(&sum->scratch);
+}
+
+// Native part of the sum plus value, spilling the native part first when that overflows
+static inline bool add_native(sum_accumulator_t *sum, __int128 value) {
+    __int128 next;
+    if (__builtin_add_overflow(sum->native, value, &next)) {
+        if (!bignum_add_int128(&sum->spill, sum->native, &sum->scratch)) return false;
+        next = value;
     }
+    sum->native = next;
+    return true;
+}
 
-    char *current_result = chunk[0];
+bool sum_accumulator_add_int64(sum_accumulator_t *sum, int64_t value) {
+    return add_native(sum, value);
+}
 
-    for (int i = 1; i < chunk_size; i++) {
-        if (compare_big_numbers(chunk[i], current_result) == 1) {
-            current_result = chunk[i];
-        }
+bool sum_accumulator_add_text(sum_accumulator_t *sum, const char *str, size_t len) {
+    if (sum->invalid) return true;
+
+    int64_t value;
+    switch (classify_number(str, len, &value)) {
+        case NUMBER_INT64:
+            return add_native(sum, value);
+        case NUMBER_BIGINT:
+            return bignum_parse(&sum->scratch, str, len) && bignum_add(&sum->spill, &sum->spill, &sum->scratch);
+        default:
+            // Fractions, exponents, spaces and empty cells
+            if (!decimal_parse(&sum->parsed, str, len)) sum->invalid = true;
+            else if (!decimal_add(&sum->decimals, &sum->parsed, &sum->scratch)) return false;
+            return true;
     }
+}
 
-    strncpy(result, current_result, MAX_NUMBER_LENGTH - 1);
-    result[MAX_NUMBER_LENGTH - 1] = '\0';
+bool sum_accumulator_merge(sum_accumulator_t *dest, const sum_accumulator_t *src) {
+    dest->invalid = dest->invalid || src->invalid;
+    return add_native(dest, src->native) &&
+           bignum_add(&dest->spill, &dest->spill, &src->spill) &&
+           decimal_add(&dest->decimals, &src->decimals, &dest->scratch);
+}
 
-    return;
+// Fold the native and integer parts into the decimal part
+static bool fold_sum(sum_accumulator_t *sum) {
+    if (!bignum_add_int128(&sum->spill, sum->native, &sum->scratch)) return false;
+    sum->native = 0;
+
+    if (!decimal_add_integer(&sum->decimals, &sum->spill, &sum->scratch)) return false;
+    bignum_set_zero(&sum->spill);
+    return true;
 }
 
-void compute_local_min(char **chunk, int chunk_size, char *result) {
-    if (!chunk || chunk_size <= 0 || !result) {
-        if (result) result[0] = '\0';
-        fprintf(stderr, "Invalid call to compute local min function\n");
-        return;
+bool sum_accumulator_format(sum_accumulator_t *sum, char *out, size_t size) {
+    if (sum->invalid) {
+        snprintf(out, size, "NaN");
+        return true;
     }
 
-    char *current_result = chunk[0];
+    // Integer sums that never spilled format straight from the native part
+    if (bignum_is_zero(&sum->spill) && bignum_is_zero(&sum->decimals.mantissa)) {
+        unsigned __int128 magnitude = sum->native < 0 ? 0 - (unsigned __int128)sum->native : (unsigned __int128)sum->native;
+        char digits[48];
+        int length = 0;
+        do {
+            digits[length++] = (char)('0' + (int)(magnitude % 10));
+            magnitude /= 10;
+        } while (magnitude);
 
-    for (int i = 1; i < chunk_size; i++) {
-        if (compare_big_numbers(chunk[i], current_result) == -1) {
-            current_result = chunk[i];
-        }
+        size_t needed = (size_t)length + (sum->native < 0) + 1;
+        if (needed > size) return false;
+
+        char *cursor = out;
+        if (sum->native < 0) *cursor++ = '-';
+        while (length) *cursor++ = digits[--length];
+        *cursor = '\0';
+        return true;
     }
 
-    strncpy(result, current_result, MAX_NUMBER_LENGTH - 1);
-    result[MAX_NUMBER_LENGTH - 1] = '\0'; // Pretty sure strncpy delimits by default
+    return fold_sum(sum) && decimal_to_string(&sum->decimals, out, size);
+}
+
+bool sum_accumulator_mean(sum_accumulator_t *sum, long long count, int precision, char *out, size_t size) {
+    if (sum->invalid) {
+        snprintf(out, size, "NaN");
+        return true;
+    }
+    if (!fold_sum(sum)) return false;
 
-    return;
+    decimal_t divisor;
+    decimal_init(&divisor);
+    bool ok = bignum_set_int64(&divisor.mantissa, count) &&
+              decimal_divide(&sum->decimals, &divisor, precision, out, size);
+    decimal_free(&divisor);
+
+    return ok;
 }
 
-void compute_local_sum(char **chunk, int chunk_size, char *result) {
-    char temp_result[MAX_NUMBER_LENGTH] = "0";
-    char temp_sum[MAX_NUMBER_LENGTH];
+// One hash per cell picks its partition, and one probe there finds the key or the slot it goes in
+static inline bool count_value(hashmap_t **partitions, int num_partitions, const char *value, size_t length) {
+    if (length == 0) return true;
 
-    for (int i = 0; i < chunk_size; i++) {
-        add_big_integers(temp_result, chunk[i], temp_sum); // temp_sum = temp_result + chunk[i]
-        strncpy(temp_result, temp_sum, MAX_NUMBER_LENGTH); // update temp_result
-    }
+    uint64_t hash = hashmap_hash(value, length);
+    return hashmap_add_hashed(partitions[hashmap_partition(hash, num_partitions)], hash, value, length, 1);
+}
 
-    strncpy(result, temp_result, MAX_NUMBER_LENGTH);
+static void running_extreme_init(running_extreme_t *extreme) {
+    extreme->set = false;
+    extreme->index = 0;
+    extreme->native = false;
+    extreme->encoded = false;
+    sort_key_buffer_init(&extreme->key);
+}
 
-    return;
+void local_aggregate_init(local_aggregate_t *aggregate) {
+    aggregate->num_values = 0;
+    running_extreme_init(&aggregate->max);
+    running_extreme_init(&aggregate->min);
+    sum_accumulator_init(&aggregate->sum);
+    aggregate->partitions = NULL;
+    aggregate->num_partitions = 0;
+    sort_key_buffer_init(&aggregate->candidate);
 }
 
+void local_aggregate_free(local_aggregate_t *aggregate) {
+    sort_key_buffer_free(&aggregate->max.key);
+    sort_key_buffer_free(&aggregate->min.key);
+    sum_accumulator_free(&aggregate->sum);
+    sort_key_buffer_free(&aggregate->candidate);
+}
 
-void compute_local_counts(char **chunk, int chunk_size, hashmap_t *freq_map) {
-    if (!chunk || chunk_size <= 0 || !freq_map) {
-        fprintf(stderr, "Invalid call to compute local counts function\n");
-        return;
+/*
+    Offer the value at index to a running extreme, it wins further in direction or equal at a lower index
+    @param key: the value's key, NULL to encode it only if a comparison needs it
+ */
+static bool offer_extreme(local_aggregate_t *aggregate, running_extreme_t *best, const columnar_subregion_t *region,
+                          size_t index, bool native, const sort_key_t *key, int direction) {
+    int cmp = direction;
+    if (best->set) {
+        if (native && best->native) {
+            int64_t value = region->ints[index], held = region->ints[best->index];
+            cmp = (value > held) - (value < held);
+        } else {
+            if (!best->encoded) {
+                const char *held = columnar_value(region, best->index);
+                if (!sort_key_buffer_set(&best->key, held, strlen(held))) return false;
+                best->encoded = true;
+            }
+            if (!key) {
+                const char *value = columnar_value(region, index);
+                if (!sort_key_buffer_set(&aggregate->candidate, value, strlen(value))) return false;
+                key = &aggregate->candidate.key;
+            }
+            cmp = sort_key_compare(key, &best->key.key);
+        }
+        if (cmp == 0 && index < best->index) cmp = direction;
     }
+    if (cmp != direction) return true;
+
+    best->set = true;
+    best->index = index;
+    best->native = native;
+    best->encoded = key && sort_key_buffer_assign(&best->key, key);
+    return true;
+}
+
+/*
+    The fused pass, folds is a constant in each instantiation below so every
+    test of it folds away and only the requested work is left in the loops
+ */
+static inline __attribute__((always_inline)) bool aggregate_values(local_aggregate_t *aggregate, const int folds,
+    const columnar_subregion_t *region, size_t start, size_t end, sort_key_t *keys, sort_key_arena_t *arena) {
+
+    const bool want_max = folds & AGGREGATE_MAX;
+    const bool want_min = folds & AGGREGATE_MIN;
+    const bool want_sum = folds & AGGREGATE_SUM;
+    const bool want_keys = folds & AGGREGATE_KEYS;
+    const bool want_counts = folds & AGGREGATE_COUNTS;
+
+    for (size_t b = start / COLUMNAR_BLOCK_VALUES; b * COLUMNAR_BLOCK_VALUES < end; b++) {
+        size_t from, to;
+        block_range(b, start, end, &from, &to);
 
-    for (int i = 0; i < chunk_size; i++) {
-        if (chunk[i] && strlen(chunk[i]) > 0) {
-            int count = hashmap_get(freq_map, chunk[i]);
-            hashmap_put(freq_map, chunk[i], count + 1);
+        if (region->block_classes[b] == NUMBER_INT64) {
+            const int64_t *ints = region->ints;
+            size_t block_max = from, block_min = from;
+            __int128 block_sum = 0;
+
+            for (size_t i = from; i < to; i++) {
+                int64_t value = ints[i];
+                if (want_max && value > ints[block_max]) block_max = i;
+                if (want_min && value < ints[block_min]) block_min = i;
+                if (want_sum) block_sum += value;
+
+                // Only keys and counts need the text
+                if (want_keys || want_counts) {
+                    const char *cell = columnar_value(region, i);
+                    size_t length = strlen(cell);
+                    if (want_keys && !sort_key_arena_append(arena, keys, i - start, cell, length, region->offsets[i])) return false;
+                    if (want_counts && !count_value(aggregate->partitions, aggregate->num_partitions, cell, length)) return false;
+                }
+            }
+
+            // int64 values can't overflow an __int128 before 2^63 of them are added, check per block
+            if (want_sum && !add_native(&aggregate->sum, block_sum)) return false;
+            if (want_max && !offer_extreme(aggregate, &aggregate->max, region, block_max, true,
+                                           want_keys ? &keys[block_max - start] : NULL, 1)) return false;
+            if (want_min && !offer_extreme(aggregate, &aggregate->min, region, block_min, true,
+                                           want_keys ? &keys[block_min - start] : NULL, -1)) return false;
+            continue;
         }
+
+        for (size_t i = from; i < to; i++) {
+            const char *cell = columnar_value(region, i);
+            size_t length = strlen(cell);
+
+            // One key per cell serves the median, the max and the min
+            const sort_key_t *key = NULL;
+            if (want_keys) {
+                if (!sort_key_arena_append(arena, keys, i - start, cell, length, region->offsets[i])) return false;
+                key = &keys[i - start];
+            } else if (want_max || want_min) {
+                if (!sort_key_buffer_set(&aggregate->candidate, cell, length)) return false;
+                key = &aggregate->candidate.key;
+            }
+
+            if (want_max && !offer_extreme(aggregate, &aggregate->max, region, i, false, key, 1)) return false;
+            if (want_min && !offer_extreme(aggregate, &aggregate->min, region, i, false, key, -1)) return false;
+            if (want_sum && !sum_accumulator_add_text(&aggregate->sum, cell, length)) return false;
+            if (want_counts && !count_value(aggregate->partitions, aggregate->num_partitions, cell, length)) return false;
+        }
+    }
+
+    aggregate->num_values += end - start;
+    return true;
+}
+
+typedef bool (*aggregate_variant_t)(local_aggregate_t *, const columnar_subregion_t *, size_t, size_t,
+                                    sort_key_t *, sort_key_arena_t *);
+
+#define AGGREGATE_VARIANT(folds)                                                                  \
+    static bool aggregate_values_##folds(local_aggregate_t *aggregate, const columnar_subregion_t *region, \
+        size_t start, size_t end, sort_key_t *keys, sort_key_arena_t *arena) {                    \
+        return aggregate_values(aggregate, folds, region, start, end, keys, arena);               \
     }
-    
-    return;
+
+AGGREGATE_VARIANT(0)  AGGREGATE_VARIANT(1)  AGGREGATE_VARIANT(2)  AGGREGATE_VARIANT(3)
+AGGREGATE_VARIANT(4)  AGGREGATE_VARIANT(5)  AGGREGATE_VARIANT(6)  AGGREGATE_VARIANT(7)
+AGGREGATE_VARIANT(8)  AGGREGATE_VARIANT(9)  AGGREGATE_VARIANT(10) AGGREGATE_VARIANT(11)
+AGGREGATE_VARIANT(12) AGGREGATE_VARIANT(13) AGGREGATE_VARIANT(14) AGGREGATE_VARIANT(15)
+AGGREGATE_VARIANT(16) AGGREGATE_VARIANT(17) AGGREGATE_VARIANT(18) AGGREGATE_VARIANT(19)
+AGGREGATE_VARIANT(20) AGGREGATE_VARIANT(21) AGGREGATE_VARIANT(22) AGGREGATE_VARIANT(23)
+AGGREGATE_VARIANT(24) AGGREGATE_VARIANT(25) AGGREGATE_VARIANT(26) AGGREGATE_VARIANT(27)
+AGGREGATE_VARIANT(28) AGGREGATE_VARIANT(29) AGGREGATE_VARIANT(30) AGGREGATE_VARIANT(31)
+
+static const aggregate_variant_t aggregate_variants[AGGREGATE_VARIANTS] = {
+    aggregate_values_0,  aggregate_values_1,  aggregate_values_2,  aggregate_values_3,
+    aggregate_values_4,  aggregate_values_5,  aggregate_values_6,  aggregate_values_7,
+    aggregate_values_8,  aggregate_values_9,  aggregate_values_10, aggregate_values_11,
+    aggregate_values_12, aggregate_values_13, aggregate_values_14, aggregate_values_15,
+    aggregate_values_16, aggregate_values_17, aggregate_values_18, aggregate_values_19,
+    aggregate_values_20, aggregate_values_21, aggregate_values_22, aggregate_values_23,
+    aggregate_values_24, aggregate_values_25, aggregate_values_26, aggregate_values_27,
+    aggregate_values_28, aggregate_values_29, aggregate_values_30, aggregate_values_31,
+};
+
+bool compute_local_aggregate(local_aggregate_t *aggregate, int folds, const columnar_subregion_t *region,
+                             size_t start, size_t end, sort_key_t *keys, sort_key_arena_t *arena) {
+    if (!aggregate || !region || start >= end || folds < 0 || folds >= AGGREGATE_VARIANTS ||
+        ((folds & AGGREGATE_KEYS) && (!keys || !arena)) ||
+        ((folds & AGGREGATE_COUNTS) && (!aggregate->partitions || aggregate->num_partitions < 1))) {
+        fprintf(stderr, "Invalid call to compute local aggregate function\n");
+        return false;
+    }
+
+    return aggregate_variants[folds](aggregate, region, start, end, keys, arena);
 }
\ No newline at end of file
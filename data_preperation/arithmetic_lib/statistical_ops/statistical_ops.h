@@ -2,12 +2,93 @@
 #define STATISTICAL_OPS_H
 
 #include <stddef.h> // for size_t
+#include <stdbool.h>
 #include "../hashmap/hashmap.h"
+#include "../columnar/columnar.h"
+#include "../bignum/bignum.h"
+#include "../decimal/decimal.h"
+#include "../sorting/sort_key/sort_key.h"
+
+/*
+    Running sum for the mean. Integers add into a native __int128 and only spill into
+    the limb bignum when that would overflow or a value doesn't fit in int64. Values with
+    a fraction or exponent add exactly into a scaled decimal.
+ */
+typedef struct {
+    __int128 native;
+    bignum_t spill;
+    decimal_t decimals;
+    decimal_t parsed;  // Scratch for the value being added
+    bignum_t scratch;
+    bool invalid;      // A value was not a number, the sum is NaN
+} sum_accumulator_t;
+
+void sum_accumulator_init(sum_accumulator_t *sum);
+void sum_accumulator_free(sum_accumulator_t *sum);
+
+// All return false only on allocation failure
+bool sum_accumulator_add_int64(sum_accumulator_t *sum, int64_t value);
+bool sum_accumulator_add_text(sum_accumulator_t *sum, const char *str, size_t len);
+
+// dest += src, src is left unchanged
+bool sum_accumulator_merge(sum_accumulator_t *dest, const sum_accumulator_t *src);
+
+/*
+    Decimal text of the sum, "NaN" when a value was not a number
+    @return false when the sum does not fit in size or on allocation failure
+ */
+bool sum_accumulator_format(sum_accumulator_t *sum, char *out, size_t size);
+
+/*
+    Sum divided by count with precision fraction digits, formatted like divide_big_decimals
+    @return false when the result does not fit in size or on allocation failure
+ */
+bool sum_accumulator_mean(sum_accumulator_t *sum, long long count, int precision, char *out, size_t size);
 
-void compute_local_max(char **chunk, int chunk_size, char *result);
-void compute_local_min(char **chunk, int chunk_size, char *result);
-void compute_local_sum(char **chunk, int chunk_size, char *result);
-void compute_local_counts(char **chunk, int chunk_size, hashmap_t *freq_map);
 // void compute_median(char **subregion, int subregion_size, char *result);
 
+// What a fused pass folds each value into, any combination of these
+#define AGGREGATE_MAX    1
+#define AGGREGATE_MIN    2
+#define AGGREGATE_SUM    4
+#define AGGREGATE_KEYS   8    // The sort key of every value, for median and quantiles
+#define AGGREGATE_COUNTS 16   // Frequencies, for mode
+#define AGGREGATE_VARIANTS 32
+
+// Running max or min of a fused pass
+typedef struct {
+    bool set;
+    size_t index;             // Column-major index, the lower one on ties
+    bool native;              // Its block is NUMBER_INT64, so ints[index] holds it
+    bool encoded;             // key holds its sort key
+    sort_key_buffer_t key;
+} running_extreme_t;
+
+// Everything the fused passes of one worker folded together
+typedef struct {
+    size_t num_values;
+    running_extreme_t max;
+    running_extreme_t min;
+    sum_accumulator_t sum;
+    hashmap_t **partitions;       // For AGGREGATE_COUNTS, set by the caller, split by hashmap_partition
+    int num_partitions;
+    sort_key_buffer_t candidate;  // Key of the value being compared when keys aren't kept
+} local_aggregate_t;
+
+void local_aggregate_init(local_aggregate_t *aggregate);
+// Frees the sum and key buffers, the partitions belong to the caller
+void local_aggregate_free(local_aggregate_t *aggregate);
+
+/*
+    Fold the values [start, end) into aggregate in a single visit per value: each cell's
+    length is read once and shared by its key, its sum and its count, int64 blocks fold
+    max, min and sum natively. There is one compiled loop per combination of folds, so
+    the loops don't test which folds are on.
+    @param folds: AGGREGATE_* flags
+    @param keys: with AGGREGATE_KEYS, out, end - start keys in index order, encoded into arena
+    @return false on allocation failure
+ */
+bool compute_local_aggregate(local_aggregate_t *aggregate, int folds, const columnar_subregion_t *region,
+                             size_t start, size_t end, sort_key_t *keys, sort_key_arena_t *arena);
+
 #endif // STATISTICAL_OPS_H
\ No newline at end of file
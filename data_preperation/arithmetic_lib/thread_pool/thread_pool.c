@@ -0,0 +1,214 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Blocks still to run on one worker, the owner takes from the front and thieves from the back
+typedef struct {
+    pthread_mutex_t lock;
+    size_t front;
+    size_t back;
+    char padding[64];   // Keep neighbouring deques off each other's cache line
+} deque_t;
+
+typedef struct {
+    thread_pool_task_t task;
+    void *args;
+    size_t count;
+    size_t grain;
+    int workers;
+    deque_t *deques;
+    atomic_bool failed;
+} job_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // A job was posted or the pool is stopping
+    pthread_cond_t done;        // The last helper left the job
+    pthread_mutex_t submit;     // One job at a time
+    pthread_t threads[THREAD_POOL_MAX_WORKERS];
+    unsigned long first_generation[THREAD_POOL_MAX_WORKERS];   // Generation when each thread started
+    int num_threads;            // Workers 1 to num_threads, the caller of a job is worker 0
+    job_t *job;
+    unsigned long generation;   // Bumped per job, so a thread can tell a new job from a spurious wakeup
+    int helping;                // Threads still on the current job
+    bool stopping;
+    bool registered;            // Shutdown is registered with atexit
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_MUTEX_INITIALIZER };
+
+// Set on threads running a job's blocks, a nested call runs inline instead of waiting on itself
+static _Thread_local bool in_job;
+
+static inline void block_bounds(const job_t *job, size_t block, size_t *begin, size_t *end) {
+    *begin = block * job->grain;
+    *end = job->count - *begin > job->grain ? *begin + job->grain : job->count;
+}
+
+static bool take_front(deque_t *deque, size_t *block) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->front < deque->back;
+    if (found) *block = deque->front++;
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Move the back half of the next non-empty deque into worker's own, @return the first block of it
+static bool steal(job_t *job, int worker, size_t *block) {
+    for (int offset = 1; offset < job->workers; offset++) {
+        deque_t *victim = &job->deques[(worker + offset) % job->workers];
+
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->back - victim->front;
+        size_t split = victim->back - (remaining + 1) / 2;
+        size_t end = victim->back;
+        victim->back = split;
+        pthread_mutex_unlock(&victim->lock);
+        if (!remaining) continue;
+
+        // Only the owner refills its deque, thieves can only have emptied it meanwhile
+        deque_t *own = &job->deques[worker];
+        pthread_mutex_lock(&own->lock);
+        own->front = split + 1;
+        own->back = end;
+        pthread_mutex_unlock(&own->lock);
+
+        *block = split;
+        return true;
+    }
+    return false;
+}
+
+static void run_blocks(job_t *job, int worker) {
+    size_t block;
+    while (take_front(&job->deques[worker], &block) || steal(job, worker, &block)) {
+        // After a failure the remaining blocks are only drained
+        if (atomic_load_explicit(&job->failed, memory_order_relaxed)) continue;
+
+        size_t begin, end;
+        block_bounds(job, block, &begin, &end);
+        if (!job->task(job->args, begin, end, worker)) atomic_store(&job->failed, true);
+    }
+}
+
+static void *worker_main(void *arg) {
+    int worker = (int)(intptr_t)arg;
+    in_job = true;
+
+    pthread_mutex_lock(&pool.lock);
+    unsigned long seen = pool.first_generation[worker];
+    for (;;) {
+        while (!pool.stopping && pool.generation == seen) pthread_cond_wait(&pool.wake, &pool.lock);
+        if (pool.stopping) break;
+
+        seen = pool.generation;
+        job_t *job = pool.job;
+        if (worker >= job->workers) continue;
+
+        pthread_mutex_unlock(&pool.lock);
+        run_blocks(job, worker);
+        pthread_mutex_lock(&pool.lock);
+
+        if (--pool.helping == 0) pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    return NULL;
+}
+
+// Start threads until there are workers - 1, called holding submit. @return the workers a job can have
+static int grow_pool(int workers) {
+    if (!pool.registered) {
+        atexit(thread_pool_shutdown);
+        pool.registered = true;
+    }
+
+    while (pool.num_threads < workers - 1) {
+        int worker = pool.num_threads + 1;
+        pool.first_generation[worker] = pool.generation;
+        if (pthread_create(&pool.threads[worker - 1], NULL, worker_main, (void *)(intptr_t)worker) != 0) break;
+        pool.num_threads++;
+    }
+
+    return pool.num_threads + 1 < workers ? pool.num_threads + 1 : workers;
+}
+
+bool thread_pool_for(size_t count, size_t grain, int workers, thread_pool_task_t task, void *args) {
+    if (count == 0) return true;
+    if (grain == 0) grain = 1;
+
+    size_t num_blocks = (count - 1) / grain + 1;
+    if (workers > THREAD_POOL_MAX_WORKERS) workers = THREAD_POOL_MAX_WORKERS;
+    if ((size_t)workers > num_blocks) workers = (int)num_blocks;
+
+    job_t job = { task, args, count, grain, 1, NULL };
+    atomic_init(&job.failed, false);
+
+    // Nothing to share, or already inside a job: every block runs here in order
+    if (workers <= 1 || in_job) {
+        for (size_t b = 0; b < num_blocks; b++) {
+            size_t begin, end;
+            block_bounds(&job, b, &begin, &end);
+            if (!task(args, begin, end, 0)) return false;
+        }
+        return true;
+    }
+
+    pthread_mutex_lock(&pool.submit);
+    job.workers = grow_pool(workers);
+
+    job.deques = calloc(job.workers, sizeof(deque_t));
+    if (!job.deques) {
+        fprintf(stderr, "Failed to allocate thread pool deques\n");
+        pthread_mutex_unlock(&pool.submit);
+        return false;
+    }
+
+    // Contiguous shares to start with, so a worker mostly walks memory in order
+    for (int w = 0; w < job.workers; w++) {
+        pthread_mutex_init(&job.deques[w].lock, NULL);
+        job.deques[w].front = num_blocks * w / job.workers;
+        job.deques[w].back = num_blocks * (w + 1) / job.workers;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.job = &job;
+    pool.helping = job.workers - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    in_job = true;
+    run_blocks(&job, 0);
+    in_job = false;
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.helping > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    pool.job = NULL;
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int w = 0; w < job.workers; w++) pthread_mutex_destroy(&job.deques[w].lock);
+    free(job.deques);
+    pthread_mutex_unlock(&pool.submit);
+
+    return !atomic_load(&job.failed);
+}
+
+void thread_pool_shutdown(void) {
+    pthread_mutex_lock(&pool.submit);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.stopping = true;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 0; i < pool.num_threads; i++) pthread_join(pool.threads[i], NULL);
+    pool.num_threads = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.stopping = false;
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&pool.submit);
+}
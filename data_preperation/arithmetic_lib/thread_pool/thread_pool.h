@@ -0,0 +1,30 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define THREAD_POOL_MAX_WORKERS 256
+
+/*
+    One block of a job, the values [begin, end)
+    @param worker: 0 to workers - 1, no two blocks of a job run on the same worker at once,
+                   so per-worker state needs no locking
+    @return false to fail the job, blocks not yet started are skipped
+ */
+typedef bool (*thread_pool_task_t)(void *args, size_t begin, size_t end, int worker);
+
+/*
+    Run task over [0, count) in blocks of grain values on up to workers threads, this one included.
+    Threads live for the whole process and sleep between jobs. Each worker starts on its own
+    contiguous share of the blocks, kept in a deque it takes from the front of, and a worker that
+    runs dry steals the back half of another's, so one slow stretch doesn't hold up the rest.
+    Jobs run one at a time, a call from inside a task runs its blocks inline on that worker.
+    @return false when a block failed
+ */
+bool thread_pool_for(size_t count, size_t grain, int workers, thread_pool_task_t task, void *args);
+
+// Stop and join the pool's threads, it starts again on the next job. Registered with atexit.
+void thread_pool_shutdown(void);
+
+#endif
@@ -0,0 +1,80 @@
+#include "header_index.h"
+#include <string.h>
+
+#define MIN_INDEX_SLOTS 8
+
+static uint32_t hash_name(const char *name) {
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a
+    for (const unsigned char *c = (const unsigned char *)name; *c; c++) {
+        hash ^= *c;
+        hash *= 1099511628211ULL;
+    }
+
+    uint32_t folded = (uint32_t)(hash ^ (hash >> 32));
+    return folded ? folded : 1;
+}
+
+size_t header_index_slots(int num_positions) {
+    size_t needed = num_positions > 0 ? (size_t)num_positions * 2 : 0;
+    size_t slots = MIN_INDEX_SLOTS;
+    while (slots < needed) slots <<= 1;
+    return slots;
+}
+
+// Slot holding name, or the empty slot where it belongs
+static size_t probe(const header_slot_t *slots, size_t num_slots, int num_positions, const char *name, uint32_t hash,
+    header_name_reader_t read_name, const void *ctx) {
+
+    size_t mask = num_slots - 1;
+    size_t slot = hash & mask;
+
+    for (size_t step = 0; step < num_slots && slots[slot].hash != 0; step++) {
+        if (slots[slot].hash == hash) {
+            int position = (int)(slots[slot].entry & ~HEADER_REPEATED);
+            const char *stored = position < num_positions ? read_name(ctx, position) : NULL;
+            if (stored && strcmp(stored, name) == 0) return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void header_index_build(header_slot_t *slots, size_t num_slots, int num_positions,
+    header_name_reader_t read_name, const void *ctx) {
+
+    memset(slots, 0, num_slots * sizeof(header_slot_t));
+
+    for (int position = 0; position < num_positions; position++) {
+        const char *name = read_name(ctx, position);
+        if (!name) continue;
+
+        uint32_t hash = hash_name(name);
+        size_t slot = probe(slots, num_slots, num_positions, name, hash, read_name, ctx);
+
+        if (slots[slot].hash != 0) {
+            slots[slot].entry |= HEADER_REPEATED;
+        } else {
+            slots[slot] = (header_slot_t){ hash, (uint32_t)position };
+        }
+    }
+}
+
+int header_index_find(const header_slot_t *slots, size_t num_slots, int num_positions, const char *name,
+    header_name_reader_t read_name, const void *ctx, bool *repeated) {
+
+    *repeated = false;
+    if (!name || num_slots == 0) return -1;
+
+    uint32_t hash = hash_name(name);
+    size_t slot = probe(slots, num_slots, num_positions, name, hash, read_name, ctx);
+    if (slots[slot].hash != hash) return -1;
+
+    // A probe that ran through a full table can stop on a different name with the same hash
+    int position = (int)(slots[slot].entry & ~HEADER_REPEATED);
+    const char *stored = position < num_positions ? read_name(ctx, position) : NULL;
+    if (!stored || strcmp(stored, name) != 0) return -1;
+
+    *repeated = (slots[slot].entry & HEADER_REPEATED) != 0;
+    return position;
+}
@@ -0,0 +1,40 @@
+#ifndef HEADER_INDEX_H
+#define HEADER_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HEADER_REPEATED 0x80000000u
+
+/*
+    Open addressing index from header name to position, stored as a flat slot array so it
+    can be written to disk and probed straight from a mapping. Names are not kept in the
+    index, they are read back through a header_name_reader_t to confirm a hash match.
+ */
+typedef struct {
+    uint32_t hash;   // Folded name hash, 0 marks an empty slot
+    uint32_t entry;  // Position of the first occurrence, HEADER_REPEATED once the name occurs again
+} header_slot_t;
+
+// NUL-terminated name at a position, NULL when it can't be read
+typedef const char *(*header_name_reader_t)(const void *ctx, int position);
+
+// Power of two slot count that keeps the index at most half full
+size_t header_index_slots(int num_positions);
+
+/*
+    Index positions [0, num_positions), repeats keep the first position and are flagged
+    @param slots: header_index_slots(num_positions) entries, overwritten
+ */
+void header_index_build(header_slot_t *slots, size_t num_slots, int num_positions,
+    header_name_reader_t read_name, const void *ctx);
+
+/*
+    @param repeated: out, set when the name occurs at more than one position
+    @return position of the first occurrence, -1 when the name is not a header
+ */
+int header_index_find(const header_slot_t *slots, size_t num_slots, int num_positions, const char *name,
+    header_name_reader_t read_name, const void *ctx, bool *repeated);
+
+#endif // HEADER_INDEX_H
@@ -3,68 +3,72 @@
 #include "../../arithmetic_lib/fat_data/fat_data.h"
 #include "../martix_lib.h"
 #include "../../arithmetic_lib/statistical_ops/statistical_ops.h"
-#include "../../arithmetic_lib/sorting/merge/merge.h"
-#include "../../arithmetic_lib/sorting/k_way/k_way.h"
+#include "../../arithmetic_lib/decimal/decimal.h"
+#include "../../arithmetic_lib/sorting/sort_key/sort_key.h"
+#include "../../arithmetic_lib/sorting/select/select.h"
 #include "../../arithmetic_lib/hashmap/hashmap.h"
-#include <pthread.h>
+#include "../../arithmetic_lib/thread_pool/thread_pool.h"
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>  
 
-#define OP_MAX      1
-#define OP_MIN      2
-#define OP_MEAN     4
-#define OP_MEDIAN   8
-#define OP_MODE     16
+// Values per block of the aggregate job, whole columnar blocks so each keeps its number class
+#define MARSHALL_BLOCK_VALUES (16 * COLUMNAR_BLOCK_VALUES)
 
 typedef struct {
-    char **subregion;
-    int start_idx;       // inclusive
-    int end_idx;         // exclusive
-    int chunk_size;
+    const columnar_subregion_t *subregion;
     int operations;
+    int folds;                           // AGGREGATE_* flags the operations need
+    int num_workers;                     // Also the number of mode partitions, worker i merges partition i
+    local_aggregate_t *workers;          // What each pool worker folded over the blocks it ran, mode partitions made on first use
+    sort_key_t *keys;                    // Every value's key for median and quantiles, in index order
+    unsigned char **key_bytes;           // Key arena of each block
+    size_t num_blocks;
+} aggregate_job_t;
+
+// Best of the partitions' modes, they hold disjoint keys so it is the mode of them all, NULL when no key occurs twice
+static const char *partitions_mode(hashmap_t **maps, int num_partitions, int *count) {
+    const char *best = NULL;
+    int best_count = 0;
+    for (int p = 0; p < num_partitions; p++) {
+        int partition_count = 0;
+        const char *key = hashmap_mode(maps[p], &partition_count);
+        if (key && (!best || partition_count > best_count ||
+                    (partition_count == best_count && hashmap_compare_keys(key, best) < 0))) {
+            best = key;
+            best_count = partition_count;
+        }
+    }
 
-    // Result caching
-    char local_sum[MAX_NUMBER_LENGTH];   // for mean
-    char local_min[MAX_NUMBER_LENGTH];
-    char local_max[MAX_NUMBER_LENGTH];
-    char **local_values;                 // for median/mode
-
-    hashmap_t *local_freq_map; // Store the counts for each value for mode
-} thread_args_t;
+    *count = best_count;
+    return best;
+}
 
-typedef struct {
-    char max_result[MAX_NUMBER_LENGTH];
-    char min_result[MAX_NUMBER_LENGTH];
-    char mean_result[MAX_NUMBER_LENGTH];
-    char median_result[MAX_NUMBER_LENGTH];
-    char mode_result[MAX_NUMBER_LENGTH];
-} final_args_t;
-
-void print_thread_structs(thread_args_t *thread_args, int num_threads) {
-    for (int i = 0; i < num_threads; i++) {
-        printf("Thread [%d]\n", i);
-        printf("Start index: %d\n", thread_args[i].start_idx);
-        printf("End index:   %d\n", thread_args[i].end_idx);
-        printf("Chunk size:   %d\n", thread_args[i].chunk_size);
-        printf("Operations:  %d\n", thread_args[i].operations);
+void print_worker_structs(aggregate_job_t *job) {
+    for (int i = 0; i < job->num_workers; i++) {
+        local_aggregate_t *worker = &job->workers[i];
+        printf("Worker [%d]\n", i);
+        printf("Values:      %zu\n", worker->num_values);
+        printf("Operations:  %d\n", job->operations);
         printf("\n");
 
-        printf("  Local values:\n");
-        for (int j = 0; j < thread_args[i].chunk_size; j++) {
-            if (thread_args[i].local_values && thread_args[i].local_values[j]) {
-                printf("    [%d] %s\n", j, thread_args[i].local_values[j]);
-            } else {
-                printf("    [%d] (NULL)\n", j);
-            }
+        if (worker->max.set) {
+            printf("Local max: %s\n", columnar_value(job->subregion, worker->max.index));
+        }
+        if (worker->min.set) {
+            printf("Local min: %s\n", columnar_value(job->subregion, worker->min.index));
+        }
+        if (job->operations & OP_MEAN) {
+            char local_sum[MAX_NUMBER_LENGTH];
+            if (!sum_accumulator_format(&worker->sum, local_sum, sizeof(local_sum))) strcpy(local_sum, "NaN");
+            printf("Local mean (sum): %s\n", local_sum);
+        }
+        if ((job->operations & OP_MODE) && worker->partitions) {
+            int count = 0;
+            const char *key = partitions_mode(worker->partitions, job->num_workers, &count);
+            printf("Local mode: %s\n", key ? key : "N/A");
         }
-        printf("\n");  
-
-        if (thread_args[i].operations & OP_MAX) printf("Local max: %s\n", thread_args[i].local_max);
-        if (thread_args[i].operations & OP_MIN) printf("Local min: %s\n", thread_args[i].local_min);
-        if (thread_args[i].operations & OP_MEAN) printf("Local mean (sum): %s\n", thread_args[i].local_sum);
-        if (thread_args[i].operations & OP_MEDIAN) printf("Local median: %s\n", thread_args[i].local_values ? thread_args[i].local_values[thread_args[i].chunk_size / 2] : "N/A");
-        if (thread_args[i].operations & OP_MODE) printf("Local mode: %s\n", get_mode_key(thread_args[i].local_freq_map));
         printf("-----------------------------\n");
     }
 }
@@ -85,6 +89,11 @@ void print_final_results(final_args_t *final_results, int operations) {
     if (operations & OP_MEDIAN) {
         printf("   Median: %s\n", final_results->median_result);
     }
+    if (operations & OP_QUANTILES) {
+        for (int i = 0; i < final_results->num_quantiles; i++) {
+            printf("   Quantile %s: %s\n", final_results->quantiles[i].text, final_results->quantile_results[i]);
+        }
+    }
     if (operations & OP_MODE) {
         printf("   Mode  : %s\n", final_results->mode_result);
     }
@@ -93,274 +102,663 @@ void print_final_results(final_args_t *final_results, int operations) {
 }
 
 
-void *thread_operations(void *args) {
-    thread_args_t *targs = (thread_args_t *)args;
-    char **subregion = targs->subregion;
-    int start_idx = targs->start_idx;
-    int end_idx = targs->end_idx;
-    int operations = targs->operations;
-    int chunk_size = targs->chunk_size;
-
-    // Initialize the local thread chunk
-    targs->local_values = malloc(sizeof(char *) * chunk_size);
-    if (!targs->local_values) {
-        fprintf(stderr, "Malloc failed in thread\n");
-        pthread_exit((void *)1);  // 1 = failure
-    }
+/*
+    Whether value a lies further in direction than value b, by key order and then the lower index,
+    so the blocks fold to the answer one scan over the subregion gives
+    @param direction: 1 for the max, -1 for the min
+ */
+static bool beats_extreme(const columnar_subregion_t *region, size_t a, size_t b, int direction) {
+    const char *value_a = columnar_value(region, a);
+    const char *value_b = columnar_value(region, b);
+
+    sort_key_buffer_t key_a, key_b;
+    sort_key_buffer_init(&key_a);
+    sort_key_buffer_init(&key_b);
+    int cmp = sort_key_buffer_set(&key_a, value_a, strlen(value_a)) && sort_key_buffer_set(&key_b, value_b, strlen(value_b))
+                  ? sort_key_compare(&key_a.key, &key_b.key)
+                  : compare_big_numbers(value_a, value_b);
+    sort_key_buffer_free(&key_a);
+    sort_key_buffer_free(&key_b);
+
+    return cmp ? cmp == direction : a < b;
+}
 
-    for (int i = start_idx, j = 0; i < end_idx; i++, j++) {
-        if (!subregion[i]) {
-            fprintf(stderr, "WARNING: subregion[%d] is NULL\n", i);
-            pthread_exit((void *)1);
-        }
+int marshall_folds(int operations) {
+    int folds = 0;
+    if (operations & OP_MAX) folds |= AGGREGATE_MAX;
+    if (operations & OP_MIN) folds |= AGGREGATE_MIN;
+    if (operations & OP_MEAN) folds |= AGGREGATE_SUM;
+    if (operations & (OP_MEDIAN | OP_QUANTILES)) folds |= AGGREGATE_KEYS;
+    if (operations & OP_MODE) folds |= AGGREGATE_COUNTS;
+    return folds;
+}
 
-        // Set shallow references
-        targs->local_values[j] = subregion[i];
+// One count map per partition of the key hashes, @return false on allocation failure
+static bool create_partitions(local_aggregate_t *worker, int num_partitions) {
+    worker->partitions = calloc(num_partitions, sizeof(hashmap_t *));
+    if (!worker->partitions) {
+        fprintf(stderr, "Error creating hashmap for local frequency map\n");
+        return false;
     }
+    worker->num_partitions = num_partitions;
 
-    // Bitwise checks for each operation, compute val on chunk and store in thread structure
-    if ((operations & OP_MAX) && !(operations & OP_MEDIAN)) {
-        compute_local_max(targs->local_values, targs->chunk_size, targs->local_max); 
-    }
-    else if (operations & OP_MAX) {
-        targs->local_max[0] = '\0'; // Set to empty string if not computing max
+    for (int p = 0; p < num_partitions; p++) {
+        worker->partitions[p] = hashmap_create();
+        if (!worker->partitions[p]) return false;
     }
+    return true;
+}
 
-    if ((operations & OP_MIN) && !(operations & OP_MEDIAN)) {
-        compute_local_min(targs->local_values, targs->chunk_size, targs->local_min);
-    }
-    else if (operations & OP_MIN) {
-        targs->local_min[0] = '\0'; 
+static void destroy_partitions(local_aggregate_t *worker) {
+    // Partitions the mode merge took are already NULL
+    for (int p = 0; worker->partitions && p < worker->num_partitions; p++) hashmap_destroy(worker->partitions[p]);
+    free(worker->partitions);
+    worker->partitions = NULL;
+}
+
+// One block of the subregion, every operation folded in one visit per value by the worker that runs it
+static bool aggregate_block(void *args, size_t begin, size_t end, int worker_index) {
+    aggregate_job_t *job = (aggregate_job_t *)args;
+    local_aggregate_t *worker = &job->workers[worker_index];
+
+    if ((job->folds & AGGREGATE_COUNTS) && !worker->partitions && !create_partitions(worker, job->num_workers)) {
+        return false;
     }
 
-    if (operations & OP_MEAN) {
-        compute_local_sum(targs->local_values, targs->chunk_size, targs->local_sum);
+    // Each value is normalized into its key once, selection then compares prefixes and bytes
+    sort_key_arena_t arena = { 0 };
+    bool ok = compute_local_aggregate(worker, job->folds, job->subregion, begin, end, job->keys + begin, &arena);
+    if (job->key_bytes) job->key_bytes[begin / MARSHALL_BLOCK_VALUES] = arena.bytes;
+    else free(arena.bytes);
+
+    if (!ok) fprintf(stderr, "Failed to aggregate chunk\n");
+    return ok;
+}
+
+static void free_aggregate_job(aggregate_job_t *job) {
+    for (int i = 0; job->workers && i < job->num_workers; i++) {
+        destroy_partitions(&job->workers[i]);
+        local_aggregate_free(&job->workers[i]);
     }
+    for (size_t b = 0; job->key_bytes && b < job->num_blocks; b++) free(job->key_bytes[b]);
 
-    if (operations & OP_MEDIAN) {
-        merge_sort(targs->local_values, targs->chunk_size); // Sort chunk
+    free(job->workers);
+    free(job->keys);
+    free(job->key_bytes);
+}
+
+static uint64_t power_of_ten(int digits) {
+    uint64_t power = 1;
+    while (digits-- > 0) power *= 10;
+    return power;
+}
+
+int parse_quantiles(const char *list, quantile_t *quantiles) {
+    if (!list || !*list) {
+        fprintf(stderr, "Error: Quantiles need a comma-separated list of fractions, such as 0.5,0.9,0.99.\n");
+        return -1;
     }
 
-    if (operations & OP_MODE) { 
-        targs->local_freq_map = hashmap_create();
-        if (!targs->local_freq_map) {
-            fprintf(stderr, "Error creating hashmap for local frequency map\n");
-            pthread_exit((void *)1);  // 1 = failure
+    int count = 0;
+    for (const char *cursor = list;; cursor++) {
+        const char *end = strchr(cursor, ',');
+        if (!end) end = cursor + strlen(cursor);
+
+        const char *start = cursor;
+        while (start < end && isspace((unsigned char)*start)) start++;
+        const char *stop = end;
+        while (stop > start && isspace((unsigned char)stop[-1])) stop--;
+
+        if (count == MAX_QUANTILES) {
+            fprintf(stderr, "Error: At most %d quantiles can be requested.\n", MAX_QUANTILES);
+            return -1;
+        }
+
+        // Digits with an optional fraction, the integer part saturates since only 0 and 1 are valid
+        const char *p = start;
+        uint64_t integer = 0, numerator = 0;
+        int digits = 0;
+        bool any_digit = false, valid = true;
+        for (; p < stop && isdigit((unsigned char)*p); p++) {
+            integer = integer > 1 ? integer : integer * 10 + (*p - '0');
+            any_digit = true;
         }
+        if (p < stop && *p == '.') {
+            for (p++; p < stop && isdigit((unsigned char)*p); p++) {
+                if (digits == MAX_QUANTILE_DIGITS) {
+                    valid = false;
+                } else {
+                    numerator = numerator * 10 + (*p - '0');
+                    digits++;
+                }
+                any_digit = true;
+            }
+        }
+        valid = valid && any_digit && p == stop && (integer == 0 || (integer == 1 && numerator == 0));
+        if (!valid) {
+            fprintf(stderr, "Error: Quantile '%.*s' must be a fraction from 0 to 1 with at most %d digits after the point.\n",
+                    (int)(end - cursor), cursor, MAX_QUANTILE_DIGITS);
+            return -1;
+        }
+
+        quantile_t *quantile = &quantiles[count++];
+        quantile->numerator = integer ? power_of_ten(digits) : numerator;
+        quantile->digits = digits;
+        snprintf(quantile->text, sizeof(quantile->text), "%.*s", (int)(stop - start), start);
 
-        // Compute local counts
-        compute_local_counts(targs->local_values, targs->chunk_size, targs->local_freq_map);
-    }  
-    else {
-        targs->local_freq_map = NULL; // Set to NULL if not computing mode
-    } 
+        if (!*end) break;
+        cursor = end;
+    }
+    return count;
+}
 
-    return NULL;
+// low + (high - low) weight / 10^digits, exact until the division truncates it to precision digits
+static void interpolate(const char *low, const char *high, uint64_t weight, int digits, int precision, char *result) {
+    decimal_t sum, upper, denominator;
+    bignum_t factor, scratch;
+    decimal_init(&sum);
+    decimal_init(&upper);
+    decimal_init(&denominator);
+    bignum_init(&factor);
+    bignum_init(&scratch);
+
+    uint64_t scale = power_of_ten(digits);
+    bool ok = decimal_parse(&sum, low, strlen(low)) && decimal_parse(&upper, high, strlen(high)) &&
+              bignum_set_int64(&factor, (int64_t)(scale - weight)) && decimal_mul_integer(&sum, &factor) &&
+              bignum_set_int64(&factor, (int64_t)weight) && decimal_mul_integer(&upper, &factor) &&
+              decimal_add(&sum, &upper, &scratch) && bignum_set_int64(&denominator.mantissa, (int64_t)scale) &&
+              decimal_divide(&sum, &denominator, precision, result, MAX_NUMBER_LENGTH);
+    if (!ok) strcpy(result, "NaN");
+
+    decimal_free(&sum);
+    decimal_free(&upper);
+    decimal_free(&denominator);
+    bignum_free(&factor);
+    bignum_free(&scratch);
 }
 
-void thread_cleanup(pthread_t *threads, int thread_count) {
-    void *retval;
-    for (int i = 0; i < thread_count; i++) {
-        pthread_join(threads[i], retval);
+/*
+    Value at each fraction q of the sorted values, linear between the two ranks around q (n - 1) so
+    q = 0.5 is the usual median. Every rank comes out of one selection over the keys, split into
+    one run per worker.
+    @param results: out, one value per quantile
+ */
+static bool select_quantiles(sort_key_t *keys, int num_runs, int subregion_size,
+                             const columnar_subregion_t *subregion, const quantile_t *quantiles, int num_quantiles,
+                             int precision, char (*results)[MAX_NUMBER_LENGTH]) {
+    size_t lows[MAX_QUANTILES + 1], ranks[2 * (MAX_QUANTILES + 1)];
+    uint64_t weights[MAX_QUANTILES + 1];
+    sort_key_t selected[2 * (MAX_QUANTILES + 1)];
+
+    // q (n - 1) splits into a rank and the weight of the next one, in units of 10^-digits
+    int num_ranks = 0;
+    for (int i = 0; i < num_quantiles; i++) {
+        unsigned __int128 position = (unsigned __int128)quantiles[i].numerator * (subregion_size - 1);
+        uint64_t scale = power_of_ten(quantiles[i].digits);
+        lows[i] = (size_t)(position / scale);
+        weights[i] = (uint64_t)(position % scale);
+
+        ranks[num_ranks++] = lows[i];
+        if (weights[i]) ranks[num_ranks++] = lows[i] + 1;
+    }
 
-        if ((long)retval != 0) {
-            fprintf(stderr, "Thread %d exited with failure code %ld\n", i, (long)retval);
+    // Ascending and distinct for the selection
+    for (int i = 1; i < num_ranks; i++) {
+        size_t rank = ranks[i];
+        int j = i;
+        while (j > 0 && ranks[j - 1] > rank) {
+            ranks[j] = ranks[j - 1];
+            j--;
+        }
+        ranks[j] = rank;
+    }
+    int distinct = 0;
+    for (int i = 0; i < num_ranks; i++) {
+        if (distinct == 0 || ranks[distinct - 1] != ranks[i]) ranks[distinct++] = ranks[i];
+    }
 
-            // Handle status code...
+    sort_key_t **runs = malloc(sizeof(sort_key_t *) * num_runs);
+    int *run_sizes = malloc(sizeof(int) * num_runs);
+    bool ok = runs && run_sizes;
+    for (int i = 0; ok && i < num_runs; i++) {
+        size_t run_start = (size_t)subregion_size * i / num_runs;
+        runs[i] = keys + run_start;
+        run_sizes[i] = (int)((size_t)subregion_size * (i + 1) / num_runs - run_start);
+    }
+    ok = ok && select_ranks(runs, run_sizes, num_runs, ranks, distinct, selected);
+    free(runs);
+    free(run_sizes);
+    if (!ok) return false;
+
+    for (int i = 0; i < num_quantiles; i++) {
+        int at = 0;
+        while (ranks[at] != lows[i]) at++;
+
+        const char *low = subregion->bytes + selected[at].value;
+        if (!weights[i]) {
+            strncpy(results[i], low, MAX_NUMBER_LENGTH - 1);
+            results[i][MAX_NUMBER_LENGTH - 1] = '\0';
+        } else {
+            interpolate(low, subregion->bytes + selected[at + 1].value, weights[i], quantiles[i].digits,
+                        precision, results[i]);
         }
     }
-    free(threads);
+    return true;
+}
+
+/*
+    The quantiles to select, the median rides along as the last one
+    @param requested: out, room for MAX_QUANTILES + 1
+    @return how many there are
+ */
+static int requested_quantiles(int operations, const quantile_t *quantiles, int num_quantiles, quantile_t *requested) {
+    int num_requested = 0;
+    if (operations & OP_QUANTILES) {
+        memcpy(requested, quantiles, num_quantiles * sizeof(quantile_t));
+        num_requested = num_quantiles;
+    }
+    if (operations & OP_MEDIAN) requested[num_requested++] = (quantile_t){ 5, 1, "0.5" };
+    return num_requested;
+}
 
-   return;
+typedef struct {
+    local_aggregate_t *workers;
+    int num_workers;
+    hashmap_t **merged;   // Each partition's counts over every worker, grown from the first worker's map
+} mode_merge_t;
+
+static bool merge_mode_partitions(void *args, size_t begin, size_t end, int worker) {
+    mode_merge_t *merge = (mode_merge_t *)args;
+
+    for (size_t p = begin; p < end; p++) {
+        for (int w = 0; w < merge->num_workers; w++) {
+            hashmap_t **maps = merge->workers[w].partitions;
+            if (!maps) continue;   // The worker ran no blocks
+
+            if (!merge->merged[p]) {
+                merge->merged[p] = maps[p];
+                maps[p] = NULL;
+            } else if (!hashmap_merge(merge->merged[p], maps[p])) {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
-void thread_structs_cleanup(thread_args_t *thread_args, final_args_t *final_args,
-                            int num_threads, int operations, int subregion_size, int sub_width,
-                            char **subregion) {
+// Partition p of all workers merges as one pool task, no key is hashed again
+bool marshall_reduce_mode(local_aggregate_t *workers, int num_workers, char *result) {
+    int num_partitions = num_workers;
+    mode_merge_t merge = { workers, num_workers, calloc(num_partitions, sizeof(hashmap_t *)) };
+
+    bool ok = merge.merged && thread_pool_for(num_partitions, 1, num_partitions, merge_mode_partitions, &merge);
+    if (ok) {
+        int count = 0;
+        const char *key = partitions_mode(merge.merged, num_partitions, &count);
+        strncpy(result, key ? key : "N/A", MAX_NUMBER_LENGTH - 1);
+        result[MAX_NUMBER_LENGTH - 1] = '\0';
+    }
+
+    for (int p = 0; merge.merged && p < num_partitions; p++) hashmap_destroy(merge.merged[p]);
+    free(merge.merged);
+    return ok;
+}
+
+void worker_structs_cleanup(aggregate_job_t *job, final_args_t *final_args, int subregion_size, int precision,
+                            const quantile_t *quantiles, int num_quantiles) {
+    const columnar_subregion_t *subregion = job->subregion;
+    int operations = job->operations;
     char max_result[MAX_NUMBER_LENGTH];
     char min_result[MAX_NUMBER_LENGTH];
     char mean_result[MAX_NUMBER_LENGTH];    
     char median_result[MAX_NUMBER_LENGTH];  
+    char mode_result[MAX_NUMBER_LENGTH];
     
     // Prevent conditional jumps on uninitialized values
     max_result[0] = '\0'; 
     min_result[0] = '\0'; 
     mean_result[0] = '\0'; 
     median_result[0] = '\0'; 
-    char *mode_result = "\0"; 
-
-    char subregion_len[MAX_NUMBER_LENGTH];
-    snprintf(subregion_len, MAX_NUMBER_LENGTH, "%d", subregion_size);
-    subregion_len[MAX_NUMBER_LENGTH - 1] = '\0';
+    mode_result[0] = '\0';
+
+    sum_accumulator_t total_sum;
+    sum_accumulator_init(&total_sum);
+    bool mean_failed = false;
+
+    // The median is the 0.5 quantile, asked for alongside the rest
+    if (operations & (OP_MEDIAN | OP_QUANTILES)) {
+        quantile_t requested[MAX_QUANTILES + 1];
+        int num_requested = requested_quantiles(operations, quantiles, num_quantiles, requested);
+
+        char (*results)[MAX_NUMBER_LENGTH] = malloc(num_requested * sizeof(*results));
+        if (!results || !select_quantiles(job->keys, job->num_workers, subregion_size, subregion, requested,
+                                          num_requested, precision, results)) {
+            fprintf(stderr, "Failed to select the median and quantiles\n");
+            for (int i = 0; results && i < num_requested; i++) strcpy(results[i], "NaN");
+        }
 
-    // Mother fuck
-    char **merged_array = NULL;
-    if (operations & OP_MEDIAN) {
-        char ***k_way = malloc(sizeof(char **) * num_threads);
-        int *chunk_sizes = malloc(sizeof(int) * num_threads);
-        for (int i = 0; i < num_threads; i++) {
-            k_way[i] = thread_args[i].local_values;
-            chunk_sizes[i] = thread_args[i].chunk_size;
+        for (int i = 0; results && i < num_quantiles && (operations & OP_QUANTILES); i++) {
+            strcpy(final_args->quantile_results[i], results[i]);
         }
+        if (operations & OP_MEDIAN) strcpy(median_result, results ? results[num_requested - 1] : "NaN");
+        free(results);
+    }
+    final_args->num_quantiles = (operations & OP_QUANTILES) ? num_quantiles : 0;
+    memcpy(final_args->quantiles, quantiles, final_args->num_quantiles * sizeof(quantile_t));
 
-        merged_array = k_way_merge(k_way, chunk_sizes, num_threads, subregion_size);
+    if ((operations & OP_MODE) && !marshall_reduce_mode(job->workers, job->num_workers, mode_result)) {
+        fprintf(stderr, "Failed to merge the chunk counts\n");
+        strcpy(mode_result, "NaN");
+    }
 
-        // pretty_print_values(merged_array, subregion_size, sub_width);
+    // Fold the workers' results, workers that ran no blocks have nothing to add
+    bool have_extremes = false;
+    size_t max_index = 0, min_index = 0;
+    for (int i = 0; i < job->num_workers; i++) {
+        local_aggregate_t *worker = &job->workers[i];
 
-        // Just take the damned indeces
-        if (operations & OP_MAX) {
-            strncpy(max_result, merged_array[subregion_size - 1], MAX_NUMBER_LENGTH);
-        }
-        if (operations & OP_MIN) {
-            strncpy(min_result, merged_array[0], MAX_NUMBER_LENGTH);
+        if (worker->num_values) {
+            if ((operations & OP_MAX) && (!have_extremes || beats_extreme(subregion, worker->max.index, max_index, 1))) {
+                max_index = worker->max.index;
+            }
+            if ((operations & OP_MIN) && (!have_extremes || beats_extreme(subregion, worker->min.index, min_index, -1))) {
+                min_index = worker->min.index;
+            }
+            have_extremes = true;
         }
 
-        // Obtain the actual median from the sorted array
-        if (subregion_size % 2 == 1) {
-            strncpy(median_result, merged_array[subregion_size / 2], MAX_NUMBER_LENGTH);
-        }
-        else {
-                char temp_sum[MAX_NUMBER_LENGTH];
-                char *divide_by_2 = "2\0";
-                add_big_integers(merged_array[(subregion_size / 2) - 1],
-                    merged_array[subregion_size / 2],
-                    temp_sum);
-                divide_big_decimals(temp_sum, divide_by_2, DEFAULT_PRECISION, median_result);
+        if (operations & OP_MEAN) {
+            // Native partials merge natively, text only once the total is known
+            if (!sum_accumulator_merge(&total_sum, &worker->sum)) mean_failed = true;
         }
     }
 
-    // Initialize the final hashmap for mode globally
-    hashmap_t *final_map = NULL;
+    if (have_extremes && (operations & OP_MAX)) {
+        strncpy(max_result, columnar_value(subregion, max_index), MAX_NUMBER_LENGTH - 1);
+        max_result[MAX_NUMBER_LENGTH - 1] = '\0';
+    }
+    if (have_extremes && (operations & OP_MIN)) {
+        strncpy(min_result, columnar_value(subregion, min_index), MAX_NUMBER_LENGTH - 1);
+        min_result[MAX_NUMBER_LENGTH - 1] = '\0';
+    }
+
+    if ((operations & OP_MEAN) &&
+        (mean_failed || !sum_accumulator_mean(&total_sum, subregion_size, precision, mean_result, sizeof(mean_result)))) {
+        fprintf(stderr, "Failed to combine the chunk sums\n");
+        strcpy(mean_result, "NaN");
+    }
+    sum_accumulator_free(&total_sum);
+
+    strncpy(final_args->max_result, max_result, MAX_NUMBER_LENGTH - 1);
+    strncpy(final_args->min_result, min_result, MAX_NUMBER_LENGTH - 1);
+    strncpy(final_args->mean_result, mean_result, MAX_NUMBER_LENGTH - 1);
+    strncpy(final_args->median_result, median_result, MAX_NUMBER_LENGTH - 1);
+    strncpy(final_args->mode_result, mode_result, MAX_NUMBER_LENGTH - 1);
+
+    return;
+}
+
+
+// Lanes per axis task add up to about this many values, short lanes share a task
+#define AXIS_BLOCK_VALUES MARSHALL_BLOCK_VALUES
+
+// Scratch of one pool worker, made on its first lane and reused for the rest
+typedef struct {
+    hashmap_t *counts;                         // Mode, cleared between lanes
+    sort_key_t *keys;                          // Median and quantile keys of one lane
+    char (*selected)[MAX_NUMBER_LENGTH];       // Median and quantile values of one lane
+} axis_worker_t;
+
+typedef struct {
+    const columnar_subregion_t *lanes;   // Lane i is column i of this region
+    int operations;
+    int precision;
+    quantile_t requested[MAX_QUANTILES + 1];
+    int num_requested;
+    axis_worker_t *workers;
+    axis_results_t *results;
+} axis_job_t;
+
+// Copy a result into its lane, @return false on allocation failure
+static bool set_lane_result(char **field, const char *value) {
+    *field = strndup(value, MAX_NUMBER_LENGTH - 1);
+    if (!*field) fprintf(stderr, "Failed to allocate a lane result\n");
+    return *field != NULL;
+}
+
+// Every requested operation over one lane, one fused pass like a block of the whole subregion
+static bool aggregate_lane(axis_job_t *job, axis_worker_t *worker, size_t lane) {
+    const columnar_subregion_t *region = job->lanes;
+    int operations = job->operations;
+    int length = region->num_rows;
+    size_t start = lane * length, end = start + length;
+    lane_results_t *out = &job->results->lanes[lane];
+    char result[MAX_NUMBER_LENGTH];
+
+    local_aggregate_t aggregate;
+    local_aggregate_init(&aggregate);
     if (operations & OP_MODE) {
-        final_map = hashmap_create();
-        if (!final_map) {
-            fprintf(stderr, "Error creating final hashmap for mode\n");
-            return;
-        }
-    } 
-  
-    for (int i = 0; i < num_threads; i++) {
-
-        // Bitwise checks for each operation
-        if ((operations & OP_MAX) && !(operations & OP_MEDIAN)) {
-            // Take the max of each chunk's max
-            if (i == 0) {
-                // Initialize max_result with the first thread's result
-                strncpy(max_result, thread_args[i].local_max, MAX_NUMBER_LENGTH - 1);
-            } else {
-                if (compare_big_numbers(thread_args[i].local_max, max_result) == 1) {
-                    strncpy(max_result, thread_args[i].local_max, MAX_NUMBER_LENGTH - 1);
-                }
-            }
-        }
+        hashmap_clear(worker->counts);
+        aggregate.partitions = &worker->counts;
+        aggregate.num_partitions = 1;
+    }
 
-        if ((operations & OP_MIN) && !(operations & OP_MEDIAN)) {
-            // Take the min of each local min
-            if (i == 0) {
-                // Initialize min_result with the first thread's result
-                strncpy(min_result, thread_args[i].local_min, MAX_NUMBER_LENGTH - 1);
-            } else {
-                if (compare_big_numbers(thread_args[i].local_min, min_result) == -1) {
-                    strncpy(min_result, thread_args[i].local_min, MAX_NUMBER_LENGTH - 1);
-                }
-            }
-        }
+    sort_key_arena_t arena = { 0 };
+    bool ok = compute_local_aggregate(&aggregate, marshall_folds(operations), region, start, end, worker->keys, &arena);
 
-        if (operations & OP_MEAN) {
-            if (i == 0) {
-                strncpy(mean_result, thread_args[i].local_sum, MAX_NUMBER_LENGTH - 1);
-                mean_result[MAX_NUMBER_LENGTH - 1] = '\0'; // Ensure null-termination
-            } else {
-                char temp_result[MAX_NUMBER_LENGTH];
-                add_big_integers(mean_result, thread_args[i].local_sum, temp_result);
-                strncpy(mean_result, temp_result, MAX_NUMBER_LENGTH - 1);
-                mean_result[MAX_NUMBER_LENGTH - 1] = '\0';
-            }
-        }
+    ok = ok && (!(operations & OP_MAX) || set_lane_result(&out->max, columnar_value(region, aggregate.max.index)));
+    ok = ok && (!(operations & OP_MIN) || set_lane_result(&out->min, columnar_value(region, aggregate.min.index)));
+
+    if (ok && (operations & OP_MEAN)) {
+        if (!sum_accumulator_mean(&aggregate.sum, length, job->precision, result, sizeof(result))) strcpy(result, "NaN");
+        ok = set_lane_result(&out->mean, result);
+    }
+    local_aggregate_free(&aggregate);
 
-        if (operations & OP_MODE) {   
-            // Merge the current hashmap into the final one
-            hashmap_merge(final_map, thread_args[i].local_freq_map);
+    if (ok && (operations & (OP_MEDIAN | OP_QUANTILES))) {
+        // One run, the selection finishes in place on this worker
+        ok = select_quantiles(worker->keys, 1, length, region, job->requested, job->num_requested,
+                              job->precision, worker->selected);
+
+        for (int i = 0; ok && i < job->results->num_quantiles; i++) {
+            ok = set_lane_result(&out->quantiles[i], worker->selected[i]);
         }
+        ok = ok && (!(operations & OP_MEDIAN) || set_lane_result(&out->median, worker->selected[job->num_requested - 1]));
+    }
+    free(arena.bytes);
 
-        // Free the array of structures allocated on heap, freeing the local_values on heap in each struct
-        if (thread_args[i].local_values) free(thread_args[i].local_values);
-        thread_args[i].local_values = NULL;
+    if (ok && (operations & OP_MODE)) {
+        const char *key = hashmap_mode(worker->counts, NULL);
+        ok = set_lane_result(&out->mode, key ? key : "N/A");
+    }
+
+    return ok;
+}
 
-        // Cleanup the local frequency map
-        if (thread_args[i].local_freq_map) {
-            hashmap_destroy(thread_args[i].local_freq_map);
-            thread_args[i].local_freq_map = NULL;
+// Lanes [begin, end), on the scratch of the worker that runs them
+static bool aggregate_lanes(void *args, size_t begin, size_t end, int worker_index) {
+    axis_job_t *job = (axis_job_t *)args;
+    axis_worker_t *worker = &job->workers[worker_index];
+
+    if ((job->operations & OP_MODE) && !worker->counts) {
+        worker->counts = hashmap_create();
+        if (!worker->counts) return false;
+    }
+    if ((job->operations & (OP_MEDIAN | OP_QUANTILES)) && !worker->keys) {
+        worker->keys = malloc(sizeof(sort_key_t) * job->lanes->num_rows);
+        worker->selected = malloc(sizeof(*worker->selected) * job->num_requested);
+        if (!worker->keys || !worker->selected) {
+            fprintf(stderr, "Failed to allocate lane selection scratch\n");
+            return false;
         }
     }
 
-    if (operations & OP_MODE) {
-        mode_result = get_mode_key(final_map);
+    for (size_t lane = begin; lane < end; lane++) {
+        if (!aggregate_lane(job, worker, lane)) return false;
     }
-    else {
-        mode_result = "\0"; // No mode operation
+    return true;
+}
+
+int marshall_axis_operations(const columnar_subregion_t *subregion, int operations, int thread_count,
+    const query_options_t *options, axis_results_t *results) {
+    memset(results, 0, sizeof(*results));
+    if (options->axis != AXIS_COLUMNS && options->axis != AXIS_ROWS) {
+        fprintf(stderr, "Invalid axis %d.\n", options->axis);
+        return 1;
     }
+    results->axis = options->axis;
+    results->operations = operations;
 
-    strncpy(final_args->max_result, max_result, MAX_NUMBER_LENGTH - 1);
-    strncpy(final_args->min_result, min_result, MAX_NUMBER_LENGTH - 1);
-    divide_big_decimals(mean_result, subregion_len, DEFAULT_PRECISION, final_args->mean_result);
-    strncpy(final_args->median_result, median_result, MAX_NUMBER_LENGTH - 1);
-    strncpy(final_args->mode_result, mode_result, MAX_NUMBER_LENGTH - 1);
+    if (operations & OP_QUANTILES) {
+        results->num_quantiles = parse_quantiles(options->quantiles, results->quantiles);
+        if (results->num_quantiles < 0) return 1;
+    }
+    if (thread_count > THREAD_POOL_MAX_WORKERS) thread_count = THREAD_POOL_MAX_WORKERS;
+    if (thread_count < 1) thread_count = 1;
+
+    // Rows become the columns of a transposed view, so every lane is one contiguous stretch
+    columnar_subregion_t transposed = {0};
+    const columnar_subregion_t *lanes = subregion;
+    if (options->axis == AXIS_ROWS) {
+        if (!columnar_transpose(subregion, &transposed, thread_count)) return 1;
+        lanes = &transposed;
+    }
 
-    free(thread_args);
-    if (operations & OP_MODE) hashmap_destroy(final_map);
+    axis_job_t job = { lanes, operations, options->precision };
+    job.num_requested = requested_quantiles(operations, results->quantiles, results->num_quantiles, job.requested);
+    job.workers = calloc(thread_count, sizeof(axis_worker_t));
+    job.results = results;
+    results->num_lanes = lanes->num_columns;
+    results->lanes = calloc(results->num_lanes, sizeof(lane_results_t));
+
+    size_t lanes_per_task = AXIS_BLOCK_VALUES / lanes->num_rows;
+    bool ok = job.workers && results->lanes &&
+              thread_pool_for(results->num_lanes, lanes_per_task ? lanes_per_task : 1, thread_count, aggregate_lanes, &job);
+    if (!ok) fprintf(stderr, "Failed to aggregate the subregion by %s\n", options->axis == AXIS_ROWS ? "row" : "column");
+
+    for (int i = 0; job.workers && i < thread_count; i++) {
+        hashmap_destroy(job.workers[i].counts);
+        free(job.workers[i].keys);
+        free(job.workers[i].selected);
+    }
+    free(job.workers);
+    free_columnar_subregion(&transposed);
 
-    return;
+    if (!ok) {
+        free_axis_results(results);
+        return 1;
+    }
+    return 0;
 }
 
+void print_axis_results(const axis_results_t *results) {
+    const char *lane_name = results->axis == AXIS_ROWS ? "Row" : "Column";
+    int operations = results->operations;
+
+    printf("\n📊 %s Results (%d %ss)\n", lane_name, results->num_lanes, results->axis == AXIS_ROWS ? "row" : "column");
+    for (int i = 0; i < results->num_lanes; i++) {
+        const lane_results_t *lane = &results->lanes[i];
+        printf("-----------------------------\n");
+        printf("   %s %d\n", lane_name, i + 1);
+
+        if (operations & OP_MAX) printf("   Max   : %s\n", lane->max);
+        if (operations & OP_MIN) printf("   Min   : %s\n", lane->min);
+        if (operations & OP_MEAN) printf("   Mean  : %s\n", lane->mean);
+        if (operations & OP_MEDIAN) printf("   Median: %s\n", lane->median);
+        for (int q = 0; q < results->num_quantiles; q++) {
+            printf("   Quantile %s: %s\n", results->quantiles[q].text, lane->quantiles[q]);
+        }
+        if (operations & OP_MODE) printf("   Mode  : %s\n", lane->mode);
+    }
+
+    printf("\n");
+}
+
+void free_axis_results(axis_results_t *results) {
+    for (int i = 0; results->lanes && i < results->num_lanes; i++) {
+        lane_results_t *lane = &results->lanes[i];
+        free(lane->max);
+        free(lane->min);
+        free(lane->mean);
+        free(lane->median);
+        free(lane->mode);
+        for (int q = 0; q < MAX_QUANTILES; q++) free(lane->quantiles[q]);
+    }
+    free(results->lanes);
+    results->lanes = NULL;
+    results->num_lanes = 0;
+}
+
+// Preview reads the columnar subregion in row-major order
+static const char *read_columnar_cell(const void *ctx, int index, int *length) {
+    const columnar_subregion_t *subregion = ctx;
+    const char *cell = columnar_cell(subregion, index / subregion->num_columns, index % subregion->num_columns);
+    *length = strlen(cell);
+    return cell;
+}
+
+int marshall_operations(const columnar_subregion_t *subregion, int operations, int thread_count,
+    const query_options_t *options, final_args_t *results) {
+    int sub_height = subregion ? subregion->num_rows : 0;
+    int sub_width = subregion ? subregion->num_columns : 0;
+    int subregion_size = sub_height * sub_width;
 
-int marshall_operations(char **subregion, int sub_height, int sub_width, int subregion_size, int operations, int thread_count) {
-    
     if (!subregion || sub_height <= 0 || sub_width <= 0) {
         fprintf(stderr, "Invalid subregion dimensions.\n");
         return 1;
     }
-    // Prevent overlapping chunk allocation to threads
+    // No more workers than values, nor than the pool has
     else if (thread_count > subregion_size) thread_count = subregion_size;
+    if (thread_count > THREAD_POOL_MAX_WORKERS) thread_count = THREAD_POOL_MAX_WORKERS;
+    if (thread_count < 1) thread_count = 1;
+
+    quantile_t quantiles[MAX_QUANTILES];
+    int num_quantiles = 0;
+    if (operations & OP_QUANTILES) {
+        num_quantiles = parse_quantiles(options->quantiles, quantiles);
+        if (num_quantiles < 0) return 1;
+    }
+    if (results) memset(results, 0, sizeof(*results));
 
     // Pretty print the subregion
     printf("\n📊 Subregion Data (%d rows, %d columns)\n", sub_height, sub_width);
-    pretty_print_values(subregion, subregion_size, sub_width);
-
-    // Allocate an array of threads and thread structs per thread
-    pthread_t *threads = (pthread_t *)malloc(thread_count * sizeof(pthread_t));
-    thread_args_t *thread_args = (thread_args_t *)malloc(thread_count * sizeof(thread_args_t));
-
-    final_args_t final_answers;
-
-    // Divvy up the subregion array row wise by threads
-    int chunk_size = subregion_size / thread_count;
-    int remainder = subregion_size % thread_count;
-
-    int current_index = 0;
-    for (int i = 0; i < thread_count; i++) {
-        // Distribute the array into chunks across threads
-        int this_chunk_size = chunk_size + (i < remainder ? 1 : 0);  // distribute extra elements to first threads
-        int start_idx = current_index;
-        int end_idx = current_index + this_chunk_size;
-
-        thread_args[i].subregion = subregion;
-        thread_args[i].start_idx = start_idx;
-        thread_args[i].end_idx = end_idx;
-        thread_args[i].chunk_size = this_chunk_size;
-        thread_args[i].operations = operations;        
+    pretty_print_cells(read_columnar_cell, subregion, subregion_size, sub_width);
+
+    // One result per column or row instead of one for everything
+    if (options->axis != AXIS_ALL) {
+        axis_results_t results;
+        if (marshall_axis_operations(subregion, operations, thread_count, options, &results)) return 1;
+        print_axis_results(&results);
+        free_axis_results(&results);
+        return 0;
+    }
 
-        // Send threads to build their chunk and compute vals from them
-        int thread_creation = pthread_create(&threads[i], NULL, thread_operations, &thread_args[i]);
-        if (thread_creation != 0) break;
+    // One result struct per worker, the keys of median and quantiles are shared and filled block by block
+    aggregate_job_t job = { subregion, operations, marshall_folds(operations), thread_count,
+                            calloc(thread_count, sizeof(local_aggregate_t)) };
+    job.num_blocks = ((size_t)subregion_size - 1) / MARSHALL_BLOCK_VALUES + 1;
+    bool ok = job.workers != NULL;
+    for (int i = 0; ok && i < thread_count; i++) local_aggregate_init(&job.workers[i]);
+    if (ok && (operations & (OP_MEDIAN | OP_QUANTILES))) {
+        job.keys = malloc(sizeof(sort_key_t) * subregion_size);
+        job.key_bytes = calloc(job.num_blocks, sizeof(unsigned char *));
+        ok = job.keys && job.key_bytes;
+    }
 
-        current_index = end_idx;  // Move to the next chunk
+    // Blocks go out to the pool's workers in contiguous shares, one that runs dry steals from the others
+    if (!ok || !thread_pool_for(subregion_size, MARSHALL_BLOCK_VALUES, thread_count, aggregate_block, &job)) {
+        fprintf(stderr, "Failed to aggregate the subregion\n");
+        free_aggregate_job(&job);
+        return 1;
     }
 
-    thread_cleanup(threads, thread_count); 
-    // print_thread_structs(thread_args, thread_count);
-    thread_structs_cleanup(thread_args, &final_answers, thread_count, operations, subregion_size, sub_width, subregion);   
+    final_args_t final_answers;
+    memset(&final_answers, 0, sizeof(final_answers));
+    // print_worker_structs(&job);
+    worker_structs_cleanup(&job, &final_answers, subregion_size, options->precision, quantiles, num_quantiles);
+    free_aggregate_job(&job);
     print_final_results(&final_answers, operations);
+    if (results) *results = final_answers;
 
     return 0;
 }
\ No newline at end of file
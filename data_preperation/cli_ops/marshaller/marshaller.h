@@ -2,6 +2,115 @@
 #ifndef MARSHALLER_H
 #define MARSHALLER_H
 
-int marshall_operations(char **subregion, int sub_height, int sub_width, int subregion_size, int operations, int thread_count);
+#include "../../arithmetic_lib/fat_data/fat_data.h"
+#include "../../arithmetic_lib/columnar/columnar.h"
+#include "../../arithmetic_lib/statistical_ops/statistical_ops.h"
 
-#endif
\ No newline at end of file
+#define OP_MAX      1
+#define OP_MIN      2
+#define OP_MEAN     4
+#define OP_MEDIAN   8
+#define OP_MODE     16
+#define OP_STREAM   32  // Aggregate while reading instead of materializing the subregion
+#define OP_QUANTILES 64 // Values at the fractions listed in query_options_t.quantiles
+#define OP_PIPELINE 128 // Aggregate batches of rows while the file is still being parsed
+
+#define MAX_QUANTILES 16
+#define MAX_QUANTILE_DIGITS 18   // Fraction digits of a quantile, keeps it exact in 64 bits
+
+// A fraction q = numerator / 10^digits between 0 and 1
+typedef struct {
+    uint64_t numerator;
+    int digits;
+    char text[MAX_QUANTILE_DIGITS + 8];   // As given, for the report
+} quantile_t;
+
+typedef struct {
+    char max_result[MAX_NUMBER_LENGTH];
+    char min_result[MAX_NUMBER_LENGTH];
+    char mean_result[MAX_NUMBER_LENGTH];
+    char median_result[MAX_NUMBER_LENGTH];
+    char mode_result[MAX_NUMBER_LENGTH];
+    int num_quantiles;
+    quantile_t quantiles[MAX_QUANTILES];
+    char quantile_results[MAX_QUANTILES][MAX_NUMBER_LENGTH];
+} final_args_t;
+
+// What the operations reduce over
+typedef enum {
+    AXIS_ALL,        // The whole subregion into one result
+    AXIS_COLUMNS,    // One result per column
+    AXIS_ROWS        // One result per row
+} query_axis_t;
+
+// Value options that ride along with the operation bits
+typedef struct {
+    int precision;            // Fraction digits of the mean and of interpolated medians and quantiles, 0 to MAX_PRECISION
+    const char *quantiles;    // Comma-separated fractions for OP_QUANTILES, such as "0.5,0.9,0.99"
+    int axis;                 // query_axis_t
+} query_options_t;
+
+#define QUERY_OPTIONS_DEFAULT ((query_options_t){ .precision = DEFAULT_PRECISION, .quantiles = NULL, .axis = AXIS_ALL })
+
+// Results of one column or row, each a heap string, NULL for operations that weren't requested
+typedef struct {
+    char *max;
+    char *min;
+    char *mean;
+    char *median;
+    char *mode;
+    char *quantiles[MAX_QUANTILES];
+} lane_results_t;
+
+typedef struct {
+    int axis;                 // AXIS_COLUMNS or AXIS_ROWS
+    int operations;
+    int num_quantiles;
+    quantile_t quantiles[MAX_QUANTILES];
+    int num_lanes;
+    lane_results_t *lanes;    // One per column or row, in subregion order
+} axis_results_t;
+
+/*
+    Parse a quantile list, each entry is digits with an optional fraction between 0 and 1
+    @return number of quantiles, -1 with a message when the list is empty or malformed
+ */
+int parse_quantiles(const char *list, quantile_t *quantiles);
+
+void print_final_results(final_args_t *final_results, int operations);
+
+/*
+    @param subregion: columnar subregion, values are split column-major across threads
+    @param options: an axis other than AXIS_ALL prints one result per column or row
+    @param results: out when not NULL, a copy of what was printed, left empty for an axis
+ */
+int marshall_operations(const columnar_subregion_t *subregion, int operations, int thread_count,
+    const query_options_t *options, final_args_t *results);
+
+/*
+    Every requested operation for each column or row of the subregion in one pass on the thread pool.
+    Workers take blocks of whole lanes, so each walks its own stretch of the arena; rows are
+    transposed first so a row's values are contiguous too.
+    @param options: axis is AXIS_COLUMNS or AXIS_ROWS
+    @param results: out, free with free_axis_results
+    @return 0 on success
+ */
+int marshall_axis_operations(const columnar_subregion_t *subregion, int operations, int thread_count,
+    const query_options_t *options, axis_results_t *results);
+
+// The fused passes a set of operations needs (AGGREGATE_* flags), the median and quantiles share the keys
+int marshall_folds(int operations);
+
+/*
+    Mode over every worker's counts, each worker split its counts into num_workers partitions
+    by hashmap_partition. The partitions' modes reduce by count and hashmap_compare_keys, so ties
+    resolve the same way for any thread count. The partitions' maps are taken and freed.
+    @param result: out, "N/A" when no value occurs twice
+    @return false on allocation failure
+ */
+bool marshall_reduce_mode(local_aggregate_t *workers, int num_workers, char *result);
+
+void print_axis_results(const axis_results_t *results);
+void free_axis_results(axis_results_t *results);
+
+#endif
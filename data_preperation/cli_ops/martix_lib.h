@@ -1,7 +1,20 @@
 #ifndef MATRIX_LIB_H
 #define MATRIX_LIB_H
 
-void pretty_print_values(char **values, int values_size, int data_width);
-void free_matrix(char **values, int values_size);
+#include "./marshaller/marshaller.h"
+
+// Returns the characters of cell [index] and stores its length, cells need not be NUL-terminated
+typedef const char *(*cell_reader_t)(const void *ctx, int index, int *length);
+
+void pretty_print_cells(cell_reader_t read_cell, const void *ctx, int values_size, int data_width);
+
+// A file parsed once and queried many times, opaque to callers
+typedef struct dataframe dataframe_t;
+
+dataframe_t *fd_open(const char *file_name, int thread_count);
+int fd_query(dataframe_t *frame, const char *starting_row, const char *ending_row,
+    const char *starting_column, const char *ending_column, int operations, int thread_count,
+    const query_options_t *options, final_args_t *results);
+void fd_close(dataframe_t *frame);
 
 #endif
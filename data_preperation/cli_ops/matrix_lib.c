@@ -10,33 +10,16 @@
 #include "../arithmetic_lib/fat_data/fat_data.h"
 #include "./marshaller/marshaller.h"
 #include "../arithmetic_lib/hashmap/hashmap.h"
+#include "./tokenizer/tokenizer.h"
+#include "./streamer/streamer.h"
+#include "./pipeline/pipeline.h"
+#include "./sidecar/sidecar.h"
+#include "./martix_lib.h"
 
-#define BUFFER_INCREMENT 64
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define SAFE_STRNDUP(src) strndup((src), INT_MAX - 1)
 
-struct header_strings {
-    char *starting_row;
-    char *ending_row;
-    char *starting_column;
-    char *ending_column;
-} typedef header_strings;
-
-struct header_integers {
-    int starting_row;
-    int ending_row;
-    int starting_column;
-    int ending_column;    
-} typedef header_integers;
-
-typedef enum {
-    STARTING_ROW,
-    ENDING_ROW,
-    STARTING_COLUMN,
-    ENDING_COLUMN
-} HeaderField;
-
 //STRUCTURE FUNCTIONALITY
 
 void free_header_strings(header_strings *header_strings) {
@@ -46,37 +29,11 @@ void free_header_strings(header_strings *header_strings) {
     if (header_strings->ending_column) free(header_strings->ending_column);
 }
 
-// Function to check if a specific field is set (not -1)
-bool value_set(header_integers header_indeces, HeaderField field) {
-    switch (field) {
-        case STARTING_ROW:
-            return header_indeces.starting_row != -1;
-        case ENDING_ROW:
-            return header_indeces.ending_row != -1;
-        case STARTING_COLUMN:
-            return header_indeces.starting_column != -1;
-        case ENDING_COLUMN:
-            return header_indeces.ending_column != -1;
-        default:
-            return false; // Invalid field
-    }
-}
-
-// Values array functionality
-void free_matrix(char **values, int values_size) {
-    if (values) {
-        for (int i = 0; i < values_size; i++) {
-            if (values[i]) free(values[i]); 
-        }
-        free(values); 
-    }
-}
-
 #define MAX_DISPLAY_WIDTH 120 // Adjust this threshold as needed
 #define MAX_ROWS_DISPLAY 20
 #define ELLIPSIS_ROW_INDEX -1
 
-void pretty_print_values(char **values, int values_size, int data_width) {
+void pretty_print_cells(cell_reader_t read_cell, const void *ctx, int values_size, int data_width) {
     if (data_width <= 0 || values_size <= 0) return;
     int num_rows = values_size / data_width;
 
@@ -86,7 +43,8 @@ void pretty_print_values(char **values, int values_size, int data_width) {
     for (int row = 0; row < num_rows; row++) {
         for (int col = 0; col < data_width; col++) {
             int idx = row * data_width + col;
-            int len = strlen(values[idx]);
+            int len;
+            read_cell(ctx, idx, &len);
             if (len > col_widths[col]) col_widths[col] = len;
         }
     }
@@ -135,7 +93,9 @@ void pretty_print_values(char **values, int values_size, int data_width) {
         printf("│");
         for (int col = 0; col < visible_cols; col++) {
             int idx = real_row * data_width + col;
-            printf(" %-*s", col_widths[col], values[idx]);
+            int len;
+            const char *cell = read_cell(ctx, idx, &len);
+            printf(" %-*.*s", col_widths[col], len, cell);
             printf(" │");
         }
         if (truncated_cols) printf("...│\n");
@@ -162,596 +122,653 @@ void pretty_print_values(char **values, int values_size, int data_width) {
 }
 
 
-// OVERFLOW OPERATORS
-bool safe_size_t_increment(size_t *value) {
-    if (*value == SIZE_MAX) {
-        fprintf(stderr, "Error: Maximum number of values (%d) exceeded.\n", INT_MAX);
-        return false;
-    }
-    (*value)++;
-    return true;
-}
+// Columns of the band of rows one chunk contributes to the subregion
+typedef struct {
+    columnar_builder_t builder;
+    header_integers bounds;
+    bool alloc_failed;
+} subregion_fill_t;
 
-bool safe_increment(int *value) {
-    if (*value >= INT_MAX - 1) {
-        fprintf(stderr, "Error: Maximum number of values (%d) exceeded.\n", INT_MAX);
-        return false;
-    }
-    (*value)++;
+// Append the in-range columns of a window to the chunk's column arenas
+static bool collect_window(void *context, const char *data,
+    const cell_view_t *cells, int num_rows, int data_width) {
 
-    return true;
-}
-
-// Tokenize and store line
-bool process_line(const char *line, 
-    header_strings requested_headers, header_integers *header_indeces, 
-    char ***values, size_t *values_size, 
-    int num_lines, int *data_width, bool first_line) {
-    
-    char *line_copy = SAFE_STRNDUP(line); // For safe tokenization
-    if (!line_copy) {
-        perror("Memory allocation failed");
-        return false;
-    }
+    subregion_fill_t *fill = context;
+    int sub_width = (fill->bounds.ending_column - fill->bounds.starting_column) + 1;
 
-    const char *delimiters = ",;|";
-    char *token = strtok(line_copy, delimiters);
-
-    int current_width = 0;
-    bool headers_matched = true;
-
-    while (token) {
-        if (!safe_increment(&current_width)) return false;
-
-        // Look for the requested headers in the tokens
-        if (first_line) {
-            if (current_width == 1) {
-                
-                // Consider whether we have already found the header, i.e. do not allow for repeat headers
-                if (requested_headers.starting_column &&
-                    strcmp(token, requested_headers.starting_column) == 0) {                    
-                    if (value_set(*header_indeces, STARTING_COLUMN)) {
-                        fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                        free(line_copy);
-                        return false;
-                    }
-
-                    header_indeces->starting_column = current_width - 1;
-                }
-                if (requested_headers.ending_column &&
-                    strcmp(token, requested_headers.ending_column) == 0) {
-                    if (value_set(*header_indeces, ENDING_COLUMN)) {
-                        fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                        free(line_copy);
-                        return false;
-                    }
-
-                    header_indeces->ending_column = current_width - 1;
-                }
-                if (requested_headers.starting_row &&
-                    strcmp(token, requested_headers.starting_row) == 0) {
-                    if (value_set(*header_indeces, STARTING_ROW)) {
-                        fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                        free(line_copy);
-                        return false;
-                    }
-
-                    header_indeces->starting_row = num_lines + 1;
-                }
-                if (requested_headers.ending_row && 
-                    strcmp(token, requested_headers.ending_row) == 0) {
-                    if (value_set(*header_indeces, ENDING_ROW)) {
-                        fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                        free(line_copy);
-                        return false;
-                    }
-
-                    header_indeces->ending_row = num_lines + 1;
-                }
-            } else if (current_width >= 2) {
-                if (requested_headers.starting_column &&
-                    strcmp(token, requested_headers.starting_column) == 0) {
-                    if (value_set(*header_indeces, STARTING_COLUMN)) {
-                        fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                        free(line_copy);
-                        return false;
-                    }
-
-                    header_indeces->starting_column = current_width - 1;
-                }
-                if (requested_headers.ending_column &&
-                    strcmp(token, requested_headers.ending_column) == 0) {
-                    if (value_set(*header_indeces, ENDING_COLUMN)) {
-                        fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                        free(line_copy);
-                        return false;
-                    }
-
-                    header_indeces->ending_column = current_width - 1;
-                }
-            }
-        } else if (current_width == 1) {
-            // Print the row header if it matches
-            if (requested_headers.starting_row &&
-                strcmp(token, requested_headers.starting_row) == 0) {
-                if (value_set(*header_indeces, STARTING_ROW)) {
-                    fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                    free(line_copy);
-                    return false;
-                }
-
-                header_indeces->starting_row = num_lines + 1;
-            }
-            if (requested_headers.ending_row && 
-                strcmp(token, requested_headers.ending_row) == 0) {
-                if (value_set(*header_indeces, ENDING_ROW)) {
-                    fprintf(stderr, "Error: Repeat header \"%s\"\n", token);
-                    free(line_copy);
-                    return false;
-                }
-
-                header_indeces->ending_row = num_lines + 1;
-            }
-        }
+    for (int row = 0; row < num_rows; row++) {
+        const cell_view_t *row_cells = cells + (size_t)row * data_width + fill->bounds.starting_column;
 
-        // We have exceeded the number of strings allocated for the buffer
-        if (*values_size % BUFFER_INCREMENT == 0) {
-            char **new_values = realloc(*values, (*values_size + BUFFER_INCREMENT) * sizeof(char *));
-            if (!new_values) {
-                perror("Memory reallocation failed");
-                free(line_copy);
+        for (int col = 0; col < sub_width; col++) {
+            if (!columnar_builder_append(&fill->builder, col, data + row_cells[col].offset, row_cells[col].length)) {
+                fill->alloc_failed = true;
                 return false;
             }
-            *values = new_values;
-        }
-
-        // Add the token to the values array
-        (*values)[*values_size] = SAFE_STRNDUP(token);
-        if (!(*values)[*values_size]) {
-            perror("Memory allocation failed");
-            free(line_copy);
-            return false;
         }
-
-        // (*values_size)++;
-        if (!safe_size_t_increment(values_size)) return false;
-
-        token = strtok(NULL, delimiters);
-    }
-
-    // Ensure data is aligned properly
-    if (first_line) {
-        *data_width = current_width;
-    } else if (current_width != *data_width) {
-        fprintf(stderr, "Error: Line width (%d) does not match the expected width (%d)\n", current_width, *data_width);
-        fprintf(stderr, "Line prefix: %s, Row number: %d\n", line_copy, (num_lines + 1));
-        free(line_copy);
-        return false;
     }
 
-    free(line_copy); // Free the duplicated line
     return true;
 }
 
-// Store file contents and verify data alignment
-char **tokenize_file_contents(const char *file_name, 
-    header_strings requested_headers, header_integers *header_indeces,
-    int *store_data_width, int *store_num_lines, int *store_num_values) {    
-
-    FILE *spreadsheet_fp;
-    spreadsheet_fp = fopen(file_name, "r");
+static void free_bands(columnar_builder_t *bands, int num_bands) {
+    if (!bands) return;
+    for (int i = 0; i < num_bands; i++) columnar_builder_free(&bands[i]);
+    free(bands);
+}
 
-    if (spreadsheet_fp == NULL) { 
-        fprintf(stderr, "Error opening and parsing file contents (corrupted file pointer).\n");
-        return NULL;
-    }
-    
-    char **values = NULL;
-    size_t values_size = 0; // Hold number of values in values arr
-
-    int buffer_size = BUFFER_INCREMENT;
-    char *line = malloc(buffer_size); // Start with a line buffer of explicit size
-    if (!line) {
-        perror("Memory allocation failed");
-        fclose(spreadsheet_fp);
-        
+/*
+Tokenize the rows within bounds and copy their in-range columns
+@return one band of column builders per layout chunk in row order, NULL after reporting an error
+*/
+static columnar_builder_t *collect_bands(const table_layout_t *layout, header_integers bounds) {
+    int sub_width = (bounds.ending_column - bounds.starting_column) + 1;
+
+    subregion_fill_t *fills = calloc(layout->num_chunks, sizeof(subregion_fill_t));
+    void **contexts = malloc(layout->num_chunks * sizeof(void *));
+    columnar_builder_t *bands = malloc(layout->num_chunks * sizeof(columnar_builder_t));
+    if (!fills || !contexts || !bands) {
+        perror("malloc failed for subregion");
+        free(fills);
+        free(contexts);
+        free(bands);
         return NULL;
     }
 
-    int line_size = 0; // Number of characters in the current line
-    signed char ch; // Keep upper bits
-
-    bool first_line = true; // Store data width on first line
-    int data_width = 0, num_lines = 0; 
-    while ((ch = fgetc(spreadsheet_fp)) != EOF) {
-        // Acquired line
-        if (ch == '\n') {
-            line[line_size] = '\0'; // Null-terminate the string
-
-            // Add line to values array
-            if (!process_line(line, requested_headers, header_indeces, 
-                              &values, &values_size, 
-                              num_lines,  &data_width, first_line)) {
-
-                fprintf(stderr, "File format error detected.\n");
-                free(line);
-                fclose(spreadsheet_fp);
-
-                free_matrix(values, values_size);
-                return NULL;
-            }
-
-            // Reset for the next line
-            line_size = 0;
-
-            first_line = false;
-
-            if (!safe_increment(&num_lines)) return NULL;
-            continue;
-        }
-
-        // If we have exceeded the buffer size
-        if (line_size >= buffer_size - 1) { // Room for null terminator
-            if (INT_MAX - buffer_size > BUFFER_INCREMENT) {
-                buffer_size += BUFFER_INCREMENT;
-            }
-            else {
-                fprintf(stderr, "Error: Maximum number of values (%d) exceeded.\n", INT_MAX);
-                return NULL;
-            }
-
-            char *new_line = realloc(line, buffer_size);
-            if (!new_line) {
-                perror("Memory reallocation failed");
-                free(line);
-                fclose(spreadsheet_fp);
-                free_matrix(values, values_size);
-                return NULL;
-            }
-    
-            line = new_line;
-        }
-
-        // Add the character to the buffer        
-        line[line_size] = ch;
-        if (!safe_increment(&line_size)) return NULL;
+    bool collected = true;
+    for (int i = 0; i < layout->num_chunks; i++) {
+        fills[i].bounds = bounds;
+        contexts[i] = &fills[i];
+        collected &= columnar_builder_init(&fills[i].builder, sub_width);
     }
 
-    // Operate on final line
-    if (line_size > 0) {
-        line[line_size] = '\0'; // Null-terminate the string
-        if (!process_line(line, requested_headers, header_indeces, 
-                              &values, &values_size, 
-                              num_lines,  &data_width, first_line)) {
-            fprintf(stderr, "File format error detected.\n");
-            free(line);
-            fclose(spreadsheet_fp);
-            free_matrix(values, values_size);
-            return NULL;
-        }
-        num_lines++;
+    if (collected) {
+        collected = stream_table_rows(layout, bounds.starting_row, bounds.ending_row, collect_window, contexts);
     }
+    if (!collected) {
+        bool alloc_failed = false;
+        for (int i = 0; i < layout->num_chunks; i++) alloc_failed |= fills[i].alloc_failed;
 
-    *store_data_width = data_width;
-    *store_num_lines = num_lines;
-    *store_num_values = values_size;
-
-    free(line);
-    fclose(spreadsheet_fp);
-
-    return values;
-}
-
-__attribute__((visibility("default"))) int load_data(const char *file_name,
-    const char *starting_row, const char *ending_row, 
-    const char *starting_column, const char *ending_column,
-    int operations,
-    int thread_count) {
-
-    // Variables to store integer or string interpretations
-    int starting_row_int = -1, ending_row_int = -1;
-    int starting_column_int = -1, ending_column_int = -1;
-
-    char *starting_row_string = NULL, *ending_row_string = NULL;
-    char *starting_column_string = NULL, *ending_column_string = NULL;
-
-    #define CONVERT_IF_NUMERIC(input, output_int, output_string)              \
-        do {                                                                  \
-            char *endptr = NULL;                                              \
-            errno = 0;                                                        \
-            long val = strtol((input), &endptr, 10);                          \
-            if (errno == 0 && endptr != input && *endptr == '\0' &&           \
-                val >= INT_MIN && val <= INT_MAX) {                           \
-                (output_int) = (int)(val - 1);                                \
-            } else {                                                          \
-                (output_string) = SAFE_STRNDUP(input);                        \
-            }                                                                 \
-        } while (0)
-
-    // Store header indeces in integer structure
-    CONVERT_IF_NUMERIC(starting_row, starting_row_int, starting_row_string);
-    CONVERT_IF_NUMERIC(ending_row, ending_row_int, ending_row_string);
-    CONVERT_IF_NUMERIC(starting_column, starting_column_int, starting_column_string);
-    CONVERT_IF_NUMERIC(ending_column, ending_column_int, ending_column_string);
-
-    // Populate strings for header search
-    header_strings header_strings = {
-        .starting_row = starting_row_string,
-        .ending_row= ending_row_string,
-        .starting_column = starting_column_string,
-        .ending_column = ending_column_string
-    };
-
-    // Populate the header_integers structure for subregion buildout
-    header_integers header_integers = {
-        .starting_row = (header_strings.starting_row) ? -1 : starting_row_int,
-        .ending_row = (header_strings.ending_row) ? -1 : ending_row_int,
-        .starting_column = (header_strings.starting_column) ? -1 : starting_column_int,
-        .ending_column = (header_strings.ending_column) ? -1 : ending_column_int
-    };
+        alloc_failed ? fprintf(stderr, "Memory allocation failed at subregion handoff\n") :
+                       fprintf(stderr, "Error opening and parsing file contents.\n");
+    }
 
-    /*
-    Hold data, get dimensions, number of values, and validate width consistency across rows
-    Populate the header_integers structure with retrieved headers
-    */ 
-
-    int data_width = 0, num_lines = 0, values_size = 0; // Num columns, num rows, num tokens
-    char **values = tokenize_file_contents(file_name, header_strings, &header_integers, 
-                                          &data_width, &num_lines, &values_size);
-    if (!values) {
-        fprintf(stderr, "Error opening and parsing file contents.\n");
-        
-        // Free allocated memory for header strings
-        free_header_strings(&header_strings);
-        
-        return 1;
+    for (int i = 0; i < layout->num_chunks; i++) {
+        if (collected) bands[i] = fills[i].builder;
+        else columnar_builder_free(&fills[i].builder);
     }
+    free(fills);
+    free(contexts);
 
-    // Verify spreadsheet dimensions
-    if (data_width < 2 || num_lines < 2) {
-        free_matrix(values, values_size);
-        free_header_strings(&header_strings);
+    if (!collected) {
+        free(bands);
+        return NULL;
+    }
+    return bands;
+}
 
-        fprintf(stderr, "Error: Expects >=2 by >=2 dimensions in CSV file.\n");
-        fprintf(stderr, "Dimensions (height by width): %d by %d\n", num_lines, data_width);
-        fprintf(stderr, "File format error detected.\n");
-        
-        return 1;
+// Send out the operations on the subregion to be performed across threads, releases the subregion
+static int run_marshaller(columnar_subregion_t *subregion, int operations, int thread_count,
+    const query_options_t *options, final_args_t *results) {
+    int marshaller = marshall_operations(subregion, operations, thread_count, options, results);
+    if (marshaller) {
+        fprintf(stderr, "Error: marshall_operations failed to compute operation (returned %d)\n", marshaller);
     }
 
-    /*
-    Reject inputs that have mixed headers, i.e. numbers in column headers, 
-    numbers in row headers
-    */ 
+    free_columnar_subregion(subregion);
+    return marshaller ? 1 : 0;
+}
 
-    bool column_headers = true;
+/*
+Reject inputs that have mixed headers, i.e. numbers in column headers, 
+numbers in row headers
+@param first_row: cells of the first line
+@param any_first_cell_numeric: over the first cell of every line
+@param trailing_first_cells_numeric: over the first cell of every line but the first
+*/ 
+static bool classify_headers(const char *data, const cell_view_t *first_row, int data_width,
+    bool any_first_cell_numeric, bool trailing_first_cells_numeric,
+    bool *column_headers, bool *row_headers) {
+
+    *column_headers = true;
     for (int i = 0; i < data_width; i++) {
-        if (is_valid_double(values[i])) {
-            column_headers = false;
+        if (is_valid_double_n(data + first_row[i].offset, first_row[i].length)) {
+            *column_headers = false;
             break;
         }
     }
 
     // We don't have column headers, i.e. not all strings
-    if (!column_headers) {
+    if (!*column_headers) {
         // The first can be a string or a number, the rest have to be numbers
         for (int i = 1; i < data_width; i++) {
             // Not all numbers 
-            if (!is_valid_double(values[i])) {
+            if (!is_valid_double_n(data + first_row[i].offset, first_row[i].length)) {
                 fprintf(stderr, "Error: Data formatting expects headers to be numerical or lexicographical.\n");
                 fprintf(stderr, "Mixed formatting: column header\n");
                 fprintf(stderr, "File format error detected.\n");
-                
-                free_matrix(values, values_size);
-                free_header_strings(&header_strings);
-
-                return 1;
+                return false;
             }
         }
     }
 
     // Verify row header formatting
-    bool row_headers = true;
-    for (int i = 0; i <= values_size - data_width; i += data_width) { 
-        if (is_valid_double(values[i])) {
-            row_headers = false;
-            break;
-        }
-    }
+    *row_headers = !any_first_cell_numeric;
 
     // We don't have row headers, i.e. not all strings
-    if (!row_headers) {
-        for (int i = data_width; i <= values_size - data_width; i += data_width) {
-            // Not all numbers
-            if (!is_valid_double(values[i])) {
-                fprintf(stderr, "Error: Data formatting expects headers to be numerical or lexicographical.\n");
-                fprintf(stderr, "Mixed formatting: row headers\n");
-                fprintf(stderr, "File format error detected.\n");
-                
-                free_matrix(values, values_size);
-                free_header_strings(&header_strings);
-
-                return 1;
-            }
+    if (!*row_headers) {
+        // Not all numbers
+        if (!trailing_first_cells_numeric) {
+            fprintf(stderr, "Error: Data formatting expects headers to be numerical or lexicographical.\n");
+            fprintf(stderr, "Mixed formatting: row headers\n");
+            fprintf(stderr, "File format error detected.\n");
+            return false;
         }
 
-        if (!column_headers && !is_valid_double(values[0])) {
+        if (!*column_headers && !is_valid_double_n(data + first_row[0].offset, first_row[0].length)) {
             fprintf(stderr, "Error: Data formatting expects headers to be numerical or lexicographical.\n");
             fprintf(stderr, "Mixed formatting: column headers\n");
             fprintf(stderr, "File format error detected.\n");
-            
-            free_matrix(values, values_size);
-            free_header_strings(&header_strings);
-            
-            return 1;
+            return false;
         } 
     }
 
+    return true;
+}
+
+/*
+Turn the requested headers into in-range, ordered indeces
+@param header_strings: requested header names, NULL for numeric requests
+@param header_integers: numeric requests and matched header positions, resolved in place
+*/
+static bool resolve_bounds(const header_strings *header_strings, header_integers *header_integers,
+    bool column_headers, bool row_headers, int num_lines, int data_width) {
+
     // Adjust initial bounds if column headers are present
     if (column_headers) {
         // We skip the first row for data if there's a column header
-        if (header_integers.starting_row != -1 & header_strings.starting_row == NULL) header_integers.starting_row++;
-        if (header_integers.ending_row != -1 & header_strings.ending_row == NULL) header_integers.ending_row++;
+        if (header_integers->starting_row != -1 & header_strings->starting_row == NULL) header_integers->starting_row++;
+        if (header_integers->ending_row != -1 & header_strings->ending_row == NULL) header_integers->ending_row++;
 
         // If the user specified "full", adjust accordingly
-        if (header_strings.starting_row && strcmp(header_strings.starting_row, "full") == 0) {
-            header_integers.starting_row = 1;  // start after the header row
+        if (header_strings->starting_row && strcmp(header_strings->starting_row, "full") == 0) {
+            header_integers->starting_row = 1;  // start after the header row
         }
 
-        if (header_strings.ending_row && strcmp(header_strings.ending_row, "full") == 0) {
+        if (header_strings->ending_row && strcmp(header_strings->ending_row, "full") == 0) {
             // Make sure we don't exceed file bounds
-            header_integers.ending_row = num_lines - 1;
+            header_integers->ending_row = num_lines - 1;
         }
     }
 
     // Adjust bounds if row headers are present
     if (row_headers) {
         // Skip the first column if there's a row header
-        if (header_integers.starting_column != -1 & header_strings.starting_column == NULL) header_integers.starting_column++;
-        if (header_integers.ending_column != -1 & header_strings.ending_column == NULL) header_integers.ending_column++;
+        if (header_integers->starting_column != -1 & header_strings->starting_column == NULL) header_integers->starting_column++;
+        if (header_integers->ending_column != -1 & header_strings->ending_column == NULL) header_integers->ending_column++;
 
         // If the user specified "full" for columns
-        if (header_strings.starting_column && strcmp(header_strings.starting_column, "full") == 0) {
-            header_integers.starting_column = 1;  // skip header column
+        if (header_strings->starting_column && strcmp(header_strings->starting_column, "full") == 0) {
+            header_integers->starting_column = 1;  // skip header column
         }
 
-        if (header_strings.ending_column && strcmp(header_strings.ending_column, "full") == 0) {
-            header_integers.ending_column = data_width - 1;
+        if (header_strings->ending_column && strcmp(header_strings->ending_column, "full") == 0) {
+            header_integers->ending_column = data_width - 1;
         }
     }
 
     // General fallback (if headers weren't present, still handle "full")
     if (!column_headers) {
-        if (header_strings.starting_row && strcmp(header_strings.starting_row, "full") == 0) {
-            header_integers.starting_row = 0;
+        if (header_strings->starting_row && strcmp(header_strings->starting_row, "full") == 0) {
+            header_integers->starting_row = 0;
         }
-        if (header_strings.ending_row && strcmp(header_strings.ending_row, "full") == 0) {
-            header_integers.ending_row = num_lines - 1;
+        if (header_strings->ending_row && strcmp(header_strings->ending_row, "full") == 0) {
+            header_integers->ending_row = num_lines - 1;
         }
     }
     if (!row_headers) {
-        if (header_strings.starting_column && strcmp(header_strings.starting_column, "full") == 0) {
-            header_integers.starting_column = 0;
+        if (header_strings->starting_column && strcmp(header_strings->starting_column, "full") == 0) {
+            header_integers->starting_column = 0;
         }
-        if (header_strings.ending_column && strcmp(header_strings.ending_column, "full") == 0) {
-            header_integers.ending_column = data_width - 1;
+        if (header_strings->ending_column && strcmp(header_strings->ending_column, "full") == 0) {
+            header_integers->ending_column = data_width - 1;
         }
     }
 
     // If we can't find one of the requested headers or they are out of bounds
-    if (header_integers.starting_row <= -1 || 
-        header_integers.ending_row <= -1 ||
-        header_integers.starting_column <= -1 || 
-        header_integers.ending_column <= -1 ||
-        header_integers.starting_row >= num_lines ||
-        header_integers.ending_row >= num_lines || 
-        header_integers.starting_column >= data_width || 
-        header_integers.ending_column >= data_width
+    if (header_integers->starting_row <= -1 || 
+        header_integers->ending_row <= -1 ||
+        header_integers->starting_column <= -1 || 
+        header_integers->ending_column <= -1 ||
+        header_integers->starting_row >= num_lines ||
+        header_integers->ending_row >= num_lines || 
+        header_integers->starting_column >= data_width || 
+        header_integers->ending_column >= data_width
     ) {
         fprintf(stderr, "Error: Requested dimensions not found or exceeded dimensions (indexed from 0).\n");
 
-        if (header_integers.starting_row == -1 || header_integers.starting_row >= num_lines) {
-            header_strings.starting_row ? 
-                fprintf(stderr, "   Requested starting row: %s\n", header_strings.starting_row) : 
-                fprintf(stderr, "   Requested starting row: %d\n", header_integers.starting_row);
+        if (header_integers->starting_row == -1 || header_integers->starting_row >= num_lines) {
+            header_strings->starting_row ? 
+                fprintf(stderr, "   Requested starting row: %s\n", header_strings->starting_row) : 
+                fprintf(stderr, "   Requested starting row: %d\n", header_integers->starting_row);
                 fprintf(stderr, "   File number of row(s): %d\n", num_lines);
         }
-        if (header_integers.ending_row == -1 || header_integers.ending_row >= num_lines) {
-            header_strings.ending_row ? 
-                fprintf(stderr, "   Requested ending row: %s\n", header_strings.ending_row) : 
-                fprintf(stderr, "   Requested ending row: %d\n", header_integers.ending_row);
+        if (header_integers->ending_row == -1 || header_integers->ending_row >= num_lines) {
+            header_strings->ending_row ? 
+                fprintf(stderr, "   Requested ending row: %s\n", header_strings->ending_row) : 
+                fprintf(stderr, "   Requested ending row: %d\n", header_integers->ending_row);
                 fprintf(stderr, "   File number of row(s): %d\n", num_lines);
         }
-        if (header_integers.starting_column == -1 || header_integers.starting_column >= data_width) {
-            header_strings.starting_column ? 
-                fprintf(stderr, "   Requested starting column: %s\n", header_strings.starting_column) : 
-                fprintf(stderr, "   Requested starting column: %d\n", header_integers.starting_column);
+        if (header_integers->starting_column == -1 || header_integers->starting_column >= data_width) {
+            header_strings->starting_column ? 
+                fprintf(stderr, "   Requested starting column: %s\n", header_strings->starting_column) : 
+                fprintf(stderr, "   Requested starting column: %d\n", header_integers->starting_column);
                 fprintf(stderr, "   File number of columns: %d\n", data_width);
         }
-        if (header_integers.ending_column == -1 || header_integers.ending_column >= data_width) {
-            header_strings.ending_column ? 
-                fprintf(stderr, "   Requested ending column: %s\n", header_strings.ending_column) : 
-                fprintf(stderr, "   Requested ending column: %d\n", header_integers.ending_column);
+        if (header_integers->ending_column == -1 || header_integers->ending_column >= data_width) {
+            header_strings->ending_column ? 
+                fprintf(stderr, "   Requested ending column: %s\n", header_strings->ending_column) : 
+                fprintf(stderr, "   Requested ending column: %d\n", header_integers->ending_column);
                 fprintf(stderr, "   File number of columns: %d\n", data_width);
         }
 
-        // Free allocated memory
-        free_matrix(values, values_size);
-        free_header_strings(&header_strings);
-
-        // Exit with error
-        return 1;
+        return false;
     }
 
     // Switch values if the first or last need to be switched, i.e. end > start
-    int starting_row_copy = header_integers.starting_row;
-    int ending_row_copy = header_integers.ending_row;
-    int starting_column_copy = header_integers.starting_column;
-    int ending_column_copy = header_integers.ending_column;
+    int starting_row_copy = header_integers->starting_row;
+    int ending_row_copy = header_integers->ending_row;
+    int starting_column_copy = header_integers->starting_column;
+    int ending_column_copy = header_integers->ending_column;
     
     // Set these in order
-    header_integers.starting_row = min(starting_row_copy, ending_row_copy);
-    header_integers.ending_row = max(starting_row_copy, ending_row_copy);
-    header_integers.starting_column = min(starting_column_copy, ending_column_copy);
-    header_integers.ending_column = max(starting_column_copy, ending_column_copy);
+    header_integers->starting_row = min(starting_row_copy, ending_row_copy);
+    header_integers->ending_row = max(starting_row_copy, ending_row_copy);
+    header_integers->starting_column = min(starting_column_copy, ending_column_copy);
+    header_integers->ending_column = max(starting_column_copy, ending_column_copy);
 
-    // Free the strings allocated to store requested headers
-    free_header_strings(&header_strings);
+    return true;
+}
 
-    // Grab values from the array
-    int sub_width = (header_integers.ending_column - header_integers.starting_column) + 1;
-    int sub_height = (header_integers.ending_row - header_integers.starting_row) + 1;
-    char **subregion = malloc(sizeof(char *) * sub_width * sub_height);
-    if (!subregion) {
-        perror("malloc failed for subregion");
-        exit(EXIT_FAILURE);
+// A file opened for one or more queries, see fd_open
+struct dataframe {
+    char *file_name;
+    int thread_count;        // Scan threads, also the streaming chunks of the layout
+    sidecar_t table;         // Whole table and its header indexes, the mapped .fdc or parsed into memory
+    bool has_table;
+    table_layout_t layout;   // Mapped CSV, what streaming, pipelining and one-off queries tokenize
+    bool has_layout;
+    bool column_headers;
+    bool row_headers;
+};
+
+/*
+Map the CSV, get dimensions and validate the headers without tokenizing the body
+@param requested_headers: matched during the scan into header_integers, none when the table will match them
+*/
+static bool scan_frame(dataframe_t *frame, header_strings requested_headers, header_integers *header_integers) {
+    if (!scan_table_layout(frame->file_name, requested_headers, header_integers, &frame->layout, frame->thread_count)) {
+        fprintf(stderr, "Error opening and parsing file contents.\n");
+        return false;
     }
+    frame->has_layout = true;
 
-    // Build out the subregion from the values array
-    int i = 0;
-    for (int row = 0; row < sub_height; row++) {
-        for (int col = 0; col < sub_width; col++) {
-            int original_index = (header_integers.starting_row + row) * data_width + (header_integers.starting_column + col);
-
-            size_t len = strlen(values[original_index]) + 1;
-            subregion[i] = malloc(len);
-            if (!subregion[i]) {
-                fprintf(stderr, "Memory allocation failed at subregion handoff\n");
-                free_matrix(values, values_size);
-                return 1;
-            }
-            memcpy(subregion[i], values[original_index], len);
-            i++;
+    int data_width = frame->layout.data_width, num_lines = frame->layout.num_lines; // Num columns, num rows
+
+    // Verify spreadsheet dimensions
+    if (data_width < 2 || num_lines < 2) {
+        fprintf(stderr, "Error: Expects >=2 by >=2 dimensions in CSV file.\n");
+        fprintf(stderr, "Dimensions (height by width): %d by %d\n", num_lines, data_width);
+        fprintf(stderr, "File format error detected.\n");
+        return false;
+    }
+
+    return classify_headers(frame->layout.data, frame->layout.first_row, data_width,
+                            frame->layout.any_first_cell_numeric, frame->layout.trailing_first_cells_numeric,
+                            &frame->column_headers, &frame->row_headers);
+}
+
+static void close_frame(dataframe_t *frame) {
+    if (frame->has_layout) free_table_layout(&frame->layout);
+    if (frame->has_table) close_sidecar(&frame->table);
+    free(frame->file_name);
+    memset(frame, 0, sizeof(*frame));
+}
+
+/*
+@param use_sidecar: a current sidecar stands in for the CSV, header names are then matched per query
+@return false after reporting an error, the frame must still be closed
+*/
+static bool open_frame(dataframe_t *frame, const char *file_name, int thread_count, bool use_sidecar,
+    header_strings requested_headers, header_integers *header_integers) {
+
+    memset(frame, 0, sizeof(*frame));
+    frame->thread_count = thread_count;
+    frame->file_name = SAFE_STRNDUP(file_name);
+    if (!frame->file_name) {
+        fprintf(stderr, "Failed to allocate memory for file name\n");
+        return false;
+    }
+
+    if (use_sidecar && open_sidecar(file_name, &frame->table)) {
+        frame->has_table = true;
+        frame->column_headers = frame->table.column_headers;
+        frame->row_headers = frame->table.row_headers;
+        return true;
+    }
+
+    return scan_frame(frame, requested_headers, header_integers);
+}
+
+// Tokenize every line into the frame's table, the layout is released once the table holds the values
+static bool parse_frame_table(dataframe_t *frame) {
+    int data_width = frame->layout.data_width, num_lines = frame->layout.num_lines;
+
+    // Every line and column, header line and header column included
+    header_integers whole_table = { 0, num_lines - 1, 0, data_width - 1 };
+    columnar_builder_t *bands = collect_bands(&frame->layout, whole_table);
+    if (!bands) return false;
+
+    frame->has_table = sidecar_from_bands(bands, frame->layout.num_chunks, num_lines, data_width,
+                                          frame->column_headers, frame->row_headers, &frame->table);
+    free_bands(bands, frame->layout.num_chunks);
+    if (!frame->has_table) return false;
+
+    free_table_layout(&frame->layout);
+    frame->has_layout = false;
+    return true;
+}
+
+/*
+Run one query on an open frame
+@param header_strings: requested header names, matched through the table's indexes when the frame has one
+@param header_integers: numeric requests, and names the layout scan already matched
+*/
+static int query_frame(dataframe_t *frame, header_strings *header_strings, header_integers header_integers,
+    int operations, int thread_count, const query_options_t *options, final_args_t *results) {
+
+    if (frame->has_table && !sidecar_match_headers(&frame->table, *header_strings, &header_integers)) {
+        fprintf(stderr, "Error opening and parsing file contents.\n");
+        return 1;
+    }
+
+    int num_lines = frame->has_table ? frame->table.num_lines : frame->layout.num_lines;
+    int data_width = frame->has_table ? frame->table.data_width : frame->layout.data_width;
+    if (!resolve_bounds(header_strings, &header_integers, frame->column_headers, frame->row_headers,
+                        num_lines, data_width)) {
+        return 1;
+    }
+
+    // Slice the parsed table, only the offsets, native values and classes of the subregion are copied
+    bool bounded = operations & (OP_STREAM | OP_PIPELINE);
+    if (frame->has_table && !bounded) {
+        columnar_subregion_t subregion;
+        if (!sidecar_subregion(&frame->table, header_integers, &subregion)) return 1;
+
+        return run_marshaller(&subregion, operations, thread_count, options, results);
+    }
+
+    // Streaming and pipelining read the CSV itself, the names were already matched by the table
+    struct header_strings matched = {0};
+    struct header_integers unused = { -1, -1, -1, -1 };
+    if (!frame->has_layout && !scan_frame(frame, matched, &unused)) return 1;
+
+    // Aggregate while reading, the subregion is never held
+    if (operations & OP_STREAM) {
+        int streamer = stream_operations(&frame->layout, header_integers, operations, options, results);
+        if (streamer) {
+            fprintf(stderr, "Error: stream_operations failed to compute operation (returned %d)\n", streamer);
         }
+        return streamer ? 1 : 0;
     }
 
-    int subregion_size = sub_height * sub_width;
+    // Aggregate batches of rows while the rest of the file is parsed
+    if (operations & OP_PIPELINE) {
+        int pipeline = pipeline_operations(&frame->layout, header_integers, operations, thread_count, options, results);
+        if (pipeline) {
+            fprintf(stderr, "Error: pipeline_operations failed to compute operation (returned %d)\n", pipeline);
+        }
+        return pipeline ? 1 : 0;
+    }
 
-    // Pretty print the input data
-    pretty_print_values(values, values_size, data_width);
+    // Only the requested rows are tokenized and only the requested columns are copied
+    int sub_width = (header_integers.ending_column - header_integers.starting_column) + 1;
+    int sub_height = (header_integers.ending_row - header_integers.starting_row) + 1;
 
-    // for (int i = 0; i < values_size; i++) {
-    //     if (values[i]) {
-    //         printf("Value %d: %s\n", i, values[i]);
-    //     } else {
-    //         printf("Value %d: NULL\n", i);
-    //     }
-    // }
+    columnar_builder_t *bands = collect_bands(&frame->layout, header_integers);
 
-    free_matrix(values, values_size);
+    // Stitch the chunks' bands into one arena per column
+    columnar_subregion_t subregion = {0};
+    bool collected = bands && columnar_from_builders(bands, frame->layout.num_chunks, sub_height, sub_width, &subregion);
 
-    // Send out the operations on the subregion to be performed across threads
-    int marshaller = marshall_operations(subregion, sub_height, sub_width, subregion_size, operations, thread_count);
-    if (marshaller) {
-        fprintf(stderr, "Error: marshall_operations failed to compute operation (returned %d)\n", marshaller);
-        free_matrix(subregion, sub_height * sub_width);     
+    free_bands(bands, frame->layout.num_chunks);
+    if (!collected) return 1;
+
+    return run_marshaller(&subregion, operations, thread_count, options, results);
+}
+
+// Check the options against the operation bits, resolved gets the defaults when options is NULL
+static bool resolve_options(int operations, const query_options_t *options, query_options_t *resolved) {
+    *resolved = options ? *options : QUERY_OPTIONS_DEFAULT;
+    if (resolved->precision < 0 || resolved->precision > MAX_PRECISION) {
+        fprintf(stderr, "Error: Precision must be between 0 and %d (got %d).\n", MAX_PRECISION, resolved->precision);
+        return false;
+    }
+    if (resolved->axis < AXIS_ALL || resolved->axis > AXIS_ROWS) {
+        fprintf(stderr, "Error: Axis must be %d (whole subregion), %d (columns) or %d (rows) (got %d).\n",
+                AXIS_ALL, AXIS_COLUMNS, AXIS_ROWS, resolved->axis);
+        return false;
+    }
+    if (resolved->axis != AXIS_ALL && (operations & (OP_STREAM | OP_PIPELINE))) {
+        fprintf(stderr, "Error: Per column and per row results need the whole subregion and are not available when streaming or pipelining.\n");
+        return false;
+    }
+    if ((operations & OP_STREAM) && (operations & OP_PIPELINE)) {
+        fprintf(stderr, "Error: Streaming and pipelining are separate execution modes, pick one.\n");
+        return false;
+    }
+    quantile_t quantiles[MAX_QUANTILES];
+    if ((operations & OP_QUANTILES) && parse_quantiles(resolved->quantiles, quantiles) < 0) return false;
+
+    return true;
+}
+
+/*
+Numeric requests become 0-indexed integers, anything else is a header name to look up
+@param header_strings: out, free with free_header_strings
+*/
+static void parse_requested_headers(const char *starting_row, const char *ending_row,
+    const char *starting_column, const char *ending_column,
+    header_strings *header_strings, header_integers *header_integers) {
+
+    // Variables to store integer or string interpretations
+    int starting_row_int = -1, ending_row_int = -1;
+    int starting_column_int = -1, ending_column_int = -1;
+
+    char *starting_row_string = NULL, *ending_row_string = NULL;
+    char *starting_column_string = NULL, *ending_column_string = NULL;
+
+    #define CONVERT_IF_NUMERIC(input, output_int, output_string)              \
+        do {                                                                  \
+            char *endptr = NULL;                                              \
+            errno = 0;                                                        \
+            long val = strtol((input), &endptr, 10);                          \
+            if (errno == 0 && endptr != input && *endptr == '\0' &&           \
+                val >= INT_MIN && val <= INT_MAX) {                           \
+                (output_int) = (int)(val - 1);                                \
+            } else {                                                          \
+                (output_string) = SAFE_STRNDUP(input);                        \
+            }                                                                 \
+        } while (0)
+
+    // Store header indeces in integer structure
+    CONVERT_IF_NUMERIC(starting_row, starting_row_int, starting_row_string);
+    CONVERT_IF_NUMERIC(ending_row, ending_row_int, ending_row_string);
+    CONVERT_IF_NUMERIC(starting_column, starting_column_int, starting_column_string);
+    CONVERT_IF_NUMERIC(ending_column, ending_column_int, ending_column_string);
+
+    #undef CONVERT_IF_NUMERIC
+
+    // Populate strings for header search
+    *header_strings = (struct header_strings){
+        .starting_row = starting_row_string,
+        .ending_row= ending_row_string,
+        .starting_column = starting_column_string,
+        .ending_column = ending_column_string
+    };
+
+    // Populate the header_integers structure for subregion buildout
+    *header_integers = (struct header_integers){
+        .starting_row = (header_strings->starting_row) ? -1 : starting_row_int,
+        .ending_row = (header_strings->ending_row) ? -1 : ending_row_int,
+        .starting_column = (header_strings->starting_column) ? -1 : starting_column_int,
+        .ending_column = (header_strings->ending_column) ? -1 : ending_column_int
+    };
+}
+
+/*
+Parse and validate a file once for any number of fd_query calls. The whole table is tokenized into
+memory with its header indexes, or mapped from a current sidecar, so a query only slices it.
+@param thread_count: upper bound on parse threads, also the chunks a streamed or pipelined query reads
+@return NULL after reporting an error, release with fd_close
+*/
+__attribute__((visibility("default"))) dataframe_t *fd_open(const char *file_name, int thread_count) {
+    dataframe_t *frame = malloc(sizeof(dataframe_t));
+    if (!frame) {
+        fprintf(stderr, "Failed to allocate memory for dataframe\n");
+        return NULL;
+    }
+
+    header_strings no_headers = {0};
+    header_integers unused = { -1, -1, -1, -1 };
+    bool opened = open_frame(frame, file_name, thread_count, true, no_headers, &unused) &&
+                  (frame->has_table || parse_frame_table(frame));
+    if (!opened) {
+        close_frame(frame);
+        free(frame);
+        return NULL;
+    }
+
+    printf("🗂️  Opened %s (%d rows, %d columns%s).\n", file_name, frame->table.num_lines, frame->table.data_width,
+           frame->table.in_memory ? "" : ", from its sidecar");
+    return frame;
+}
+
+/*
+Same request as load_data_with_options on an open dataframe, nothing is reparsed
+@param options: NULL for the defaults
+@param results: out when not NULL, the whole-subregion results that were printed, empty for an axis
+@return 0 on success
+*/
+__attribute__((visibility("default"))) int fd_query(dataframe_t *frame,
+    const char *starting_row, const char *ending_row,
+    const char *starting_column, const char *ending_column,
+    int operations,
+    int thread_count,
+    const query_options_t *options,
+    final_args_t *results) {
+
+    if (results) memset(results, 0, sizeof(*results));
+    if (!frame) {
+        fprintf(stderr, "Error: fd_query needs a dataframe from fd_open.\n");
         return 1;
     }
 
-    free_matrix(subregion, sub_height * sub_width);
- 
-    return 0;
+    query_options_t resolved;
+    if (!resolve_options(operations, options, &resolved)) return 1;
+
+    header_strings header_strings;
+    header_integers header_integers;
+    parse_requested_headers(starting_row, ending_row, starting_column, ending_column, &header_strings, &header_integers);
+
+    int result = query_frame(frame, &header_strings, header_integers, operations, thread_count, &resolved, results);
+
+    free_header_strings(&header_strings);
+    return result;
 }
 
+__attribute__((visibility("default"))) void fd_close(dataframe_t *frame) {
+    if (!frame) return;
+    close_frame(frame);
+    free(frame);
+}
 
+/*
+Same as load_data, with the value options that ride along with the operation bits
+@param options: precision of the mean and median, the quantile list and the axis, NULL for the defaults
+ */
+__attribute__((visibility("default"))) int load_data_with_options(const char *file_name,
+    const char *starting_row, const char *ending_row,
+    const char *starting_column, const char *ending_column,
+    int operations,
+    int thread_count,
+    const query_options_t *options) {
+
+    query_options_t resolved;
+    if (!resolve_options(operations, options, &resolved)) return 1;
+
+    header_strings header_strings;
+    header_integers header_integers;
+    parse_requested_headers(starting_row, ending_row, starting_column, ending_column, &header_strings, &header_integers);
+
+    /*
+    A one-off dataframe: a current sidecar replaces the text parse entirely, otherwise the names are matched
+    while the layout is scanned and only the requested rows get tokenized. Streaming and pipelining keep
+    reading the CSV in bounded memory
+    */
+    dataframe_t frame;
+    int result = 1;
+    if (open_frame(&frame, file_name, thread_count, !(operations & (OP_STREAM | OP_PIPELINE)), header_strings, &header_integers)) {
+        result = query_frame(&frame, &header_strings, header_integers, operations, thread_count, &resolved, NULL);
+    }
+
+    close_frame(&frame);
+    free_header_strings(&header_strings);
+    return result;
+}
 
+__attribute__((visibility("default"))) int load_data(const char *file_name,
+    const char *starting_row, const char *ending_row, 
+    const char *starting_column, const char *ending_column,
+    int operations,
+    int thread_count) {
+
+    return load_data_with_options(file_name, starting_row, ending_row, starting_column, ending_column,
+                                  operations, thread_count, NULL);
+}
+
+/*
+One-time conversion of a CSV into its binary columnar sidecar (file_name.fdc),
+later load_data calls on the same file map it instead of parsing the text
+@return 0 when the sidecar was written or is already current
+*/
+__attribute__((visibility("default"))) int build_sidecar(const char *file_name, int thread_count) {
+    if (sidecar_current(file_name)) {
+        printf("🗂️  Sidecar %s%s is up to date.\n", file_name, SIDECAR_EXTENSION);
+        return 0;
+    }
+
+    header_strings no_headers = {0};
+    header_integers unused = { -1, -1, -1, -1 };
+
+    dataframe_t frame;
+    if (!open_frame(&frame, file_name, thread_count, false, no_headers, &unused)) {
+        close_frame(&frame);
+        return 1;
+    }
+
+    // Every line and column, header line and header column included
+    int data_width = frame.layout.data_width, num_lines = frame.layout.num_lines;
+    header_integers whole_table = { 0, num_lines - 1, 0, data_width - 1 };
+    columnar_builder_t *bands = collect_bands(&frame.layout, whole_table);
+    int num_bands = frame.layout.num_chunks;
+    bool column_headers = frame.column_headers, row_headers = frame.row_headers;
+    close_frame(&frame);
+    if (!bands) return 1;
+
+    bool written = write_sidecar(file_name, bands, num_bands, num_lines, data_width, column_headers, row_headers);
+    free_bands(bands, num_bands);
+    if (!written) return 1;
+
+    printf("🗂️  Wrote sidecar %s%s (%d rows, %d columns).\n", file_name, SIDECAR_EXTENSION, num_lines, data_width);
+    return 0;
+}
@@ -0,0 +1,467 @@
+// pipeline.c
+#include "pipeline.h"
+#include "../marshaller/marshaller.h"
+#include "../../arithmetic_lib/fat_data/fat_data.h"
+#include "../../arithmetic_lib/statistical_ops/statistical_ops.h"
+#include "../../arithmetic_lib/sorting/sort_key/sort_key.h"
+#include "../../arithmetic_lib/ring_buffer/ring_buffer.h"
+#include "../../arithmetic_lib/thread_pool/thread_pool.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Values per batch, whole columnar blocks like a block of the aggregate job
+#ifndef PIPELINE_BATCH_VALUES
+#define PIPELINE_BATCH_VALUES (16 * COLUMNAR_BLOCK_VALUES)
+#endif
+
+// Batches in flight per worker, enough for a parser to fill one while another is aggregated
+#define PIPELINE_BATCHES_PER_WORKER 2
+
+#define INITIAL_BATCH_BYTES (1 << 16)
+
+// Consecutive rows of the subregion, column-major with a stride of the batch's capacity in rows
+typedef struct {
+    columnar_subregion_t region;   // num_rows counts the rows filled, arrays are refilled in place
+    unsigned char *classes;        // number_class_t of each value
+    size_t bytes_capacity;
+    int first_row;                 // Subregion row of the batch's first row
+} pipeline_batch_t;
+
+// Running max or min of one worker, by value since batches are reused
+typedef struct {
+    bool set;
+    size_t index;                  // Column-major index in the subregion, the lower one wins ties
+    sort_key_buffer_t key;
+    char value[MAX_NUMBER_LENGTH];
+} kept_extreme_t;
+
+typedef struct {
+    kept_extreme_t max;
+    kept_extreme_t min;
+} pipeline_extremes_t;
+
+typedef struct {
+    header_integers bounds;
+    int sub_width;
+    int sub_height;
+    int folds;
+
+    pipeline_batch_t *batches;
+    int num_batches;
+    int batch_rows;                // Rows each batch holds
+    ring_buffer_t free_batches;    // Ready to fill
+    ring_buffer_t full_batches;    // Ready to aggregate, in no particular order
+
+    row_stream_t *stream;
+    int num_parsers;               // Pool tasks [0, num_parsers) parse, the rest aggregate
+    atomic_int parsing;            // Parsers not yet done with their chunk
+    atomic_bool failed;
+
+    local_aggregate_t *aggregates; // One per pool worker: sum and counts over every batch, max and min of the last one
+    pipeline_extremes_t *extremes; // One per pool worker, over every batch
+    int num_workers;
+} pipeline_t;
+
+// One layout chunk's parser, the visitor context
+typedef struct {
+    pipeline_t *pipeline;
+    int worker;                    // Pool worker running the chunk, aggregates under its name when it has to
+    int next_row;                  // Subregion row of the chunk's next streamed row
+    bool holding;
+    size_t batch;                  // Being filled while holding
+} pipeline_parser_t;
+
+static bool init_batch(pipeline_batch_t *batch, int batch_rows, int sub_width) {
+    size_t values = (size_t)batch_rows * sub_width;
+    size_t blocks = (values + COLUMNAR_BLOCK_VALUES - 1) / COLUMNAR_BLOCK_VALUES;
+
+    batch->region.offsets = malloc(values * sizeof(size_t));
+    batch->region.ints = malloc(values * sizeof(int64_t));
+    batch->region.block_classes = malloc(blocks);
+    batch->region.bytes = malloc(INITIAL_BATCH_BYTES);
+    batch->classes = malloc(values);
+    batch->bytes_capacity = INITIAL_BATCH_BYTES;
+    batch->region.num_columns = sub_width;
+
+    return batch->region.offsets && batch->region.ints && batch->region.block_classes &&
+           batch->region.bytes && batch->classes;
+}
+
+/*
+    Put a batch on a queue. Neither queue can fill since each has room for every batch, a push
+    only fails for a moment while a pop of the slot one lap back is still finishing
+ */
+static void queue_batch(ring_buffer_t *queue, size_t index) {
+    while (!ring_buffer_push(queue, index)) sched_yield();
+}
+
+// Aggregate a full batch into a worker's state, then hand it back to the parsers
+static bool aggregate_batch(pipeline_t *pipeline, int worker_index, size_t index) {
+    pipeline_batch_t *batch = &pipeline->batches[index];
+    columnar_subregion_t *region = &batch->region;
+    local_aggregate_t *aggregate = &pipeline->aggregates[worker_index];
+    pipeline_extremes_t *extremes = &pipeline->extremes[worker_index];
+    size_t rows = (size_t)region->num_rows, capacity = (size_t)pipeline->batch_rows;
+
+    // A short batch closes the gaps between its columns
+    for (size_t c = 1; rows < capacity && c < (size_t)region->num_columns; c++) {
+        memmove(region->offsets + c * rows, region->offsets + c * capacity, rows * sizeof(size_t));
+        memmove(region->ints + c * rows, region->ints + c * capacity, rows * sizeof(int64_t));
+        memmove(batch->classes + c * rows, batch->classes + c * capacity, rows);
+    }
+
+    if ((pipeline->folds & AGGREGATE_COUNTS) && !aggregate->partitions) {
+        aggregate->partitions = calloc(pipeline->num_workers, sizeof(hashmap_t *));
+        aggregate->num_partitions = pipeline->num_workers;
+        for (int p = 0; aggregate->partitions && p < pipeline->num_workers; p++) {
+            aggregate->partitions[p] = hashmap_create();
+            if (!aggregate->partitions[p]) return false;
+        }
+        if (!aggregate->partitions) {
+            fprintf(stderr, "Error creating hashmap for local frequency map\n");
+            return false;
+        }
+    }
+
+    // The kernel's extremes index into the batch, they restart with each one and are kept by value
+    aggregate->max.set = false;
+    aggregate->min.set = false;
+    size_t num_values = rows * region->num_columns;
+    if (!columnar_tag_blocks(region, batch->classes) ||
+        !compute_local_aggregate(aggregate, pipeline->folds, region, 0, num_values, NULL, NULL)) {
+        return false;
+    }
+
+    running_extreme_t *batch_extremes[2] = { &aggregate->max, &aggregate->min };
+    kept_extreme_t *kept_extremes[2] = { &extremes->max, &extremes->min };
+    for (int e = 0; e < 2; e++) {
+        running_extreme_t *found = batch_extremes[e];
+        kept_extreme_t *kept = kept_extremes[e];
+        if (!found->set) continue;
+
+        const char *value = columnar_value(region, found->index);
+        const sort_key_t *key = &found->key.key;
+        if (!found->encoded) {
+            if (!sort_key_buffer_set(&aggregate->candidate, value, strlen(value))) return false;
+            key = &aggregate->candidate.key;
+        }
+
+        size_t position = (size_t)(found->index / rows) * pipeline->sub_height + batch->first_row + found->index % rows;
+        int direction = e == 0 ? 1 : -1;
+        int cmp = kept->set ? sort_key_compare(key, &kept->key.key) : direction;
+        if (cmp == 0 && position < kept->index) cmp = direction;
+        if (cmp != direction) continue;
+
+        if (!sort_key_buffer_assign(&kept->key, key)) return false;
+        strncpy(kept->value, value, MAX_NUMBER_LENGTH - 1);
+        kept->value[MAX_NUMBER_LENGTH - 1] = '\0';
+        kept->index = position;
+        kept->set = true;
+    }
+
+    region->num_rows = 0;
+    region->bytes_size = 0;
+    queue_batch(&pipeline->free_batches, index);
+    return true;
+}
+
+// A batch to fill, the backpressure: with every batch queued the parser aggregates one itself
+static bool acquire_batch(pipeline_parser_t *parser, size_t *index) {
+    pipeline_t *pipeline = parser->pipeline;
+
+    while (!ring_buffer_pop(&pipeline->free_batches, index)) {
+        if (atomic_load_explicit(&pipeline->failed, memory_order_relaxed)) return false;
+
+        size_t full;
+        if (!ring_buffer_pop(&pipeline->full_batches, &full)) {
+            sched_yield();   // Every batch is being aggregated right now
+        } else if (!aggregate_batch(pipeline, parser->worker, full)) {
+            atomic_store(&pipeline->failed, true);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool append_row(pipeline_t *pipeline, pipeline_batch_t *batch, const char *data, const cell_view_t *row_cells) {
+    columnar_subregion_t *region = &batch->region;
+    size_t row = (size_t)region->num_rows;
+
+    for (int c = 0; c < pipeline->sub_width; c++) {
+        const char *value = data + row_cells[c].offset;
+        size_t length = (size_t)row_cells[c].length;
+
+        if (region->bytes_size + length + 1 > batch->bytes_capacity) {
+            size_t capacity = batch->bytes_capacity * 2;
+            while (capacity < region->bytes_size + length + 1) capacity *= 2;
+
+            char *bytes = realloc(region->bytes, capacity);
+            if (!bytes) {
+                fprintf(stderr, "Failed to grow pipeline batch\n");
+                return false;
+            }
+            region->bytes = bytes;
+            batch->bytes_capacity = capacity;
+        }
+
+        size_t index = (size_t)c * pipeline->batch_rows + row;
+        batch->classes[index] = (unsigned char)classify_number(value, length, &region->ints[index]);
+        region->offsets[index] = region->bytes_size;
+        memcpy(region->bytes + region->bytes_size, value, length);
+        region->bytes[region->bytes_size + length] = '\0';
+        region->bytes_size += length + 1;
+    }
+
+    region->num_rows++;
+    return true;
+}
+
+// Copy the in-range columns of a window into batches, queueing each one as it fills
+static bool parse_window(void *context, const char *data,
+    const cell_view_t *cells, int num_rows, int data_width) {
+
+    pipeline_parser_t *parser = context;
+    pipeline_t *pipeline = parser->pipeline;
+
+    for (int row = 0; row < num_rows; row++) {
+        if (!parser->holding) {
+            if (!acquire_batch(parser, &parser->batch)) return false;
+            pipeline->batches[parser->batch].first_row = parser->next_row;
+            parser->holding = true;
+        }
+
+        pipeline_batch_t *batch = &pipeline->batches[parser->batch];
+        const cell_view_t *row_cells = cells + (size_t)row * data_width + pipeline->bounds.starting_column;
+        if (!append_row(pipeline, batch, data, row_cells)) {
+            atomic_store(&pipeline->failed, true);
+            return false;
+        }
+
+        parser->next_row++;
+
+        if (batch->region.num_rows == pipeline->batch_rows) {
+            queue_batch(&pipeline->full_batches, parser->batch);
+            parser->holding = false;
+        }
+    }
+
+    return true;
+}
+
+typedef struct {
+    pipeline_t *pipeline;
+    pipeline_parser_t *parsers;
+} pipeline_job_t;
+
+// Aggregate queued batches until the parsers are done and the queue is empty
+static bool aggregate_batches(pipeline_t *pipeline, int worker) {
+    while (!atomic_load_explicit(&pipeline->failed, memory_order_relaxed)) {
+        size_t index;
+        if (ring_buffer_pop(&pipeline->full_batches, &index)) {
+            if (!aggregate_batch(pipeline, worker, index)) {
+                atomic_store(&pipeline->failed, true);
+                return false;
+            }
+            continue;
+        }
+
+        // A parser queues its last batch before it counts itself done, so one more look settles it
+        if (atomic_load(&pipeline->parsing) == 0) {
+            if (!ring_buffer_pop(&pipeline->full_batches, &index)) return true;
+            if (!aggregate_batch(pipeline, worker, index)) {
+                atomic_store(&pipeline->failed, true);
+                return false;
+            }
+        } else {
+            sched_yield();
+        }
+    }
+    return false;
+}
+
+/*
+    Pool task, the parsers come first so every worker's deque holds its parsers ahead of its
+    aggregators: an aggregator only waits on parsers that are running or queued elsewhere
+ */
+static bool run_stage(void *args, size_t begin, size_t end, int worker) {
+    pipeline_job_t *job = (pipeline_job_t *)args;
+    pipeline_t *pipeline = job->pipeline;
+
+    for (size_t task = begin; task < end; task++) {
+        if (task >= (size_t)pipeline->num_parsers) {
+            if (!aggregate_batches(pipeline, worker)) return false;
+            continue;
+        }
+
+        pipeline_parser_t *parser = &job->parsers[task];
+        parser->worker = worker;
+        row_stream_chunk(pipeline->stream, (int)task);
+
+        // The last rows of the chunk go out as a short batch
+        if (parser->holding) {
+            queue_batch(&pipeline->full_batches, parser->batch);
+            parser->holding = false;
+        }
+        atomic_fetch_sub(&pipeline->parsing, 1);
+    }
+    return true;
+}
+
+static void pipeline_cleanup(pipeline_t *pipeline, pipeline_parser_t *parsers, void **contexts) {
+    for (int i = 0; pipeline->batches && i < pipeline->num_batches; i++) {
+        free_columnar_subregion(&pipeline->batches[i].region);
+        free(pipeline->batches[i].classes);
+    }
+    for (int i = 0; pipeline->aggregates && i < pipeline->num_workers; i++) {
+        local_aggregate_t *aggregate = &pipeline->aggregates[i];
+
+        // Partitions the mode merge took are already NULL
+        for (int p = 0; aggregate->partitions && p < aggregate->num_partitions; p++) {
+            hashmap_destroy(aggregate->partitions[p]);
+        }
+        free(aggregate->partitions);
+        local_aggregate_free(aggregate);
+    }
+    for (int i = 0; pipeline->extremes && i < pipeline->num_workers; i++) {
+        sort_key_buffer_free(&pipeline->extremes[i].max.key);
+        sort_key_buffer_free(&pipeline->extremes[i].min.key);
+    }
+
+    ring_buffer_free(&pipeline->free_batches);
+    ring_buffer_free(&pipeline->full_batches);
+    free(pipeline->batches);
+    free(pipeline->aggregates);
+    free(pipeline->extremes);
+    free(parsers);
+    free(contexts);
+}
+
+// Whether a kept extreme lies further in direction than best, by key and then the lower index
+static bool beats_kept(const kept_extreme_t *candidate, const kept_extreme_t *best, int direction) {
+    if (!candidate->set) return false;
+    if (!best) return true;
+
+    int cmp = sort_key_compare(&candidate->key.key, &best->key.key);
+    return cmp ? cmp == direction : candidate->index < best->index;
+}
+
+// Fold the workers' results, the same answers one pass over the materialized subregion gives
+static void reduce_results(pipeline_t *pipeline, int operations, int precision, final_args_t *final_answers) {
+    const kept_extreme_t *max = NULL, *min = NULL;
+    sum_accumulator_t total_sum;
+    sum_accumulator_init(&total_sum);
+    bool mean_failed = false;
+
+    for (int i = 0; i < pipeline->num_workers; i++) {
+        if (beats_kept(&pipeline->extremes[i].max, max, 1)) max = &pipeline->extremes[i].max;
+        if (beats_kept(&pipeline->extremes[i].min, min, -1)) min = &pipeline->extremes[i].min;
+        if ((operations & OP_MEAN) && !sum_accumulator_merge(&total_sum, &pipeline->aggregates[i].sum)) mean_failed = true;
+    }
+
+    if ((operations & OP_MAX) && max) strcpy(final_answers->max_result, max->value);
+    if ((operations & OP_MIN) && min) strcpy(final_answers->min_result, min->value);
+
+    long long num_values = (long long)pipeline->sub_height * pipeline->sub_width;
+    if ((operations & OP_MEAN) &&
+        (mean_failed || !sum_accumulator_mean(&total_sum, num_values, precision, final_answers->mean_result, MAX_NUMBER_LENGTH))) {
+        fprintf(stderr, "Failed to combine the chunk sums\n");
+        strcpy(final_answers->mean_result, "NaN");
+    }
+    sum_accumulator_free(&total_sum);
+
+    if ((operations & OP_MODE) &&
+        !marshall_reduce_mode(pipeline->aggregates, pipeline->num_workers, final_answers->mode_result)) {
+        fprintf(stderr, "Failed to merge the chunk counts\n");
+        strcpy(final_answers->mode_result, "NaN");
+    }
+}
+
+int pipeline_operations(const table_layout_t *layout, header_integers bounds, int operations, int thread_count,
+    const query_options_t *options, final_args_t *results) {
+    if (operations & (OP_MEDIAN | OP_QUANTILES)) {
+        fprintf(stderr, "Error: Median and quantiles need the whole subregion and are not available when pipelining.\n");
+        return 1;
+    }
+
+    pipeline_t pipeline = { .bounds = bounds };
+    pipeline.sub_width = (bounds.ending_column - bounds.starting_column) + 1;
+    pipeline.sub_height = (bounds.ending_row - bounds.starting_row) + 1;
+    pipeline.folds = marshall_folds(operations);
+    pipeline.batch_rows = PIPELINE_BATCH_VALUES / pipeline.sub_width ? PIPELINE_BATCH_VALUES / pipeline.sub_width : 1;
+    if (pipeline.batch_rows > pipeline.sub_height) pipeline.batch_rows = pipeline.sub_height;
+
+    // One parser per layout chunk, then up to thread_count aggregators in what the pool has left
+    pipeline.num_parsers = layout->num_chunks;
+    int num_aggregators = thread_count < 1 ? 1 : thread_count;
+    if (num_aggregators > THREAD_POOL_MAX_WORKERS - pipeline.num_parsers) {
+        num_aggregators = THREAD_POOL_MAX_WORKERS - pipeline.num_parsers;
+    }
+    pipeline.num_workers = pipeline.num_parsers + num_aggregators;
+    pipeline.num_batches = PIPELINE_BATCHES_PER_WORKER * pipeline.num_workers;
+    atomic_init(&pipeline.parsing, pipeline.num_parsers);
+    atomic_init(&pipeline.failed, false);
+
+    pipeline_parser_t *parsers = calloc(pipeline.num_parsers, sizeof(pipeline_parser_t));
+    void **contexts = malloc(pipeline.num_parsers * sizeof(void *));
+    pipeline.batches = calloc(pipeline.num_batches, sizeof(pipeline_batch_t));
+    pipeline.aggregates = calloc(pipeline.num_workers, sizeof(local_aggregate_t));
+    pipeline.extremes = calloc(pipeline.num_workers, sizeof(pipeline_extremes_t));
+    bool ok = parsers && contexts && pipeline.batches && pipeline.aggregates && pipeline.extremes &&
+              ring_buffer_init(&pipeline.free_batches, pipeline.num_batches) &&
+              ring_buffer_init(&pipeline.full_batches, pipeline.num_batches);
+
+    for (int i = 0; ok && i < pipeline.num_batches; i++) {
+        ok = init_batch(&pipeline.batches[i], pipeline.batch_rows, pipeline.sub_width) &&
+             ring_buffer_push(&pipeline.free_batches, i);
+    }
+    for (int i = 0; ok && i < pipeline.num_workers; i++) {
+        local_aggregate_init(&pipeline.aggregates[i]);
+        sort_key_buffer_init(&pipeline.extremes[i].max.key);
+        sort_key_buffer_init(&pipeline.extremes[i].min.key);
+    }
+    for (int i = 0; ok && i < pipeline.num_parsers; i++) {
+        // The chunk's windows start at its first line within the bounds
+        int first_line = layout->chunks[i].first_line;
+        parsers[i].pipeline = &pipeline;
+        parsers[i].next_row = (first_line > bounds.starting_row ? first_line : bounds.starting_row) - bounds.starting_row;
+        contexts[i] = &parsers[i];
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate the pipeline\n");
+        pipeline_cleanup(&pipeline, parsers, contexts);
+        return 1;
+    }
+
+    printf("\n📊 Subregion Data (%d rows, %d columns)\n", pipeline.sub_height, pipeline.sub_width);
+    printf("   Pipelined from the file, not materialized.\n");
+
+    pipeline.stream = row_stream_create(layout, bounds.starting_row, bounds.ending_row, parse_window, contexts);
+    pipeline_job_t job = { &pipeline, parsers };
+    ok = pipeline.stream != NULL;
+
+    // Parsers and aggregators are all tasks of one job, so both run at once on the pool
+    if (ok) {
+        ok = thread_pool_for(pipeline.num_workers, 1, pipeline.num_workers, run_stage, &job);
+        ok = row_stream_finish(pipeline.stream) && ok;
+    }
+
+    // Anything a pool without room for aggregators left queued
+    ok = ok && aggregate_batches(&pipeline, 0);
+    if (!ok) {
+        pipeline_cleanup(&pipeline, parsers, contexts);
+        return 1;
+    }
+
+    final_args_t final_answers;
+    memset(&final_answers, 0, sizeof(final_answers));
+    reduce_results(&pipeline, operations, options->precision, &final_answers);
+
+    print_final_results(&final_answers, operations);
+    if (results) *results = final_answers;
+    pipeline_cleanup(&pipeline, parsers, contexts);
+
+    return 0;
+}
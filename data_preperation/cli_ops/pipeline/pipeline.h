@@ -0,0 +1,23 @@
+// pipeline.h
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "../tokenizer/tokenizer.h"
+#include "../marshaller/marshaller.h"
+
+/*
+    Compute max, min, mean and mode with parsing and aggregation running at once. Parser
+    workers tokenize the layout chunks into fixed-size batches of the subregion's rows and
+    queue them, aggregation workers take them off the queue and run the fused kernel, so
+    memory is a fixed set of batches rather than the subregion. A parser that finds every
+    batch queued aggregates one itself instead of waiting. Results match marshall_operations.
+    @param layout: scanned file, one parser per layout chunk
+    @param bounds: resolved, ordered and in range
+    @param thread_count: aggregation workers
+    @param results: out when not NULL, a copy of what was printed
+    @return 0 on success
+ */
+int pipeline_operations(const table_layout_t *layout, header_integers bounds, int operations, int thread_count,
+    const query_options_t *options, final_args_t *results);
+
+#endif // PIPELINE_H
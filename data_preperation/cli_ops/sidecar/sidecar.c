@@ -0,0 +1,594 @@
+#include "sidecar.h"
+#include "../../arithmetic_lib/fat_data/fat_data.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SIDECAR_MAGIC "FDC1"
+#define SIDECAR_VERSION 3
+#define HASH_SAMPLE_BYTES (1 << 16) // Hashed from the head, middle and tail of the CSV
+#define OFFSET_WRITE_BATCH 4096
+
+/*
+    On-disk layout: header, data_width column records, column and row header indexes, then column-major
+    offsets, native int64 values and number classes (padded to 8 bytes), then the values themselves
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint64_t source_hash;
+    int32_t data_width;
+    int32_t num_lines;
+    uint32_t column_headers;
+    uint32_t row_headers;
+    uint64_t column_index_slots;
+    uint64_t row_index_slots;
+    uint64_t bytes_size;
+} sidecar_header_t;
+
+// What the sidecar must agree with for the CSV to be considered unchanged
+typedef struct {
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t hash;
+} source_fingerprint_t;
+
+static char *sidecar_path(const char *file_name) {
+    size_t length = strlen(file_name);
+    char *path = malloc(length + sizeof(SIDECAR_EXTENSION));
+    if (!path) {
+        fprintf(stderr, "Failed to allocate memory for sidecar path\n");
+        return NULL;
+    }
+    memcpy(path, file_name, length);
+    memcpy(path + length, SIDECAR_EXTENSION, sizeof(SIDECAR_EXTENSION));
+    return path;
+}
+
+static void hash_bytes(uint64_t *hash, const char *bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        *hash ^= (unsigned char)bytes[i]; // FNV-1a
+        *hash *= 1099511628211ULL;
+    }
+}
+
+/*
+    Size, mtime and a hash of three fixed samples, so checking a large CSV costs a few reads
+    rather than a pass over the whole file
+ */
+static bool fingerprint_source(const char *file_name, source_fingerprint_t *fingerprint) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    fingerprint->size = (uint64_t)st.st_size;
+    fingerprint->mtime_sec = (int64_t)st.st_mtime;
+#ifdef __APPLE__
+    fingerprint->mtime_nsec = (int64_t)st.st_mtimespec.tv_nsec;
+#else
+    fingerprint->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+#endif
+
+    char *sample = malloc(HASH_SAMPLE_BYTES);
+    if (!sample) {
+        close(fd);
+        return false;
+    }
+
+    uint64_t size = fingerprint->size;
+    uint64_t starts[3] = { 0, size / 2, size > HASH_SAMPLE_BYTES ? size - HASH_SAMPLE_BYTES : 0 };
+    uint64_t hash = 1469598103934665603ULL;
+    hash_bytes(&hash, (const char *)&size, sizeof(size));
+
+    bool success = true;
+    for (int s = 0; s < 3 && success; s++) {
+        ssize_t got = pread(fd, sample, HASH_SAMPLE_BYTES, (off_t)starts[s]);
+        if (got < 0) success = false;
+        else hash_bytes(&hash, sample, (size_t)got);
+    }
+
+    free(sample);
+    close(fd);
+    fingerprint->hash = hash;
+    return success;
+}
+
+static bool fingerprints_match(const sidecar_header_t *header, const source_fingerprint_t *fingerprint) {
+    return header->source_size == fingerprint->size &&
+           header->source_mtime_sec == fingerprint->mtime_sec &&
+           header->source_mtime_nsec == fingerprint->mtime_nsec &&
+           header->source_hash == fingerprint->hash;
+}
+
+static size_t padded(size_t bytes) {
+    return (bytes + 7) & ~(size_t)7;
+}
+
+static size_t columns_bytes(int data_width) {
+    return padded((size_t)data_width * sizeof(sidecar_column_t));
+}
+
+// Where the sections go: the file being written, or a buffer already sized to hold them
+typedef struct {
+    FILE *file;
+    char *memory;
+    size_t position;
+} section_sink_t;
+
+static bool sink_write(section_sink_t *sink, const void *data, size_t size) {
+    if (sink->file) return fwrite(data, 1, size, sink->file) == size;
+
+    if (size) memcpy(sink->memory + sink->position, data, size);
+    sink->position += size;
+    return true;
+}
+
+void close_sidecar(sidecar_t *sidecar) {
+    if (!sidecar) return;
+    if (sidecar->in_memory) free(sidecar->map);
+    else if (sidecar->map && sidecar->map_size > 0) munmap(sidecar->map, sidecar->map_size);
+    memset(sidecar, 0, sizeof(*sidecar));
+}
+
+// Point the sections at the image in sidecar->map, whose sizes have been checked
+static void bind_sections(sidecar_t *sidecar) {
+    const sidecar_header_t *header = (const sidecar_header_t *)sidecar->map;
+    size_t num_values = (size_t)header->data_width * (size_t)header->num_lines;
+    size_t columns_end = sizeof(sidecar_header_t) + columns_bytes(header->data_width);
+    size_t indexes_end = columns_end + (header->column_index_slots + header->row_index_slots) * sizeof(header_slot_t);
+    size_t offsets_end = indexes_end + num_values * sizeof(uint64_t);
+    size_t ints_end = offsets_end + num_values * sizeof(int64_t);
+
+    sidecar->data_width = header->data_width;
+    sidecar->num_lines = header->num_lines;
+    sidecar->column_headers = header->column_headers != 0;
+    sidecar->row_headers = header->row_headers != 0;
+    sidecar->columns = (const sidecar_column_t *)(sidecar->map + sizeof(sidecar_header_t));
+    sidecar->column_index = (const header_slot_t *)(sidecar->map + columns_end);
+    sidecar->column_index_slots = header->column_index_slots;
+    sidecar->row_index = sidecar->column_index + header->column_index_slots;
+    sidecar->row_index_slots = header->row_index_slots;
+    sidecar->offsets = (const uint64_t *)(sidecar->map + indexes_end);
+    sidecar->ints = (const int64_t *)(sidecar->map + offsets_end);
+    sidecar->classes = (const unsigned char *)(sidecar->map + ints_end);
+    sidecar->bytes = sidecar->map + ints_end + padded(num_values);
+    sidecar->bytes_size = header->bytes_size;
+}
+
+// Map and validate the sidecar, stale reports whether one existed but no longer matches the CSV
+static bool map_sidecar(const char *file_name, sidecar_t *sidecar, bool *stale) {
+    memset(sidecar, 0, sizeof(*sidecar));
+    *stale = false;
+
+    char *path = sidecar_path(file_name);
+    if (!path) return false;
+
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(sidecar_header_t)) {
+        close(fd);
+        *stale = true;
+        return false;
+    }
+
+    sidecar->map_size = (size_t)st.st_size;
+    sidecar->map = mmap(NULL, sidecar->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (sidecar->map == MAP_FAILED) {
+        memset(sidecar, 0, sizeof(*sidecar));
+        return false;
+    }
+
+    const sidecar_header_t *header = (const sidecar_header_t *)sidecar->map;
+    source_fingerprint_t fingerprint;
+
+    bool valid = memcmp(header->magic, SIDECAR_MAGIC, 4) == 0 &&
+                 header->version == SIDECAR_VERSION &&
+                 header->data_width > 0 && header->num_lines > 0 &&
+                 fingerprint_source(file_name, &fingerprint) &&
+                 fingerprints_match(header, &fingerprint);
+
+    // Every section must fit the mapping exactly
+    size_t num_values = (size_t)header->data_width * (size_t)header->num_lines;
+    size_t columns_end = sizeof(sidecar_header_t) + columns_bytes(header->data_width);
+    size_t indexes_end = columns_end + (header->column_index_slots + header->row_index_slots) * sizeof(header_slot_t);
+    size_t offsets_end = indexes_end + num_values * sizeof(uint64_t);
+    size_t ints_end = offsets_end + num_values * sizeof(int64_t);
+    size_t values_start = ints_end + padded(num_values);
+
+    valid = valid && num_values / (size_t)header->data_width == (size_t)header->num_lines &&
+            header->column_index_slots == header_index_slots(header->data_width) &&
+            header->row_index_slots == header_index_slots(header->num_lines) &&
+            values_start <= sidecar->map_size &&
+            header->bytes_size == sidecar->map_size - values_start &&
+            header->bytes_size > 0 && sidecar->map[sidecar->map_size - 1] == '\0';
+
+    if (!valid) {
+        close_sidecar(sidecar);
+        *stale = true;
+        return false;
+    }
+
+    bind_sections(sidecar);
+    return true;
+}
+
+bool open_sidecar(const char *file_name, sidecar_t *sidecar) {
+    bool stale;
+    if (map_sidecar(file_name, sidecar, &stale)) return true;
+
+    if (stale) fprintf(stderr, "Note: %s%s is out of date, parsing the CSV instead.\n", file_name, SIDECAR_EXTENSION);
+    return false;
+}
+
+bool sidecar_current(const char *file_name) {
+    sidecar_t sidecar;
+    bool stale;
+    if (!map_sidecar(file_name, &sidecar, &stale)) return false;
+
+    close_sidecar(&sidecar);
+    return true;
+}
+
+// Type and widest value of one column across every band
+static sidecar_column_t describe_column(const columnar_builder_t *bands, int num_bands, int column, bool column_headers) {
+    sidecar_column_t info = { COLUMN_NUMERIC, 0 };
+    int line = 0;
+
+    for (int b = 0; b < num_bands; b++) {
+        const column_builder_t *col = &bands[b].columns[column];
+
+        for (int v = 0; v < col->num_values; v++, line++) {
+            const char *value = col->bytes + col->offsets[v];
+            size_t length = strlen(value);
+
+            if (length > info.max_length) info.max_length = length > UINT32_MAX ? UINT32_MAX : (uint32_t)length;
+            if ((line > 0 || !column_headers) && info.type == COLUMN_NUMERIC && !is_valid_double_n(value, length)) {
+                info.type = COLUMN_TEXT;
+            }
+        }
+    }
+
+    return info;
+}
+
+static const char *read_listed_name(const void *ctx, int position) {
+    return ((const char *const *)ctx)[position];
+}
+
+/*
+    Index the names of the first line, or of the first column when by_line, straight from the bands
+    @param num_positions: data_width for the first line, num_lines for the first column
+ */
+static bool write_header_index(section_sink_t *sink, const columnar_builder_t *bands, int num_bands,
+    int num_positions, bool by_line, sidecar_header_t *header) {
+
+    const char **names = malloc((size_t)num_positions * sizeof(char *));
+    size_t num_slots = header_index_slots(num_positions);
+    header_slot_t *slots = malloc(num_slots * sizeof(header_slot_t));
+    if (!names || !slots) {
+        fprintf(stderr, "Failed to allocate memory for header index\n");
+        free(names);
+        free(slots);
+        return false;
+    }
+
+    int listed = 0;
+    for (int b = 0; b < num_bands && listed < num_positions; b++) {
+        if (by_line) {
+            const column_builder_t *col = &bands[b].columns[0];
+            for (int v = 0; v < col->num_values && listed < num_positions; v++) names[listed++] = col->bytes + col->offsets[v];
+            continue;
+        }
+
+        // The first line is the first value of the first band holding any
+        if (bands[b].columns[0].num_values == 0) continue;
+        for (int c = 0; c < num_positions; c++) names[listed++] = bands[b].columns[c].bytes + bands[b].columns[c].offsets[0];
+    }
+    while (listed < num_positions) names[listed++] = NULL;
+
+    header_index_build(slots, num_slots, num_positions, read_listed_name, names);
+    bool success = sink_write(sink, slots, num_slots * sizeof(header_slot_t));
+
+    if (by_line) header->row_index_slots = num_slots;
+    else header->column_index_slots = num_slots;
+
+    free(names);
+    free(slots);
+    return success;
+}
+
+static bool write_sections(section_sink_t *sink, const columnar_builder_t *bands, int num_bands,
+    int num_lines, int data_width, bool column_headers, sidecar_header_t *header) {
+
+    // Column records, padded so the offsets stay 8 byte aligned
+    char *columns = calloc(1, columns_bytes(data_width));
+    if (!columns) return false;
+
+    for (int c = 0; c < data_width; c++) {
+        sidecar_column_t info = describe_column(bands, num_bands, c, column_headers);
+        memcpy(columns + c * sizeof(sidecar_column_t), &info, sizeof(info));
+    }
+
+    bool success = sink_write(sink, columns, columns_bytes(data_width));
+    free(columns);
+
+    success = success && write_header_index(sink, bands, num_bands, data_width, false, header) &&
+              write_header_index(sink, bands, num_bands, num_lines, true, header);
+
+    // Offsets in the order the values are laid out below: column by column, band by band
+    uint64_t *batch = malloc(OFFSET_WRITE_BATCH * sizeof(uint64_t));
+    if (!batch) return false;
+
+    uint64_t position = 0;
+    for (int c = 0; c < data_width && success; c++) {
+        int values = 0, batched = 0;
+
+        for (int b = 0; b < num_bands && success; b++) {
+            const column_builder_t *col = &bands[b].columns[c];
+
+            for (int v = 0; v < col->num_values && success; v++) {
+                batch[batched++] = position + col->offsets[v];
+                if (batched == OFFSET_WRITE_BATCH) {
+                    success = sink_write(sink, batch, batched * sizeof(uint64_t));
+                    batched = 0;
+                }
+            }
+            values += col->num_values;
+            position += col->size;
+        }
+
+        if (success && batched) success = sink_write(sink, batch, batched * sizeof(uint64_t));
+        if (success && values != num_lines) {
+            fprintf(stderr, "Column %d holds %d values, expected %d\n", c, values, num_lines);
+            success = false;
+        }
+    }
+    free(batch);
+
+    // Classified while tokenizing, stored so queries never reparse
+    for (int c = 0; c < data_width && success; c++) {
+        for (int b = 0; b < num_bands && success; b++) {
+            const column_builder_t *col = &bands[b].columns[c];
+            success = sink_write(sink, col->ints, col->num_values * sizeof(int64_t));
+        }
+    }
+    for (int c = 0; c < data_width && success; c++) {
+        for (int b = 0; b < num_bands && success; b++) {
+            const column_builder_t *col = &bands[b].columns[c];
+            success = sink_write(sink, col->classes, col->num_values);
+        }
+    }
+    size_t num_values = (size_t)data_width * num_lines;
+    static const char padding[8] = {0};
+    if (success && padded(num_values) > num_values) {
+        success = sink_write(sink, padding, padded(num_values) - num_values);
+    }
+
+    for (int c = 0; c < data_width && success; c++) {
+        for (int b = 0; b < num_bands && success; b++) {
+            const column_builder_t *col = &bands[b].columns[c];
+            success = sink_write(sink, col->bytes, col->size);
+        }
+    }
+
+    header->bytes_size = position;
+    return success;
+}
+
+bool write_sidecar(const char *file_name, const columnar_builder_t *bands, int num_bands,
+    int num_lines, int data_width, bool column_headers, bool row_headers) {
+
+    source_fingerprint_t fingerprint;
+    if (!fingerprint_source(file_name, &fingerprint)) {
+        fprintf(stderr, "Error: Could not read %s to fingerprint it.\n", file_name);
+        return false;
+    }
+
+    char *path = sidecar_path(file_name);
+    if (!path) return false;
+
+    char *temp_path = malloc(strlen(path) + 32);
+    if (!temp_path) {
+        fprintf(stderr, "Failed to allocate memory for sidecar path\n");
+        free(path);
+        return false;
+    }
+    sprintf(temp_path, "%s.tmp%ld", path, (long)getpid());
+
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not create sidecar %s\n", temp_path);
+        free(temp_path);
+        free(path);
+        return false;
+    }
+
+    sidecar_header_t header = {
+        .magic = { 'F', 'D', 'C', '1' },
+        .version = SIDECAR_VERSION,
+        .source_size = fingerprint.size,
+        .source_mtime_sec = fingerprint.mtime_sec,
+        .source_mtime_nsec = fingerprint.mtime_nsec,
+        .source_hash = fingerprint.hash,
+        .data_width = data_width,
+        .num_lines = num_lines,
+        .column_headers = column_headers,
+        .row_headers = row_headers
+    };
+
+    // The header is rewritten once the value bytes are counted
+    section_sink_t sink = { .file = file };
+    bool success = sink_write(&sink, &header, sizeof(header)) &&
+                   write_sections(&sink, bands, num_bands, num_lines, data_width, column_headers, &header) &&
+                   fseek(file, 0, SEEK_SET) == 0 &&
+                   fwrite(&header, sizeof(header), 1, file) == 1;
+    success = (fclose(file) == 0) && success;
+
+    if (success && rename(temp_path, path) != 0) success = false;
+    if (!success) {
+        fprintf(stderr, "Error: Failed to write sidecar %s\n", path);
+        unlink(temp_path);
+    }
+
+    free(temp_path);
+    free(path);
+    return success;
+}
+
+bool sidecar_from_bands(const columnar_builder_t *bands, int num_bands,
+    int num_lines, int data_width, bool column_headers, bool row_headers, sidecar_t *sidecar) {
+
+    memset(sidecar, 0, sizeof(*sidecar));
+
+    // Same image as the file, so the sections are sized up front and written straight into it
+    size_t num_values = (size_t)data_width * num_lines;
+    size_t bytes_size = 0;
+    for (int b = 0; b < num_bands; b++) {
+        for (int c = 0; c < data_width; c++) bytes_size += bands[b].columns[c].size;
+    }
+
+    size_t image_size = sizeof(sidecar_header_t) + columns_bytes(data_width) +
+                        (header_index_slots(data_width) + header_index_slots(num_lines)) * sizeof(header_slot_t) +
+                        num_values * (sizeof(uint64_t) + sizeof(int64_t)) + padded(num_values) + bytes_size;
+
+    char *image = malloc(image_size);
+    if (!image) {
+        fprintf(stderr, "Failed to allocate memory for the in-memory table\n");
+        return false;
+    }
+
+    sidecar_header_t header = {
+        .magic = { 'F', 'D', 'C', '1' },
+        .version = SIDECAR_VERSION,
+        .data_width = data_width,
+        .num_lines = num_lines,
+        .column_headers = column_headers,
+        .row_headers = row_headers
+    };
+
+    section_sink_t sink = { .memory = image, .position = sizeof(header) };
+    if (!write_sections(&sink, bands, num_bands, num_lines, data_width, column_headers, &header)) {
+        free(image);
+        return false;
+    }
+    memcpy(image, &header, sizeof(header));
+
+    sidecar->map = image;
+    sidecar->map_size = image_size;
+    sidecar->in_memory = true;
+    bind_sections(sidecar);
+    return true;
+}
+
+// Value of a line in a column, NULL when a corrupt offset points outside the values
+static const char *sidecar_value(const sidecar_t *sidecar, int column, int line) {
+    uint64_t offset = sidecar->offsets[(size_t)column * sidecar->num_lines + line];
+    return offset < sidecar->bytes_size ? sidecar->bytes + offset : NULL;
+}
+
+static const char *read_first_line_name(const void *ctx, int column) {
+    return sidecar_value(ctx, column, 0);
+}
+
+static const char *read_first_column_name(const void *ctx, int line) {
+    return sidecar_value(ctx, 0, line);
+}
+
+/*
+    Resolve one requested name through an index, a repeated name is rejected without scanning
+    @param base: added to the matched position, rows are indexed from line + 1 like the tokenizer
+ */
+static bool lookup_header(const sidecar_t *sidecar, bool by_line, const char *requested, int *index, int base) {
+    if (!requested) return true;
+
+    bool repeated;
+    int position = by_line ?
+        header_index_find(sidecar->row_index, sidecar->row_index_slots, sidecar->num_lines, requested,
+                          read_first_column_name, sidecar, &repeated) :
+        header_index_find(sidecar->column_index, sidecar->column_index_slots, sidecar->data_width, requested,
+                          read_first_line_name, sidecar, &repeated);
+
+    if (repeated) {
+        fprintf(stderr, "Error: Repeat header \"%s\"\n", requested);
+        fprintf(stderr, "File format error detected.\n");
+        return false;
+    }
+
+    if (position != -1) *index = position + base;
+    return true;
+}
+
+bool sidecar_match_headers(const sidecar_t *sidecar, header_strings requested_headers, header_integers *header_indeces) {
+    return lookup_header(sidecar, false, requested_headers.starting_column, &header_indeces->starting_column, 0) &&
+           lookup_header(sidecar, false, requested_headers.ending_column, &header_indeces->ending_column, 0) &&
+           lookup_header(sidecar, true, requested_headers.starting_row, &header_indeces->starting_row, 1) &&
+           lookup_header(sidecar, true, requested_headers.ending_row, &header_indeces->ending_row, 1);
+}
+
+bool sidecar_subregion(const sidecar_t *sidecar, header_integers bounds, columnar_subregion_t *region) {
+    memset(region, 0, sizeof(*region));
+
+    int sub_height = (bounds.ending_row - bounds.starting_row) + 1;
+    int sub_width = (bounds.ending_column - bounds.starting_column) + 1;
+    size_t num_values = (size_t)sub_height * sub_width;
+
+    region->offsets = malloc(num_values * sizeof(size_t));
+    region->ints = malloc(num_values * sizeof(int64_t));
+    unsigned char *classes = malloc(num_values);
+    if (!region->offsets || !region->ints || !classes) {
+        fprintf(stderr, "Failed to allocate columnar subregion\n");
+        free(classes);
+        free_columnar_subregion(region);
+        return false;
+    }
+
+    // Each requested column is one contiguous run of the stored offsets, values and classes
+    for (int c = 0; c < sub_width; c++) {
+        size_t stored = (size_t)(bounds.starting_column + c) * sidecar->num_lines + bounds.starting_row;
+        const uint64_t *column = sidecar->offsets + stored;
+        size_t *dest = region->offsets + (size_t)c * sub_height;
+
+        for (int r = 0; r < sub_height; r++) {
+            if (column[r] >= sidecar->bytes_size) {
+                fprintf(stderr, "Error: Sidecar offset out of range, rebuild it with --cache.\n");
+                free(classes);
+                free_columnar_subregion(region);
+                return false;
+            }
+            dest[r] = (size_t)column[r];
+        }
+
+        memcpy(region->ints + (size_t)c * sub_height, sidecar->ints + stored, sub_height * sizeof(int64_t));
+        memcpy(classes + (size_t)c * sub_height, sidecar->classes + stored, sub_height);
+    }
+
+    region->bytes = (char *)sidecar->bytes;
+    region->bytes_size = sidecar->bytes_size;
+    region->num_rows = sub_height;
+    region->num_columns = sub_width;
+    region->borrowed_bytes = true;
+
+    bool tagged = columnar_tag_blocks(region, classes);
+    free(classes);
+    if (!tagged) free_columnar_subregion(region);
+
+    return tagged;
+}
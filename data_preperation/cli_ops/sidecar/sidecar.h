@@ -0,0 +1,89 @@
+#ifndef SIDECAR_H
+#define SIDECAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../tokenizer/tokenizer.h"
+#include "../header_index/header_index.h"
+#include "../../arithmetic_lib/columnar/columnar.h"
+
+#define SIDECAR_EXTENSION ".fdc"
+
+typedef enum {
+    COLUMN_NUMERIC, // Every value below the header row is a valid double
+    COLUMN_TEXT
+} column_type_t;
+
+typedef struct {
+    uint32_t type;        // column_type_t
+    uint32_t max_length;  // Longest value in the column, header included
+} sidecar_column_t;
+
+/*
+    Read-only mapping of a CSV's binary columnar sidecar. The whole table is stored
+    column-major like a columnar_subregion_t, header line and header column included,
+    along with the header layout detected when it was written.
+ */
+typedef struct {
+    char *map;
+    size_t map_size;
+    bool in_memory;                  // map is a heap copy built by sidecar_from_bands rather than a mapping
+    int data_width;
+    int num_lines;
+    bool column_headers;
+    bool row_headers;
+    const sidecar_column_t *columns; // data_width entries
+    const header_slot_t *column_index; // Names in the first line by column
+    size_t column_index_slots;
+    const header_slot_t *row_index;    // Names in the first column by line
+    size_t row_index_slots;
+    const uint64_t *offsets;         // data_width * num_lines, column-major, into bytes
+    const int64_t *ints;             // Native value of each NUMBER_INT64 value, same indexing
+    const unsigned char *classes;    // number_class_t of each value, same indexing
+    const char *bytes;               // NUL-terminated values
+    size_t bytes_size;
+} sidecar_t;
+
+/*
+    Map the sidecar next to file_name when it still matches the CSV's size, mtime and content hash
+    @return false when there is no usable sidecar, the CSV must then be parsed
+ */
+bool open_sidecar(const char *file_name, sidecar_t *sidecar);
+
+void close_sidecar(sidecar_t *sidecar);
+
+// True when the sidecar next to file_name exists and is current
+bool sidecar_current(const char *file_name);
+
+/*
+    Write the sidecar for file_name from the tokenized table, written to a temporary file and renamed into place
+    @param bands: column builders holding every line of the table, in row order
+    @return false on I/O or allocation failure
+ */
+bool write_sidecar(const char *file_name, const columnar_builder_t *bands, int num_bands,
+    int num_lines, int data_width, bool column_headers, bool row_headers);
+
+/*
+    The same image write_sidecar would store, built on the heap instead of a file, so a table
+    parsed once can be queried like a mapped sidecar. Released with close_sidecar.
+    @param bands: column builders holding every line of the table, in row order
+    @return false on allocation failure or when the bands don't add up to num_lines
+ */
+bool sidecar_from_bands(const columnar_builder_t *bands, int num_bands,
+    int num_lines, int data_width, bool column_headers, bool row_headers, sidecar_t *sidecar);
+
+/*
+    Look requested header names up in the stored first line and first column indexes,
+    with the same indeces and repeat header rules as the tokenizer
+ */
+bool sidecar_match_headers(const sidecar_t *sidecar, header_strings requested_headers, header_integers *header_indeces);
+
+/*
+    Subregion within resolved bounds, the values stay in the mapping and only the offsets,
+    native values and classes are copied
+    @return false on allocation failure, the sidecar must outlive the subregion
+ */
+bool sidecar_subregion(const sidecar_t *sidecar, header_integers bounds, columnar_subregion_t *region);
+
+#endif // SIDECAR_H
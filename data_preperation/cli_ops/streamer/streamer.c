@@ -0,0 +1,270 @@
+// streamer.c
+#include "streamer.h"
+#include "../marshaller/marshaller.h"
+#include "../../arithmetic_lib/fat_data/fat_data.h"
+#include "../../arithmetic_lib/statistical_ops/statistical_ops.h"
+#include "../../arithmetic_lib/frequency_summary/frequency_summary.h"
+#include "../../arithmetic_lib/sorting/sort_key/sort_key.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Counters per mode summary, values more frequent than 1 / (counters + 1) of the cells are exact
+#ifndef STREAM_MODE_COUNTERS
+#define STREAM_MODE_COUNTERS 1024
+#endif
+
+typedef struct {
+    header_integers bounds;
+    int operations;
+
+    // Result caching
+    char local_max[MAX_NUMBER_LENGTH];
+    char local_min[MAX_NUMBER_LENGTH];
+    sort_key_buffer_t max_key;           // Keys of the running max and min, so each cell is normalized once
+    sort_key_buffer_t min_key;
+    sort_key_buffer_t cell_key;
+    sum_accumulator_t local_sum;         // for mean
+    long long count;
+
+    frequency_summary_t *summary;        // Heavy hitters for mode
+    frequency_summary_t *candidates;     // Exact recount when the summary was pruned
+
+    int long_cell_length;                // Set when a cell can't fit the arithmetic buffers
+} stream_args_t;
+
+// Fold one window of rows into the thread's accumulators
+static bool accumulate_window(void *context, const char *data,
+    const cell_view_t *cells, int num_rows, int data_width) {
+
+    stream_args_t *args = context;
+
+    for (int row = 0; row < num_rows; row++) {
+        const cell_view_t *row_cells = cells + (size_t)row * data_width;
+
+        for (int col = args->bounds.starting_column; col <= args->bounds.ending_column; col++) {
+            const char *token = data + row_cells[col].offset;
+            int length = row_cells[col].length;
+
+            if (length >= MAX_NUMBER_LENGTH) {
+                args->long_cell_length = length;
+                return false;
+            }
+
+            if ((args->operations & (OP_MAX | OP_MIN)) && !sort_key_buffer_set(&args->cell_key, token, length)) return false;
+            if ((args->operations & OP_MAX) &&
+                (args->count == 0 || sort_key_compare(&args->cell_key.key, &args->max_key.key) > 0)) {
+                if (!sort_key_buffer_copy(&args->max_key, &args->cell_key)) return false;
+                memcpy(args->local_max, token, length);
+                args->local_max[length] = '\0';
+            }
+            if ((args->operations & OP_MIN) &&
+                (args->count == 0 || sort_key_compare(&args->cell_key.key, &args->min_key.key) < 0)) {
+                if (!sort_key_buffer_copy(&args->min_key, &args->cell_key)) return false;
+                memcpy(args->local_min, token, length);
+                args->local_min[length] = '\0';
+            }
+            if ((args->operations & OP_MEAN) && !sum_accumulator_add_text(&args->local_sum, token, length)) return false;
+            if ((args->operations & OP_MODE) && !frequency_summary_add(args->summary, token, length)) return false;
+
+            args->count++;
+        }
+    }
+
+    return true;
+}
+
+// Second pass for mode, only the surviving candidates are counted
+static bool count_candidates(void *context, const char *data,
+    const cell_view_t *cells, int num_rows, int data_width) {
+
+    stream_args_t *args = context;
+
+    for (int row = 0; row < num_rows; row++) {
+        const cell_view_t *row_cells = cells + (size_t)row * data_width;
+        for (int col = args->bounds.starting_column; col <= args->bounds.ending_column; col++) {
+            frequency_summary_count(args->candidates, data + row_cells[col].offset, row_cells[col].length);
+        }
+    }
+
+    return true;
+}
+
+static void stream_args_cleanup(stream_args_t *stream_args, void **contexts, int num_chunks) {
+    for (int i = 0; i < num_chunks; i++) {
+        frequency_summary_destroy(stream_args[i].summary);
+        frequency_summary_destroy(stream_args[i].candidates);
+        sum_accumulator_free(&stream_args[i].local_sum);
+        sort_key_buffer_free(&stream_args[i].max_key);
+        sort_key_buffer_free(&stream_args[i].min_key);
+        sort_key_buffer_free(&stream_args[i].cell_key);
+    }
+    free(stream_args);
+    free(contexts);
+}
+
+/*
+    Merge the per-thread summaries and settle the mode. Exact whenever no summary had to
+    drop a counter, otherwise the candidates are recounted in a second pass.
+ */
+static bool resolve_mode(const table_layout_t *layout, stream_args_t *stream_args, void **contexts,
+    long long total_count, char *mode_result) {
+
+    int num_chunks = layout->num_chunks;
+    bool success = false;
+
+    frequency_summary_t *merged = frequency_summary_create(STREAM_MODE_COUNTERS);
+    frequency_summary_t *recount = NULL;
+    if (!merged) return false;
+
+    for (int i = 0; i < num_chunks; i++) {
+        if (!frequency_summary_merge(merged, stream_args[i].summary)) goto cleanup;
+    }
+
+    const frequency_summary_t *counts = merged;
+
+    if (frequency_summary_pruned(merged)) {
+        for (int i = 0; i < num_chunks; i++) {
+            stream_args[i].candidates = frequency_summary_candidates(merged);
+            if (!stream_args[i].candidates) goto cleanup;
+        }
+
+        if (!stream_table_rows(layout, stream_args[0].bounds.starting_row, stream_args[0].bounds.ending_row,
+                               count_candidates, contexts)) goto cleanup;
+
+        recount = frequency_summary_candidates(merged);
+        if (!recount) goto cleanup;
+        for (int i = 0; i < num_chunks; i++) {
+            if (!frequency_summary_merge(recount, stream_args[i].candidates)) goto cleanup;
+        }
+        counts = recount;
+    }
+
+    long long mode_count = 0;
+    const char *mode_key = frequency_summary_mode(counts, &mode_count);
+
+    // A value seen at most n / (counters + 1) times may have been dropped by every summary,
+    // so a recount that confirms nothing above that says neither "N/A" nor which value wins
+    long long missable = total_count / (STREAM_MODE_COUNTERS + 1);
+    if (counts == recount && mode_count <= missable) {
+        strncpy(mode_result, MODE_UNDETERMINED, MAX_NUMBER_LENGTH - 1);
+        fprintf(stderr, "Warning: streamed mode is undetermined, values seen %lld times or fewer can be missed"
+                " and the best recounted candidate was seen %lld times.\n", missable, mode_count);
+    // No mode or only one occurrence
+    } else if (!mode_key || mode_count <= 1) {
+        strncpy(mode_result, "N/A", MAX_NUMBER_LENGTH - 1);
+    } else {
+        strncpy(mode_result, mode_key, MAX_NUMBER_LENGTH - 1);
+    }
+    mode_result[MAX_NUMBER_LENGTH - 1] = '\0';
+
+    success = true;
+
+cleanup:
+    frequency_summary_destroy(merged);
+    frequency_summary_destroy(recount);
+    return success;
+}
+
+int stream_operations(const table_layout_t *layout, header_integers bounds, int operations,
+    const query_options_t *options, final_args_t *results) {
+    if (operations & (OP_MEDIAN | OP_QUANTILES)) {
+        fprintf(stderr, "Error: Median and quantiles need the whole subregion and are not available when streaming.\n");
+        return 1;
+    }
+
+    int num_chunks = layout->num_chunks;
+    int sub_width = (bounds.ending_column - bounds.starting_column) + 1;
+    int sub_height = (bounds.ending_row - bounds.starting_row) + 1;
+
+    stream_args_t *stream_args = calloc(num_chunks, sizeof(stream_args_t));
+    void **contexts = calloc(num_chunks, sizeof(void *));      // Zeroed, so no chunk is visited with an unset context
+    if (!stream_args || !contexts) {
+        perror("Memory allocation failed");
+        free(stream_args);
+        free(contexts);
+        return 1;
+    }
+
+    for (int i = 0; i < num_chunks; i++) {
+        stream_args[i].bounds = bounds;
+        stream_args[i].operations = operations;
+        sum_accumulator_init(&stream_args[i].local_sum);
+        sort_key_buffer_init(&stream_args[i].max_key);
+        sort_key_buffer_init(&stream_args[i].min_key);
+        sort_key_buffer_init(&stream_args[i].cell_key);
+        contexts[i] = &stream_args[i];
+
+        if (operations & OP_MODE) {
+            stream_args[i].summary = frequency_summary_create(STREAM_MODE_COUNTERS);
+            if (!stream_args[i].summary) {
+                stream_args_cleanup(stream_args, contexts, num_chunks);
+                return 1;
+            }
+        }
+    }
+
+    printf("\n📊 Subregion Data (%d rows, %d columns)\n", sub_height, sub_width);
+    printf("   Streamed from the file, not materialized.\n");
+
+    if (!stream_table_rows(layout, bounds.starting_row, bounds.ending_row, accumulate_window, contexts)) {
+        for (int i = 0; i < num_chunks; i++) {
+            if (stream_args[i].long_cell_length) {
+                fprintf(stderr, "Error: Value of length %d exceeds the maximum number length (%d).\n",
+                        stream_args[i].long_cell_length, MAX_NUMBER_LENGTH - 1);
+                break;
+            }
+        }
+        stream_args_cleanup(stream_args, contexts, num_chunks);
+        return 1;
+    }
+
+    // Combine chunk results in file order
+    final_args_t final_answers;
+    memset(&final_answers, 0, sizeof(final_answers));
+    sum_accumulator_t mean_sum;
+    sum_accumulator_init(&mean_sum);
+    bool mean_valid = true;
+    long long total_count = 0;
+    bool first = true;
+
+    for (int i = 0; i < num_chunks; i++) {
+        if (stream_args[i].count == 0) continue;
+
+        if ((operations & OP_MAX) &&
+            (first || compare_big_numbers(stream_args[i].local_max, final_answers.max_result) == 1)) {
+            strncpy(final_answers.max_result, stream_args[i].local_max, MAX_NUMBER_LENGTH - 1);
+        }
+        if ((operations & OP_MIN) &&
+            (first || compare_big_numbers(stream_args[i].local_min, final_answers.min_result) == -1)) {
+            strncpy(final_answers.min_result, stream_args[i].local_min, MAX_NUMBER_LENGTH - 1);
+        }
+        if (operations & OP_MEAN) {
+            mean_valid = mean_valid && sum_accumulator_merge(&mean_sum, &stream_args[i].local_sum);
+        }
+
+        total_count += stream_args[i].count;
+        first = false;
+    }
+
+    if (operations & OP_MEAN) {
+        // Decimal text only once the chunk sums are combined
+        if (!mean_valid || !sum_accumulator_mean(&mean_sum, total_count, options->precision,
+                                                 final_answers.mean_result, MAX_NUMBER_LENGTH)) {
+            strcpy(final_answers.mean_result, "NaN");
+        }
+    }
+    sum_accumulator_free(&mean_sum);
+
+    if ((operations & OP_MODE) && !resolve_mode(layout, stream_args, contexts, total_count, final_answers.mode_result)) {
+        fprintf(stderr, "Error: Failed to resolve the streamed mode.\n");
+        stream_args_cleanup(stream_args, contexts, num_chunks);
+        return 1;
+    }
+
+    print_final_results(&final_answers, operations);
+    if (results) *results = final_answers;
+    stream_args_cleanup(stream_args, contexts, num_chunks);
+
+    return 0;
+}
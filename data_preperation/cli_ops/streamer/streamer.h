@@ -0,0 +1,22 @@
+// streamer.h
+#ifndef STREAMER_H
+#define STREAMER_H
+
+#include "../tokenizer/tokenizer.h"
+#include "../marshaller/marshaller.h"
+
+// Mode result when the summary dropped values and the recount could not confirm a winner
+#define MODE_UNDETERMINED "undetermined (approximate summary overflowed)"
+
+/*
+    Compute max, min, mean and mode over the resolved bounds while the file is read,
+    peak memory is a tokenizing window and a set of accumulators per thread.
+    @param layout: scanned file, one accumulator per layout chunk
+    @param bounds: resolved, ordered and in range
+    @param results: out when not NULL, a copy of what was printed
+    @return 0 on success
+ */
+int stream_operations(const table_layout_t *layout, header_integers bounds, int operations,
+    const query_options_t *options, final_args_t *results);
+
+#endif // STREAMER_H
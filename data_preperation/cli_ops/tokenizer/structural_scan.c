@@ -0,0 +1,131 @@
+// structural_scan.c
+#include "structural_scan.h"
+#include <stdbool.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_HAS_X86 1
+#endif
+
+typedef void (*scan_fn)(const char *data, size_t num_blocks, uint64_t *delimiters, uint64_t *newlines);
+
+static void scan_scalar(const char *data, size_t num_blocks, uint64_t *delimiters, uint64_t *newlines) {
+    for (size_t b = 0; b < num_blocks; b++) {
+        const char *block = data + b * SCAN_BLOCK_SIZE;
+        uint64_t delimiter_mask = 0, newline_mask = 0;
+
+        for (int i = 0; i < SCAN_BLOCK_SIZE; i++) {
+            char ch = block[i];
+            delimiter_mask |= (uint64_t)(ch == ',' || ch == ';' || ch == '|') << i;
+            newline_mask |= (uint64_t)(ch == '\n') << i;
+        }
+
+        delimiters[b] = delimiter_mask;
+        newlines[b] = newline_mask;
+    }
+}
+
+#ifdef SCAN_HAS_X86
+__attribute__((target("sse2")))
+static void scan_sse2(const char *data, size_t num_blocks, uint64_t *delimiters, uint64_t *newlines) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i semicolon = _mm_set1_epi8(';');
+    const __m128i pipe = _mm_set1_epi8('|');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        const char *block = data + b * SCAN_BLOCK_SIZE;
+        uint64_t delimiter_mask = 0, newline_mask = 0;
+
+        for (int lane = 0; lane < 4; lane++) {
+            __m128i bytes = _mm_loadu_si128((const __m128i *)(block + lane * 16));
+            __m128i is_delimiter = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, comma),
+                                                             _mm_cmpeq_epi8(bytes, semicolon)),
+                                                _mm_cmpeq_epi8(bytes, pipe));
+
+            delimiter_mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(is_delimiter) << (lane * 16);
+            newline_mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)) << (lane * 16);
+        }
+
+        delimiters[b] = delimiter_mask;
+        newlines[b] = newline_mask;
+    }
+}
+
+__attribute__((target("avx2")))
+static void scan_avx2(const char *data, size_t num_blocks, uint64_t *delimiters, uint64_t *newlines) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i semicolon = _mm256_set1_epi8(';');
+    const __m256i pipe = _mm256_set1_epi8('|');
+    const __m256i newline = _mm256_set1_epi8('\n');
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        const char *block = data + b * SCAN_BLOCK_SIZE;
+
+        __m256i low = _mm256_loadu_si256((const __m256i *)block);
+        __m256i high = _mm256_loadu_si256((const __m256i *)(block + 32));
+
+        __m256i low_delimiter = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(low, comma),
+                                                                _mm256_cmpeq_epi8(low, semicolon)),
+                                                _mm256_cmpeq_epi8(low, pipe));
+        __m256i high_delimiter = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(high, comma),
+                                                                 _mm256_cmpeq_epi8(high, semicolon)),
+                                                 _mm256_cmpeq_epi8(high, pipe));
+
+        delimiters[b] = (uint64_t)(uint32_t)_mm256_movemask_epi8(low_delimiter) |
+                        (uint64_t)(uint32_t)_mm256_movemask_epi8(high_delimiter) << 32;
+        newlines[b] = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline)) |
+                      (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline)) << 32;
+    }
+}
+#endif
+
+static pthread_once_t dispatch_once = PTHREAD_ONCE_INIT;
+static scan_isa_t detected_isa = SCAN_SCALAR;
+static scan_isa_t active_isa = SCAN_SCALAR;
+static scan_fn active_scan = scan_scalar;
+
+static scan_fn scan_for_isa(scan_isa_t isa) {
+#ifdef SCAN_HAS_X86
+    if (isa == SCAN_AVX2) return scan_avx2;
+    if (isa == SCAN_SSE2) return scan_sse2;
+#endif
+    (void)isa;
+    return scan_scalar;
+}
+
+static void detect_isa(void) {
+#ifdef SCAN_HAS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) detected_isa = SCAN_AVX2;
+    else if (__builtin_cpu_supports("sse2")) detected_isa = SCAN_SSE2;
+#endif
+    active_isa = detected_isa;
+    active_scan = scan_for_isa(active_isa);
+}
+
+void scan_structural_blocks(const char *data, size_t num_blocks, uint64_t *delimiters, uint64_t *newlines) {
+    pthread_once(&dispatch_once, detect_isa);
+    active_scan(data, num_blocks, delimiters, newlines);
+}
+
+scan_isa_t scan_active_isa(void) {
+    pthread_once(&dispatch_once, detect_isa);
+    return active_isa;
+}
+
+void scan_set_isa(scan_isa_t isa) {
+    pthread_once(&dispatch_once, detect_isa);
+    if (isa > detected_isa) isa = detected_isa;
+    active_isa = isa;
+    active_scan = scan_for_isa(isa);
+}
+
+const char *scan_isa_name(scan_isa_t isa) {
+    switch (isa) {
+        case SCAN_AVX2: return "avx2";
+        case SCAN_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,34 @@
+// structural_scan.h
+#ifndef STRUCTURAL_SCAN_H
+#define STRUCTURAL_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCAN_BLOCK_SIZE 64
+
+typedef enum {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} scan_isa_t;
+
+/*
+    Build one delimiter (",;|") mask and one newline mask per 64 byte block,
+    bit i of block b is set when data[b * 64 + i] is structural.
+    @param data: start of the range, need not be aligned
+    @param num_blocks: number of full 64 byte blocks to scan
+    @param delimiters: out, num_blocks masks
+    @param newlines: out, num_blocks masks
+ */
+void scan_structural_blocks(const char *data, size_t num_blocks, uint64_t *delimiters, uint64_t *newlines);
+
+// Picks SSE2 or AVX2 at runtime from the host cpu, scalar elsewhere
+scan_isa_t scan_active_isa(void);
+
+// Forces an instruction set for benchmarking, ignored if the cpu can't run it
+void scan_set_isa(scan_isa_t isa);
+
+const char *scan_isa_name(scan_isa_t isa);
+
+#endif // STRUCTURAL_SCAN_H
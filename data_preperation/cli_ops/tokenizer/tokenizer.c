@@ -0,0 +1,791 @@
+// tokenizer.c
+#include "tokenizer.h"
+#include "structural_scan.h"
+#include "../../arithmetic_lib/fat_data/fat_data.h"
+#include "../../arithmetic_lib/thread_pool/thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INITIAL_CELL_CAPACITY 64
+#define SCAN_BATCH_BLOCKS 64 // 4KB of masks per scanner call
+
+// Files smaller than this per thread are not worth splitting
+#ifndef MIN_PARSE_CHUNK_BYTES
+#define MIN_PARSE_CHUNK_BYTES (1 << 16)
+#endif
+
+// Bytes tokenized per streaming window, bounds the views a streaming thread holds
+#ifndef STREAM_WINDOW_BYTES
+#define STREAM_WINDOW_BYTES (1 << 18)
+#endif
+
+typedef enum {
+    LINE_OK,
+    LINE_WIDTH_MISMATCH,
+    LINE_REPEAT_HEADER,
+    LINE_OVERFLOW,
+    LINE_ALLOC_FAILED
+} line_status_t;
+
+// Parse errors are recorded rather than printed so chunks can report them in file order
+typedef struct {
+    line_status_t status;
+    int line;                // Line index local to the chunk
+    int width;               // Width of the offending line
+    size_t prefix_start;     // Line prefix for width errors
+    size_t prefix_length;
+    const char *header;      // Requested header for repeat errors
+} line_error_t;
+
+typedef struct {
+    cell_view_t *cells;
+    size_t num_cells;
+    size_t capacity;
+} cell_buffer_t;
+
+// One range of the layout pre-pass, only the first cell of each line is read
+typedef struct {
+    const char *data;
+    size_t start;            // inclusive, first byte of a line
+    size_t end;              // exclusive
+    header_strings requested_headers;
+
+    int num_lines;
+    header_integers row_matches; // Row header matches, local line + 1
+    bool any_first_cell_numeric;
+    bool all_first_cells_numeric;
+    line_error_t error;
+} scan_chunk_t;
+
+// Function to check if a specific field is set (not -1)
+bool value_set(header_integers header_indeces, HeaderField field) {
+    switch (field) {
+        case STARTING_ROW:
+            return header_indeces.starting_row != -1;
+        case ENDING_ROW:
+            return header_indeces.ending_row != -1;
+        case STARTING_COLUMN:
+            return header_indeces.starting_column != -1;
+        case ENDING_COLUMN:
+            return header_indeces.ending_column != -1;
+        default:
+            return false; // Invalid field
+    }
+}
+
+// Compare a view against a NUL-terminated requested header
+static inline bool view_equals(const char *token, int length, const char *header) {
+    return header && strncmp(header, token, length) == 0 && header[length] == '\0';
+}
+
+static int *header_field(header_integers *header_indeces, HeaderField field) {
+    switch (field) {
+        case STARTING_ROW: return &header_indeces->starting_row;
+        case ENDING_ROW: return &header_indeces->ending_row;
+        case STARTING_COLUMN: return &header_indeces->starting_column;
+        default: return &header_indeces->ending_column;
+    }
+}
+
+// Record a header match, do not allow for repeat headers
+static bool match_header(const char *token, int length, const char *requested,
+    header_integers *header_indeces, HeaderField field, int index, line_error_t *error) {
+
+    if (!view_equals(token, length, requested)) return true;
+
+    if (value_set(*header_indeces, field)) {
+        error->status = LINE_REPEAT_HEADER;
+        error->header = requested;
+        return false;
+    }
+
+    *header_field(header_indeces, field) = index;
+    return true;
+}
+
+static bool push_cell(cell_buffer_t *buffer, size_t offset, int length) {
+    if (buffer->num_cells == buffer->capacity) {
+        if (buffer->capacity > SIZE_MAX / 2 / sizeof(cell_view_t)) return false;
+
+        size_t new_capacity = buffer->capacity ? buffer->capacity * 2 : INITIAL_CELL_CAPACITY;
+        cell_view_t *new_cells = realloc(buffer->cells, new_capacity * sizeof(cell_view_t));
+        if (!new_cells) return false;
+
+        buffer->cells = new_cells;
+        buffer->capacity = new_capacity;
+    }
+
+    buffer->cells[buffer->num_cells].offset = offset;
+    buffer->cells[buffer->num_cells].length = length;
+    buffer->num_cells++;
+
+    return true;
+}
+
+// Parsing state for one byte range, lines are finished as newline bits are consumed
+typedef struct {
+    const char *data;
+    cell_buffer_t *buffer;
+    header_strings requested_headers;
+    header_integers *header_indeces;
+    int *data_width;
+    bool first_line;
+    int num_lines;           // Lines finished so far in this range
+    size_t line_start;
+    size_t first_token_end;  // For the error prefix, mirrors the old strtok'd copy
+    int current_width;
+    line_error_t *error;
+} line_parser_t;
+
+// Store a token [start, end) of the current line and look for the requested headers in it
+static inline bool emit_token(line_parser_t *parser, size_t start, size_t end) {
+    if (end - start > INT_MAX || parser->current_width >= INT_MAX - 1) {
+        parser->error->status = LINE_OVERFLOW;
+        parser->error->line = parser->num_lines;
+        return false;
+    }
+
+    const char *token = parser->data + start;
+    int length = (int)(end - start);
+    parser->current_width++;
+
+    if (parser->first_line) {
+        int column = parser->current_width - 1;
+        if (!match_header(token, length, parser->requested_headers.starting_column, parser->header_indeces, STARTING_COLUMN, column, parser->error) ||
+            !match_header(token, length, parser->requested_headers.ending_column, parser->header_indeces, ENDING_COLUMN, column, parser->error)) {
+            parser->error->line = parser->num_lines;
+            return false;
+        }
+    }
+    if (parser->current_width == 1) {
+        parser->first_token_end = end;
+
+        if (!match_header(token, length, parser->requested_headers.starting_row, parser->header_indeces, STARTING_ROW, parser->num_lines + 1, parser->error) ||
+            !match_header(token, length, parser->requested_headers.ending_row, parser->header_indeces, ENDING_ROW, parser->num_lines + 1, parser->error)) {
+            parser->error->line = parser->num_lines;
+            return false;
+        }
+    }
+
+    if (!push_cell(parser->buffer, start, length)) {
+        parser->error->status = LINE_ALLOC_FAILED;
+        parser->error->line = parser->num_lines;
+        return false;
+    }
+
+    return true;
+}
+
+// Ensure data is aligned properly once the line ending at line_end is complete
+static inline bool finish_line(line_parser_t *parser, size_t line_end) {
+    if (parser->first_line) {
+        *parser->data_width = parser->current_width;
+        parser->first_line = false;
+    } else if (parser->current_width != *parser->data_width) {
+        size_t prefix_end = parser->current_width > 0 ? parser->first_token_end : line_end;
+        parser->error->status = LINE_WIDTH_MISMATCH;
+        parser->error->line = parser->num_lines;
+        parser->error->width = parser->current_width;
+        parser->error->prefix_start = parser->line_start;
+        parser->error->prefix_length = prefix_end - parser->line_start;
+        return false;
+    }
+
+    if (parser->num_lines >= INT_MAX - 1) {
+        parser->error->status = LINE_OVERFLOW;
+        parser->error->line = parser->num_lines;
+        return false;
+    }
+
+    parser->num_lines++;
+    parser->current_width = 0;
+    parser->line_start = line_end + 1;
+
+    return true;
+}
+
+/*
+    Tokenize [start, end) of the mapping. Delimiter and newline positions come
+    from the vectorized block scanner and cells are cut straight from the masks.
+    Repeated delimiters collapse, so empty tokens are skipped.
+ */
+static bool parse_range(line_parser_t *parser, size_t start, size_t end) {
+    uint64_t delimiters[SCAN_BATCH_BLOCKS], newlines[SCAN_BATCH_BLOCKS];
+    char tail[SCAN_BLOCK_SIZE];
+
+    size_t pos = start;
+    size_t token_start = start;
+    parser->line_start = start;
+    parser->current_width = 0;
+
+    while (pos < end) {
+        size_t remaining = end - pos;
+        size_t num_blocks = remaining / SCAN_BLOCK_SIZE;
+        const char *base = parser->data + pos;
+        size_t span;
+
+        if (num_blocks == 0) {
+            // Zero padding is never structural
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, base, remaining);
+            base = tail;
+            num_blocks = 1;
+            span = remaining;
+        } else {
+            if (num_blocks > SCAN_BATCH_BLOCKS) num_blocks = SCAN_BATCH_BLOCKS;
+            span = num_blocks * SCAN_BLOCK_SIZE;
+        }
+
+        scan_structural_blocks(base, num_blocks, delimiters, newlines);
+
+        for (size_t b = 0; b < num_blocks; b++) {
+            uint64_t structural = delimiters[b] | newlines[b];
+            size_t block_start = pos + b * SCAN_BLOCK_SIZE;
+
+            while (structural) {
+                int bit = __builtin_ctzll(structural);
+                size_t boundary = block_start + bit;
+
+                if (boundary > token_start && !emit_token(parser, token_start, boundary)) return false;
+                if ((newlines[b] >> bit) & 1) {
+                    if (!finish_line(parser, boundary)) return false;
+                }
+
+                token_start = boundary + 1;
+                structural &= structural - 1;
+            }
+        }
+
+        pos += span;
+    }
+
+    // Operate on a final line with no trailing newline
+    if (end > token_start && !emit_token(parser, token_start, end)) return false;
+    if (end > parser->line_start && !finish_line(parser, end)) return false;
+
+    return true;
+}
+
+static void report_line_error(const char *data, const line_error_t *error, int row_number, int data_width) {
+    switch (error->status) {
+        case LINE_WIDTH_MISMATCH:
+            fprintf(stderr, "Error: Line width (%d) does not match the expected width (%d)\n", error->width, data_width);
+            fprintf(stderr, "Line prefix: %.*s, Row number: %d\n",
+                    error->prefix_length > INT_MAX ? INT_MAX : (int)error->prefix_length,
+                    data + error->prefix_start, row_number);
+            break;
+        case LINE_REPEAT_HEADER:
+            fprintf(stderr, "Error: Repeat header \"%s\"\n", error->header);
+            break;
+        case LINE_OVERFLOW:
+            fprintf(stderr, "Error: Maximum number of values (%d) exceeded.\n", INT_MAX);
+            break;
+        case LINE_ALLOC_FAILED:
+            fprintf(stderr, "Memory reallocation failed\n");
+            break;
+        default:
+            break;
+    }
+}
+
+static pthread_once_t page_size_once = PTHREAD_ONCE_INIT;
+static size_t page_size = 4096;
+
+static void read_page_size(void) {
+    long size = sysconf(_SC_PAGESIZE);
+    if (size > 0) page_size = (size_t)size;
+}
+
+static size_t first_whole_page(size_t position) {
+    pthread_once(&page_size_once, read_page_size);
+    return (position + page_size - 1) / page_size * page_size;
+}
+
+/*
+    Drop the whole pages of the mapping in [*released, position) once a pass is done
+    with them, so a pass over the file only keeps a window of it resident. The mapping
+    is never written, so later reads just fault the pages back in from the file.
+ */
+static void release_pages(const char *data, size_t *released, size_t position) {
+    size_t release_end = position / page_size * page_size;
+
+    if (release_end >= *released + STREAM_WINDOW_BYTES) {
+        madvise((char *)data + *released, release_end - *released, MADV_DONTNEED);
+        *released = release_end;
+    }
+}
+
+static inline bool is_delimiter(char ch) {
+    return ch == ',' || ch == ';' || ch == '|';
+}
+
+/*
+    Layout pre-pass over a chunk: count lines and look only at the first cell of each,
+    which is all the row header checks and row header matches need. Lines are found
+    with memchr and never tokenized past their first cell.
+ */
+static void scan_first_cells(scan_chunk_t *chunk) {
+    const char *data = chunk->data;
+    size_t pos = chunk->start;
+    size_t released = first_whole_page(pos);
+
+    chunk->any_first_cell_numeric = false;
+    chunk->all_first_cells_numeric = true;
+
+    while (pos < chunk->end) {
+        const char *newline = memchr(data + pos, '\n', chunk->end - pos);
+        size_t line_end = newline ? (size_t)(newline - data) : chunk->end;
+
+        size_t token_start = pos;
+        while (token_start < line_end && is_delimiter(data[token_start])) token_start++;
+        size_t token_end = token_start;
+        while (token_end < line_end && !is_delimiter(data[token_end])) token_end++;
+
+        // A line with no tokens can never match the width of the first line
+        if (token_start == line_end) {
+            chunk->error.status = LINE_WIDTH_MISMATCH;
+            chunk->error.line = chunk->num_lines;
+            chunk->error.width = 0;
+            chunk->error.prefix_start = pos;
+            chunk->error.prefix_length = line_end - pos;
+            return;
+        }
+        if (token_end - token_start > INT_MAX || chunk->num_lines >= INT_MAX - 1) {
+            chunk->error.status = LINE_OVERFLOW;
+            chunk->error.line = chunk->num_lines;
+            return;
+        }
+
+        const char *token = data + token_start;
+        int length = (int)(token_end - token_start);
+
+        if (!match_header(token, length, chunk->requested_headers.starting_row, &chunk->row_matches, STARTING_ROW, chunk->num_lines + 1, &chunk->error) ||
+            !match_header(token, length, chunk->requested_headers.ending_row, &chunk->row_matches, ENDING_ROW, chunk->num_lines + 1, &chunk->error)) {
+            chunk->error.line = chunk->num_lines;
+            return;
+        }
+
+        if (is_valid_double_n(token, length)) chunk->any_first_cell_numeric = true;
+        else chunk->all_first_cells_numeric = false;
+
+        chunk->num_lines++;
+        pos = line_end + 1;
+        release_pages(data, &released, pos);
+    }
+}
+
+// Pool task over chunks [begin, end), errors stay on the chunk for stitching
+static bool scan_chunks(void *args, size_t begin, size_t end, int worker) {
+    scan_chunk_t *chunks = (scan_chunk_t *)args;
+    for (size_t i = begin; i < end; i++) scan_first_cells(&chunks[i]);
+    return true;
+}
+
+// Advance a nominal split point to the start of the next line
+static size_t align_to_line(const char *data, size_t data_size, size_t position) {
+    if (position == 0 || position >= data_size) return position;
+    if (data[position - 1] == '\n') return position;
+
+    const char *newline = memchr(data + position, '\n', data_size - position);
+    return newline ? (size_t)(newline - data) + 1 : data_size;
+}
+
+/*
+    Merge the row header matches of a chunk into the global indeces in line order,
+    rejecting headers that were already matched by an earlier chunk
+ */
+static bool stitch_row_matches(const scan_chunk_t *chunk, int base_line,
+    header_integers *header_indeces, line_error_t *error) {
+
+    HeaderField fields[2] = { STARTING_ROW, ENDING_ROW };
+    int lines[2] = { chunk->row_matches.starting_row, chunk->row_matches.ending_row };
+    const char *names[2] = { chunk->requested_headers.starting_row, chunk->requested_headers.ending_row };
+
+    // Visit the earlier match first, ties keep the starting/ending order of emit_token
+    int order[2] = { 0, 1 };
+    if (lines[0] != -1 && lines[1] != -1 && lines[1] < lines[0]) {
+        order[0] = 1;
+        order[1] = 0;
+    }
+
+    for (int k = 0; k < 2; k++) {
+        int f = order[k];
+        if (lines[f] == -1) continue;
+
+        if (value_set(*header_indeces, fields[f])) {
+            error->status = LINE_REPEAT_HEADER;
+            error->header = names[f];
+            return false;
+        }
+        *header_field(header_indeces, fields[f]) = base_line + lines[f];
+    }
+
+    return true;
+}
+
+static bool map_file(const char *file_name, char **data, size_t *data_size) {
+    *data = NULL;
+    *data_size = 0;
+
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening and parsing file contents (corrupted file pointer).\n");
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        perror("fstat failed");
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)file_stat.st_size;
+    if (size > 0) {
+        void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            perror("mmap failed");
+            close(fd);
+            return false;
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        *data = mapping;
+        *data_size = size;
+    }
+    close(fd); // The mapping keeps its own reference
+
+    return true;
+}
+
+/*
+    The first line sets the width and holds the column headers, parse it up front
+    @param body_start: out, offset of the second line
+ */
+static bool parse_first_line(const char *data, size_t data_size,
+    header_strings requested_headers, header_integers *header_indeces,
+    int *data_width, cell_buffer_t *first_buffer, size_t *body_start) {
+
+    line_error_t error = { .status = LINE_OK };
+
+    const char *newline = memchr(data, '\n', data_size);
+    *body_start = newline ? (size_t)(newline - data) + 1 : data_size;
+
+    line_parser_t first_parser = {
+        .data = data,
+        .buffer = first_buffer,
+        .requested_headers = requested_headers,
+        .header_indeces = header_indeces,
+        .data_width = data_width,
+        .first_line = true,
+        .error = &error
+    };
+    if (!parse_range(&first_parser, 0, *body_start)) {
+        report_line_error(data, &error, 1, *data_width);
+        fprintf(stderr, "File format error detected.\n");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+    Split everything after the first line into one newline aligned range per thread and
+    scan their first cells on the thread pool, the ranges become the streaming and band layout
+    @return chunks in file order, NULL on allocation failure
+ */
+static scan_chunk_t *run_chunks(const char *data, size_t data_size, size_t body_start,
+    header_strings requested_headers, int thread_count, int *num_chunks_out) {
+
+    size_t body_size = data_size - body_start;
+
+    int workers = thread_count > 0 ? thread_count : 1;
+    if (workers > THREAD_POOL_MAX_WORKERS) workers = THREAD_POOL_MAX_WORKERS;
+
+    size_t max_chunks = body_size / MIN_PARSE_CHUNK_BYTES;
+    int num_chunks = (int)((size_t)workers < max_chunks ? (size_t)workers : max_chunks);
+    if (num_chunks < 1) num_chunks = 1;
+
+    scan_chunk_t *chunks = calloc(num_chunks, sizeof(scan_chunk_t));
+    if (!chunks) {
+        perror("Memory allocation failed");
+        return NULL;
+    }
+
+    size_t chunk_start = body_start;
+    for (int i = 0; i < num_chunks; i++) {
+        size_t nominal_end = (i == num_chunks - 1) ? data_size : body_start + (body_size / num_chunks) * (i + 1);
+        size_t chunk_end = align_to_line(data, data_size, nominal_end);
+        if (chunk_end < chunk_start) chunk_end = chunk_start;
+
+        chunks[i].data = data;
+        chunks[i].start = chunk_start;
+        chunks[i].end = chunk_end;
+        chunks[i].requested_headers = requested_headers;
+        chunks[i].row_matches = (header_integers){ -1, -1, -1, -1 };
+        chunks[i].error.status = LINE_OK;
+        chunk_start = chunk_end;
+    }
+
+    thread_pool_for(num_chunks, 1, workers, scan_chunks, chunks);
+
+    *num_chunks_out = num_chunks;
+    return chunks;
+}
+
+// Merge row header matches and report the first error in file order
+static bool stitch_chunks(const char *data, scan_chunk_t *chunks, int num_chunks,
+    header_integers *header_indeces, int data_width, long long *total_lines) {
+
+    line_error_t error = { .status = LINE_OK };
+    *total_lines = 1;
+
+    for (int i = 0; i < num_chunks; i++) {
+        int base_line = (int)*total_lines;
+
+        if (!stitch_row_matches(&chunks[i], base_line, header_indeces, &error)) {
+            report_line_error(data, &error, 0, data_width);
+            return false;
+        }
+        if (chunks[i].error.status != LINE_OK) {
+            report_line_error(data, &chunks[i].error, base_line + chunks[i].error.line + 1, data_width);
+            return false;
+        }
+        if (*total_lines + chunks[i].num_lines >= INT_MAX) {
+            fprintf(stderr, "Error: Maximum number of values (%d) exceeded.\n", INT_MAX);
+            return false;
+        }
+
+        *total_lines += chunks[i].num_lines;
+    }
+
+    return true;
+}
+
+void free_table_layout(table_layout_t *layout) {
+    if (!layout) return;
+    if (layout->first_row) free(layout->first_row);
+    if (layout->chunks) free(layout->chunks);
+    if (layout->data && layout->data_size > 0) munmap(layout->data, layout->data_size);
+    memset(layout, 0, sizeof(*layout));
+}
+
+// Map the file and record its shape without keeping any views past the first line
+bool scan_table_layout(const char *file_name,
+    header_strings requested_headers, header_integers *header_indeces,
+    table_layout_t *layout, int thread_count) {
+
+    memset(layout, 0, sizeof(*layout));
+    if (!map_file(file_name, &layout->data, &layout->data_size)) return false;
+    if (layout->data_size == 0) return true;
+
+    const char *data = layout->data;
+    cell_buffer_t first_buffer = {0};
+    size_t body_start;
+
+    if (!parse_first_line(data, layout->data_size, requested_headers, header_indeces,
+                          &layout->data_width, &first_buffer, &body_start)) {
+        free(first_buffer.cells);
+        free_table_layout(layout);
+        return false;
+    }
+    layout->first_row = first_buffer.cells;
+
+    int num_chunks = 0;
+    scan_chunk_t *chunks = run_chunks(data, layout->data_size, body_start, requested_headers,
+                                      thread_count, &num_chunks);
+    layout->chunks = chunks ? malloc(num_chunks * sizeof(line_chunk_t)) : NULL;
+    if (!layout->chunks) {
+        if (chunks) perror("Memory allocation failed");
+        free(chunks);
+        free_table_layout(layout);
+        return false;
+    }
+
+    long long total_lines = 1;
+    if (!stitch_chunks(data, chunks, num_chunks, header_indeces, layout->data_width, &total_lines)) {
+        fprintf(stderr, "File format error detected.\n");
+        free(chunks);
+        free_table_layout(layout);
+        return false;
+    }
+
+    layout->num_lines = (int)total_lines;
+    layout->num_chunks = num_chunks;
+    layout->any_first_cell_numeric = layout->data_width > 0 &&
+        is_valid_double_n(data + layout->first_row[0].offset, layout->first_row[0].length);
+    layout->trailing_first_cells_numeric = true;
+
+    int first_line = 1;
+    for (int i = 0; i < num_chunks; i++) {
+        layout->chunks[i] = (line_chunk_t){ chunks[i].start, chunks[i].end, first_line, chunks[i].num_lines };
+        layout->any_first_cell_numeric |= chunks[i].any_first_cell_numeric;
+        layout->trailing_first_cells_numeric &= chunks[i].all_first_cells_numeric;
+        first_line += chunks[i].num_lines;
+    }
+
+    // The first line belongs to the first chunk when streaming
+    layout->chunks[0].start = 0;
+    layout->chunks[0].first_line = 0;
+    layout->chunks[0].num_lines++;
+
+    free(chunks);
+    return true;
+}
+
+typedef struct {
+    const table_layout_t *layout;
+    const line_chunk_t *chunk;
+    int first_row;           // inclusive, global line index
+    int last_row;            // inclusive
+    row_window_visitor_t visit;
+    void *context;
+
+    bool visit_failed;
+    int error_line;          // Global line of the first line in the failing window
+    line_error_t error;
+} stream_chunk_t;
+
+// Skip to the first requested line of the chunk, then tokenize and hand off one window at a time
+static void stream_chunk(stream_chunk_t *stream) {
+    const char *data = stream->layout->data;
+    const line_chunk_t *chunk = stream->chunk;
+
+    int line = chunk->first_line;
+    int last_line = chunk->first_line + chunk->num_lines - 1;
+    int last_row = stream->last_row < last_line ? stream->last_row : last_line;
+    size_t pos = chunk->start;
+
+    // Chunks entirely outside the range are never read
+    if (last_line < stream->first_row || line > last_row) return;
+
+    while (line < stream->first_row && pos < chunk->end) {
+        const char *newline = memchr(data + pos, '\n', chunk->end - pos);
+        pos = newline ? (size_t)(newline - data) + 1 : chunk->end;
+        line++;
+    }
+
+    int data_width = stream->layout->data_width;
+    header_integers unused_matches = { -1, -1, -1, -1 };
+    cell_buffer_t buffer = {0};
+    size_t released = first_whole_page(pos);
+
+    while (line <= last_row && pos < chunk->end) {
+        // Take whole lines until the window is full, never past the last requested row
+        size_t window_end = pos;
+        int window_lines = 0;
+        while (line + window_lines <= last_row && window_end < chunk->end &&
+               (window_lines == 0 || window_end - pos < STREAM_WINDOW_BYTES)) {
+            const char *newline = memchr(data + window_end, '\n', chunk->end - window_end);
+            window_end = newline ? (size_t)(newline - data) + 1 : chunk->end;
+            window_lines++;
+        }
+
+        buffer.num_cells = 0;
+        line_parser_t parser = {
+            .data = data,
+            .buffer = &buffer,
+            .header_indeces = &unused_matches,
+            .data_width = &data_width,
+            .first_line = false,
+            .error = &stream->error
+        };
+
+        if (!parse_range(&parser, pos, window_end)) {
+            stream->error_line = line;
+            break;
+        }
+        if (!stream->visit(stream->context, data, buffer.cells, parser.num_lines, data_width)) {
+            stream->visit_failed = true;
+            break;
+        }
+
+        line += parser.num_lines;
+        pos = window_end;
+        release_pages(data, &released, pos);
+    }
+
+    free(buffer.cells);
+}
+
+struct row_stream {
+    const table_layout_t *layout;
+    stream_chunk_t *chunks;
+    int num_chunks;
+};
+
+row_stream_t *row_stream_create(const table_layout_t *layout, int first_row, int last_row,
+    row_window_visitor_t visit, void *const *contexts) {
+
+    row_stream_t *stream = malloc(sizeof(row_stream_t));
+    stream_chunk_t *chunks = calloc(layout->num_chunks, sizeof(stream_chunk_t));
+    if (!stream || !chunks) {
+        perror("Memory allocation failed");
+        free(stream);
+        free(chunks);
+        return NULL;
+    }
+
+    for (int i = 0; i < layout->num_chunks; i++) {
+        chunks[i] = (stream_chunk_t){
+            .layout = layout,
+            .chunk = &layout->chunks[i],
+            .first_row = first_row,
+            .last_row = last_row,
+            .visit = visit,
+            .context = contexts[i],
+            .error = { .status = LINE_OK }
+        };
+    }
+
+    *stream = (row_stream_t){ layout, chunks, layout->num_chunks };
+    return stream;
+}
+
+void row_stream_chunk(row_stream_t *stream, int chunk) {
+    stream_chunk(&stream->chunks[chunk]);
+}
+
+bool row_stream_finish(row_stream_t *stream) {
+    // Report in file order, like the full tokenizer
+    bool success = true;
+    for (int i = 0; i < stream->num_chunks && success; i++) {
+        stream_chunk_t *chunk = &stream->chunks[i];
+        if (chunk->visit_failed) {
+            success = false;
+        } else if (chunk->error.status != LINE_OK) {
+            report_line_error(stream->layout->data, &chunk->error,
+                              chunk->error_line + chunk->error.line + 1, stream->layout->data_width);
+            fprintf(stderr, "File format error detected.\n");
+            success = false;
+        }
+    }
+
+    free(stream->chunks);
+    free(stream);
+    return success;
+}
+
+// Pool task over streamed chunks [begin, end), failures stay on the chunk for reporting
+static bool stream_chunks(void *args, size_t begin, size_t end, int worker) {
+    row_stream_t *stream = (row_stream_t *)args;
+    for (size_t i = begin; i < end; i++) row_stream_chunk(stream, (int)i);
+    return true;
+}
+
+bool stream_table_rows(const table_layout_t *layout, int first_row, int last_row,
+    row_window_visitor_t visit, void *const *contexts) {
+
+    row_stream_t *stream = row_stream_create(layout, first_row, last_row, visit, contexts);
+    if (!stream) return false;
+
+    thread_pool_for(layout->num_chunks, 1, layout->num_chunks, stream_chunks, stream);
+    return row_stream_finish(stream);
+}
\ No newline at end of file
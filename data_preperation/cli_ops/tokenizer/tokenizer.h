@@ -0,0 +1,104 @@
+// tokenizer.h
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct header_strings {
+    char *starting_row;
+    char *ending_row;
+    char *starting_column;
+    char *ending_column;
+} typedef header_strings;
+
+struct header_integers {
+    int starting_row;
+    int ending_row;
+    int starting_column;
+    int ending_column;
+} typedef header_integers;
+
+typedef enum {
+    STARTING_ROW,
+    ENDING_ROW,
+    STARTING_COLUMN,
+    ENDING_COLUMN
+} HeaderField;
+
+// A cell stored as a window into the mapped file, the bytes are never copied
+typedef struct {
+    size_t offset; // Byte offset of the first character in the mapping
+    int length;    // Number of characters, not NUL-terminated
+} cell_view_t;
+
+bool value_set(header_integers header_indeces, HeaderField field);
+
+// Newline aligned byte range of the file, lines are numbered from first_line
+typedef struct {
+    size_t start;        // inclusive, first byte of a line
+    size_t end;          // exclusive
+    int first_line;
+    int num_lines;
+} line_chunk_t;
+
+// Shape of a mapped file, enough to resolve bounds without tokenizing its body
+typedef struct {
+    char *data;                        // Read-only mapping of the whole file
+    size_t data_size;
+    cell_view_t *first_row;            // data_width views of the first line
+    int data_width;
+    int num_lines;
+    bool any_first_cell_numeric;       // Over the first cell of every line
+    bool trailing_first_cells_numeric; // Over the first cell of every line but the first
+    line_chunk_t *chunks;              // Per-thread ranges covering the whole file
+    int num_chunks;
+} table_layout_t;
+
+/*
+    Cheap pre-pass that resolves bounds before the body is tokenized: tokenizes the first
+    line, then only reads the first cell of every other line for row header matches and checks. Lines with no cells are
+    rejected here, the width of every other line is checked when it is streamed.
+    @param thread_count: upper bound on scan threads, also the number of streaming chunks
+    @return true on success, layout must be released with free_table_layout
+ */
+bool scan_table_layout(const char *file_name,
+    header_strings requested_headers, header_integers *header_indeces,
+    table_layout_t *layout, int thread_count);
+
+void free_table_layout(table_layout_t *layout);
+
+/*
+    Called with a window of consecutive tokenized lines, views are only valid during the call.
+    A chunk's windows arrive in file order, starting at the later of its first line and first_row
+    @return false to stop streaming
+ */
+typedef bool (*row_window_visitor_t)(void *context, const char *data,
+    const cell_view_t *cells, int num_rows, int data_width);
+
+/*
+    Tokenize lines [first_row, last_row] one bounded window at a time, one thread per
+    layout chunk, so no more than a window of views per thread is ever held.
+    Lines outside the range are never tokenized and chunks past last_row are not read.
+    @param contexts: one visitor context per layout chunk, visited in file order within a chunk
+    @return false on a width error or when a visitor stopped
+ */
+bool stream_table_rows(const table_layout_t *layout, int first_row, int last_row,
+    row_window_visitor_t visit, void *const *contexts);
+
+/*
+    stream_table_rows in steps, for callers that run the chunks alongside other work:
+    create, row_stream_chunk once for every layout chunk from any thread, then finish.
+    @return NULL on allocation failure
+ */
+typedef struct row_stream row_stream_t;
+row_stream_t *row_stream_create(const table_layout_t *layout, int first_row, int last_row,
+    row_window_visitor_t visit, void *const *contexts);
+
+// Tokenize and visit one chunk on the calling thread, a failure is kept for finish to report
+void row_stream_chunk(row_stream_t *stream, int chunk);
+
+// Report the first failure in file order and release the stream, @return false when a chunk failed
+bool row_stream_finish(row_stream_t *stream);
+
+#endif // TOKENIZER_H
@@ -0,0 +1,113 @@
+// benchmarks/handle_benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../../data_preperation/cli_ops/martix_lib.h"
+
+#define DEFAULT_QUERIES 8
+
+extern int load_data(const char *, const char *, const char *, const char *, const char *, int, int);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int count_lines(const char *file) {
+    FILE *stream = fopen(file, "r");
+    if (!stream) return -1;
+
+    int lines = 0, c, last = '\n';
+    while ((c = getc(stream)) != EOF) {
+        if (c == '\n') lines++;
+        last = c;
+    }
+    if (last != '\n') lines++;
+    fclose(stream);
+    return lines;
+}
+
+// Rows 1 to the q + 1th share of the data rows, 1-indexed like the CLI, so the queries overlap the way repeated looks at a file do
+static void prefix(int q, int num_queries, int data_rows, char *first, char *last) {
+    int end = (int)((long long)data_rows * (q + 1) / num_queries);
+    sprintf(first, "%d", 1);
+    sprintf(last, "%d", end < 1 ? 1 : end);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <csv files...>\n", argv[0]);
+        return 1;
+    }
+
+    int num_queries = getenv("BENCH_QUERIES") ? atoi(getenv("BENCH_QUERIES")) : DEFAULT_QUERIES;
+    int threads = getenv("BENCH_THREADS") ? atoi(getenv("BENCH_THREADS")) : 4;
+    if (num_queries < 1) num_queries = 1;
+    if (threads < 1) threads = 1;
+    int operations = OP_MAX | OP_MIN | OP_MEAN | OP_MEDIAN;
+
+    // The queries print their subregions and results, only the timings go to the terminal
+    int terminal = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (terminal < 0 || null_fd < 0) {
+        fprintf(stderr, "[ERROR] Could not redirect stdout\n");
+        return 1;
+    }
+    FILE *report = fdopen(terminal, "w");
+
+    fprintf(report, "%-40s %-10s %8s %12s %12s %10s\n", "file", "api", "queries", "seconds", "per query", "speedup");
+    for (int f = 1; f < argc; f++) {
+        int data_rows = count_lines(argv[f]) - 1;
+        if (data_rows < 1) {
+            fprintf(stderr, "[ERROR] Could not read rows of %s\n", argv[f]);
+            return 1;
+        }
+
+        char first[16], last[16];
+        bool ok = true;
+        fflush(stdout);
+        dup2(null_fd, STDOUT_FILENO);
+
+        // Every query parses the file again
+        double start = now_seconds();
+        for (int q = 0; ok && q < num_queries; q++) {
+            prefix(q, num_queries, data_rows, first, last);
+            ok = load_data(argv[f], first, last, "full", "full", operations, threads) == 0;
+        }
+        double one_off = now_seconds() - start;
+
+        // One parse shared by every query
+        final_args_t results;
+        start = now_seconds();
+        dataframe_t *frame = ok ? fd_open(argv[f], threads) : NULL;
+        for (int q = 0; frame && ok && q < num_queries; q++) {
+            prefix(q, num_queries, data_rows, first, last);
+            ok = fd_query(frame, first, last, "full", "full", operations, threads, NULL, &results) == 0;
+        }
+        fd_close(frame);
+        double handle = now_seconds() - start;
+
+        fflush(stdout);
+        dup2(terminal, STDOUT_FILENO);
+        if (!ok || !frame) {
+            fprintf(stderr, "[ERROR] Query failed on %s\n", argv[f]);
+            return 1;
+        }
+
+        fprintf(report, "%-40s %-10s %8d %12.4f %12.4f %9.1fx\n", argv[f], "load_data", num_queries,
+                one_off, one_off / num_queries, 1.0);
+        fprintf(report, "%-40s %-10s %8d %12.4f %12.4f %9.1fx\n", argv[f], "fd_query", num_queries,
+                handle, handle / num_queries, one_off / handle);
+        fflush(report);
+    }
+
+    close(null_fd);
+    fclose(report);
+    return 0;
+}
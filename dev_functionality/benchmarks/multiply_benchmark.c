@@ -0,0 +1,323 @@
+// benchmarks/multiply_benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../data_preperation/arithmetic_lib/bignum/bignum.h"
+#include "../../data_preperation/arithmetic_lib/fat_data/fat_data.h"
+
+#define DEFAULT_REPEATS 5
+#define MIN_BATCH_SECONDS 0.02
+
+// The string implementation overflows its fixed buffers once products pass MAX_NUMBER_LENGTH digits
+#define LEGACY_MAX_DIGITS (MAX_NUMBER_LENGTH / 2 - 48)
+#define WRAPPER_MAX_DIGITS (MAX_NUMBER_LENGTH - 1)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+    The string Karatsuba karatsuba_multiply used before the limb kernels, kept here as the baseline.
+    It recurses to single digits with ten MAX_NUMBER_LENGTH buffers per frame.
+ */
+static void legacy_add_unsigned(const char *num1, const char *num2, char *result) {
+    int len1 = strlen(num1), len2 = strlen(num2);
+    int carry = 0, sum, i, j, k = 0;
+    char temp[MAX_NUMBER_LENGTH] = {0};
+
+    for (i = len1 - 1, j = len2 - 1; i >= 0 || j >= 0 || carry; i--, j--, k++) {
+        int digit1 = (i >= 0) ? num1[i] - '0' : 0;
+        int digit2 = (j >= 0) ? num2[j] - '0' : 0;
+        sum = digit1 + digit2 + carry;
+        carry = sum / 10;
+        temp[k] = (sum % 10) + '0';
+    }
+
+    for (i = 0; i < k; i++) result[i] = temp[k - i - 1];
+    result[k] = '\0';
+}
+
+static void legacy_subtract_unsigned(const char *num1, const char *num2, char *result) {
+    int len1 = strlen(num1), len2 = strlen(num2);
+    int borrow = 0, i, j, k = 0;
+    char temp[MAX_NUMBER_LENGTH] = {0};
+
+    for (i = len1 - 1, j = len2 - 1; i >= 0; i--, j--, k++) {
+        int digit1 = num1[i] - '0' - borrow;
+        int digit2 = (j >= 0) ? num2[j] - '0' : 0;
+        borrow = 0;
+        if (digit1 < digit2) {
+            digit1 += 10;
+            borrow = 1;
+        }
+        temp[k] = (digit1 - digit2) + '0';
+    }
+
+    while (k > 1 && temp[k - 1] == '0') k--;
+
+    for (i = 0; i < k; i++) result[i] = temp[k - i - 1];
+    result[k] = '\0';
+}
+
+static void legacy_add_big_integers(const char *num1, const char *num2, char *result) {
+    char a[MAX_NUMBER_LENGTH], b[MAX_NUMBER_LENGTH];
+    int neg1 = is_negative(num1), neg2 = is_negative(num2);
+    strip_sign(num1, a);
+    strip_sign(num2, b);
+
+    if (!neg1 && !neg2) {
+        legacy_add_unsigned(a, b, result);
+    } else if (neg1 && neg2) {
+        legacy_add_unsigned(a, b, result);
+        char tmp[MAX_NUMBER_LENGTH];
+        strcpy(tmp, result);
+        snprintf(result, MAX_NUMBER_LENGTH, "-%s", tmp);
+    } else if (neg1 && !neg2) {
+        if (compare_big_numbers(a, b) > 0) {
+            legacy_subtract_unsigned(a, b, result);
+            char tmp[MAX_NUMBER_LENGTH];
+            strcpy(tmp, result);
+            snprintf(result, MAX_NUMBER_LENGTH, "-%s", tmp);
+        } else {
+            legacy_subtract_unsigned(b, a, result);
+        }
+    } else {
+        if (compare_big_numbers(a, b) >= 0) {
+            legacy_subtract_unsigned(a, b, result);
+        } else {
+            legacy_subtract_unsigned(b, a, result);
+            char tmp[MAX_NUMBER_LENGTH];
+            strcpy(tmp, result);
+            snprintf(result, MAX_NUMBER_LENGTH, "-%s", tmp);
+        }
+    }
+}
+
+static void legacy_subtract_big_integers(const char *num1, const char *num2, char *result) {
+    char negated[MAX_NUMBER_LENGTH];
+    if (is_negative(num2)) {
+        strip_sign(num2, negated);
+    } else {
+        snprintf(negated, MAX_NUMBER_LENGTH, "-%s", num2);
+    }
+    legacy_add_big_integers(num1, negated, result);
+}
+
+static void legacy_karatsuba_multiply(const char *num1, const char *num2, char *result) {
+    char a[MAX_NUMBER_LENGTH], b[MAX_NUMBER_LENGTH];
+    strip_sign(num1, a);
+    strip_sign(num2, b);
+    int neg = is_negative(num1) ^ is_negative(num2);
+
+    if (strlen(a) == 1 && strlen(b) == 1) {
+        int product = (a[0] - '0') * (b[0] - '0');
+        snprintf(result, MAX_NUMBER_LENGTH, "%d", product);
+        if (neg && product != 0) {
+            char temp[MAX_NUMBER_LENGTH];
+            snprintf(temp, MAX_NUMBER_LENGTH, "-%s", result);
+            strcpy(result, temp);
+        }
+        return;
+    }
+
+    int n = strlen(a) > strlen(b) ? strlen(a) : strlen(b);
+    if (n % 2 != 0) n++;
+
+    char a_padded[MAX_NUMBER_LENGTH], b_padded[MAX_NUMBER_LENGTH];
+    pad_left_zeros(a, n, a_padded);
+    pad_left_zeros(b, n, b_padded);
+
+    int m = n / 2;
+
+    char a1[MAX_NUMBER_LENGTH], a0[MAX_NUMBER_LENGTH];
+    char b1[MAX_NUMBER_LENGTH], b0[MAX_NUMBER_LENGTH];
+    strncpy(a1, a_padded, m); a1[m] = '\0';
+    strcpy(a0, a_padded + m);
+    strncpy(b1, b_padded, m); b1[m] = '\0';
+    strcpy(b0, b_padded + m);
+
+    char z2[MAX_NUMBER_LENGTH * 2]; legacy_karatsuba_multiply(a1, b1, z2);
+    char z0[MAX_NUMBER_LENGTH * 2]; legacy_karatsuba_multiply(a0, b0, z0);
+
+    char a1_plus_a0[MAX_NUMBER_LENGTH]; legacy_add_big_integers(a1, a0, a1_plus_a0);
+    char b1_plus_b0[MAX_NUMBER_LENGTH]; legacy_add_big_integers(b1, b0, b1_plus_b0);
+    char z1[MAX_NUMBER_LENGTH * 2]; legacy_karatsuba_multiply(a1_plus_a0, b1_plus_b0, z1);
+
+    char temp[MAX_NUMBER_LENGTH * 2];
+    legacy_subtract_big_integers(z1, z2, temp);
+    legacy_subtract_big_integers(temp, z0, z1);
+
+    char z2_shifted[MAX_NUMBER_LENGTH * 2]; shift_left(z2, 2 * (n - m), z2_shifted);
+    char z1_shifted[MAX_NUMBER_LENGTH * 2]; shift_left(z1, n - m, z1_shifted);
+    char temp1[MAX_NUMBER_LENGTH * 2]; legacy_add_big_integers(z2_shifted, z1_shifted, temp1);
+    legacy_add_big_integers(temp1, z0, result);
+
+    if (neg && strcmp(result, "0") != 0) {
+        char tmp[MAX_NUMBER_LENGTH * 2];
+        snprintf(tmp, MAX_NUMBER_LENGTH * 2, "-%s", result);
+        strcpy(result, tmp);
+    }
+
+    strip_leading_zeros(result);
+}
+
+typedef enum {
+    RUN_LEGACY,    // String Karatsuba above
+    RUN_WRAPPER,   // karatsuba_multiply: parse, bignum_mul and format
+    RUN_LIMBS      // bignum_mul_using on parsed operands
+} run_kind_t;
+
+typedef struct {
+    const char *name;
+    run_kind_t kind;
+    bignum_mul_method_t method;
+} contender_t;
+
+static const contender_t contenders[] = {
+    { "legacy",     RUN_LEGACY,  BIGNUM_MUL_AUTO },
+    { "string",     RUN_WRAPPER, BIGNUM_MUL_AUTO },
+    { "schoolbook", RUN_LIMBS,   BIGNUM_MUL_SCHOOLBOOK },
+    { "karatsuba",  RUN_LIMBS,   BIGNUM_MUL_KARATSUBA },
+    { "ntt",        RUN_LIMBS,   BIGNUM_MUL_NTT },
+    { "auto",       RUN_LIMBS,   BIGNUM_MUL_AUTO },
+};
+
+typedef struct {
+    const char *text_a, *text_b;
+    bignum_t a, b, product;
+    char *text_product;   // MAX_NUMBER_LENGTH * 2 for the string contenders
+} operands_t;
+
+static bool run_once(const contender_t *c, operands_t *ops) {
+    switch (c->kind) {
+    case RUN_LEGACY:
+        legacy_karatsuba_multiply(ops->text_a, ops->text_b, ops->text_product);
+        return true;
+    case RUN_WRAPPER:
+        karatsuba_multiply(ops->text_a, ops->text_b, ops->text_product);
+        return true;
+    default:
+        return bignum_mul_using(&ops->product, &ops->a, &ops->b, c->method);
+    }
+}
+
+// Best of repeats seconds per multiply, batches grow until they are long enough to time
+static double time_multiply(const contender_t *c, operands_t *ops, int repeats) {
+    long iterations = 1;
+    double best = -1;
+
+    for (int r = 0; r < repeats; r++) {
+        double elapsed;
+        for (;;) {
+            double start = now_seconds();
+            for (long i = 0; i < iterations; i++) {
+                if (!run_once(c, ops)) return -1;
+            }
+            elapsed = now_seconds() - start;
+            if (elapsed >= MIN_BATCH_SECONDS || r > 0) break;
+            iterations *= 2;
+        }
+
+        double per_call = elapsed / iterations;
+        if (best < 0 || per_call < best) best = per_call;
+    }
+
+    return best;
+}
+
+static char *random_digits(int digits) {
+    char *text = malloc(digits + 1);
+    if (!text) return NULL;
+
+    text[0] = (char)('1' + rand() % 9);
+    for (int i = 1; i < digits; i++) text[i] = (char)('0' + rand() % 10);
+    text[digits] = '\0';
+    return text;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <digits> [digits...]\n", argv[0]);
+        return 1;
+    }
+
+    int repeats = getenv("BENCH_REPEATS") ? atoi(getenv("BENCH_REPEATS")) : DEFAULT_REPEATS;
+    srand(42);
+
+    printf("%-10s %-12s %16s %10s\n", "digits", "kernel", "us/multiply", "vs legacy");
+    for (int arg = 1; arg < argc; arg++) {
+        int digits = atoi(argv[arg]);
+        if (digits < 1) {
+            fprintf(stderr, "[ERROR] Invalid digit count %s\n", argv[arg]);
+            return 1;
+        }
+
+        operands_t ops;
+        ops.text_a = random_digits(digits);
+        ops.text_b = random_digits(digits);
+        ops.text_product = malloc(MAX_NUMBER_LENGTH * 2);
+        bignum_init(&ops.a);
+        bignum_init(&ops.b);
+        bignum_init(&ops.product);
+
+        bignum_t expected;
+        bignum_init(&expected);
+        if (!ops.text_a || !ops.text_b || !ops.text_product ||
+            !bignum_parse(&ops.a, ops.text_a, digits) || !bignum_parse(&ops.b, ops.text_b, digits) ||
+            !bignum_mul_using(&expected, &ops.a, &ops.b, BIGNUM_MUL_SCHOOLBOOK)) {
+            fprintf(stderr, "[ERROR] Failed to set up %d digit operands\n", digits);
+            return 1;
+        }
+
+        double legacy_seconds = -1;
+        for (size_t i = 0; i < sizeof(contenders) / sizeof(contenders[0]); i++) {
+            const contender_t *c = &contenders[i];
+            if (c->kind == RUN_LEGACY && digits > LEGACY_MAX_DIGITS) continue;
+            if (c->kind == RUN_WRAPPER && digits > WRAPPER_MAX_DIGITS) continue;
+
+            double seconds = time_multiply(c, &ops, repeats);
+            if (seconds < 0) {
+                fprintf(stderr, "[ERROR] %s failed on %d digits\n", c->name, digits);
+                return 1;
+            }
+
+            // Every kernel has to agree with schoolbook
+            bool agrees;
+            if (c->kind == RUN_LIMBS) {
+                agrees = bignum_compare(&ops.product, &expected) == 0;
+            } else {
+                bignum_t parsed;
+                bignum_init(&parsed);
+                agrees = bignum_parse(&parsed, ops.text_product, strlen(ops.text_product)) &&
+                         bignum_compare(&parsed, &expected) == 0;
+                bignum_free(&parsed);
+            }
+            if (!agrees) {
+                fprintf(stderr, "[ERROR] %s disagrees with schoolbook on %d digits\n", c->name, digits);
+                return 1;
+            }
+
+            if (c->kind == RUN_LEGACY) legacy_seconds = seconds;
+            if (legacy_seconds > 0) {
+                printf("%-10d %-12s %16.2f %9.1fx\n", digits, c->name, seconds * 1e6, legacy_seconds / seconds);
+            } else {
+                printf("%-10d %-12s %16.2f %10s\n", digits, c->name, seconds * 1e6, "-");
+            }
+        }
+
+        bignum_free(&expected);
+        bignum_free(&ops.a);
+        bignum_free(&ops.b);
+        bignum_free(&ops.product);
+        free((char *)ops.text_a);
+        free((char *)ops.text_b);
+        free(ops.text_product);
+    }
+
+    return 0;
+}
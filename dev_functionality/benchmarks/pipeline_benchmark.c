@@ -0,0 +1,112 @@
+// benchmarks/pipeline_benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "../../data_preperation/cli_ops/marshaller/marshaller.h"
+
+#define DEFAULT_THREADS 4
+#define RESULT_LINES 4
+#define LINE_LENGTH 4096
+
+extern int load_data(const char *, const char *, const char *, const char *, const char *, int, int);
+
+static const char *RESULT_LABELS[RESULT_LINES] = { "   Max   :", "   Min   :", "   Mean  :", "   Mode  :" };
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    double seconds;
+    long peak_kb;                        // Max resident set of the child that ran the query
+    char results[RESULT_LINES][LINE_LENGTH];
+} query_run_t;
+
+/*
+    Runs one end to end query in a child so each mode gets its own peak RSS,
+    with the child's stdout sent to a file the result lines are read back from
+ */
+static bool run_query(const char *file, int operations, int threads, query_run_t *run) {
+    FILE *capture = tmpfile();
+    if (!capture) return false;
+    fflush(stdout);
+
+    double start = now_seconds();
+    pid_t child = fork();
+    if (child < 0) {
+        fclose(capture);
+        return false;
+    }
+    if (child == 0) {
+        dup2(fileno(capture), STDOUT_FILENO);
+        int status = load_data(file, "full", "full", "full", "full", operations, threads);
+        fflush(stdout);
+        _exit(status == 0 ? 0 : 1);
+    }
+
+    int status;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fclose(capture);
+        return false;
+    }
+    run->seconds = now_seconds() - start;
+    run->peak_kb = usage.ru_maxrss;
+
+    memset(run->results, 0, sizeof(run->results));
+    char line[LINE_LENGTH];
+    rewind(capture);
+    while (fgets(line, sizeof(line), capture)) {
+        for (int i = 0; i < RESULT_LINES; i++) {
+            if (strncmp(line, RESULT_LABELS[i], strlen(RESULT_LABELS[i])) == 0) {
+                snprintf(run->results[i], LINE_LENGTH, "%s", line);
+            }
+        }
+    }
+    fclose(capture);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <csv files...>\n", argv[0]);
+        return 1;
+    }
+
+    int threads = getenv("BENCH_THREADS") ? atoi(getenv("BENCH_THREADS")) : DEFAULT_THREADS;
+    if (threads < 1) threads = 1;
+    int operations = OP_MAX | OP_MIN | OP_MEAN | OP_MODE;
+
+    printf("%-40s %-12s %8s %12s %12s %10s\n", "file", "mode", "threads", "seconds", "peak MB", "speedup");
+    for (int f = 1; f < argc; f++) {
+        query_run_t materialized, pipelined;
+        if (!run_query(argv[f], operations, threads, &materialized) ||
+            !run_query(argv[f], operations | OP_PIPELINE, threads, &pipelined)) {
+            fprintf(stderr, "[ERROR] Query failed on %s\n", argv[f]);
+            return 1;
+        }
+
+        for (int i = 0; i < RESULT_LINES; i++) {
+            if (strcmp(materialized.results[i], pipelined.results[i]) != 0) {
+                fprintf(stderr, "[ERROR] Pipelined result disagrees on %s:\n%s%s", argv[f],
+                        materialized.results[i], pipelined.results[i]);
+                return 1;
+            }
+        }
+
+        printf("%-40s %-12s %8d %12.4f %12.1f %9.1fx\n", argv[f], "materialize", threads,
+               materialized.seconds, materialized.peak_kb / 1024.0, 1.0);
+        printf("%-40s %-12s %8d %12.4f %12.1f %9.1fx\n", argv[f], "pipeline", threads,
+               pipelined.seconds, pipelined.peak_kb / 1024.0, materialized.seconds / pipelined.seconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+// benchmarks/pool_benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../../data_preperation/arithmetic_lib/fat_data/fat_data.h"
+#include "../../data_preperation/arithmetic_lib/columnar/columnar.h"
+#include "../../data_preperation/arithmetic_lib/statistical_ops/statistical_ops.h"
+#include "../../data_preperation/arithmetic_lib/thread_pool/thread_pool.h"
+
+#define DEFAULT_REPEATS 3
+#define DEFAULT_VALUES 4000000
+
+// Same block size the marshaller hands the pool
+#define POOL_BLOCK_VALUES (16 * COLUMNAR_BLOCK_VALUES)
+
+// The first eighth of the values are 60 digit integers, summed on limbs rather than in int64
+#define SKEW_FRACTION 8
+#define SKEW_DIGITS 60
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// One column with a slow stretch up front, the way a static split gives one thread all of it
+static bool build_values(size_t count, columnar_subregion_t *region) {
+    columnar_builder_t builder;
+    if (!columnar_builder_init(&builder, 1)) return false;
+
+    char value[SKEW_DIGITS + 1];
+    bool ok = true;
+    unsigned long long state = 88172645463325252ULL;
+    for (size_t i = 0; ok && i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        size_t length;
+        if (i < count / SKEW_FRACTION) {
+            value[0] = (char)('1' + state % 9);
+            for (length = 1; length < SKEW_DIGITS; length++) {
+                value[length] = (char)('0' + (state >> (length % 60)) % 10);
+            }
+        } else {
+            length = (size_t)snprintf(value, sizeof(value), "%llu", state % 1000000);
+        }
+        ok = columnar_builder_append(&builder, 0, value, length);
+    }
+    ok = ok && columnar_from_builders(&builder, 1, (int)count, 1, region);
+
+    columnar_builder_free(&builder);
+    return ok;
+}
+
+typedef struct {
+    const columnar_subregion_t *region;
+    size_t start;
+    size_t end;
+    local_aggregate_t aggregate;
+    bool ok;
+} static_slice_t;
+
+static void *sum_slice(void *args) {
+    static_slice_t *slice = (static_slice_t *)args;
+    slice->ok = compute_local_aggregate(&slice->aggregate, AGGREGATE_SUM, slice->region, slice->start, slice->end,
+                                        NULL, NULL);
+    return NULL;
+}
+
+// How the marshaller ran before the pool: a fresh thread per contiguous slice, joined in order
+static bool sum_static(const columnar_subregion_t *region, size_t count, int threads, char *out, size_t size) {
+    static_slice_t *slices = calloc(threads, sizeof(static_slice_t));
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    bool *started = calloc(threads, sizeof(bool));
+    if (!slices || !ids || !started) return false;
+
+    for (int t = 0; t < threads; t++) {
+        slices[t] = (static_slice_t){ region, count * t / threads, count * (t + 1) / threads };
+        local_aggregate_init(&slices[t].aggregate);
+        started[t] = pthread_create(&ids[t], NULL, sum_slice, &slices[t]) == 0;
+        if (!started[t]) sum_slice(&slices[t]);
+    }
+
+    bool ok = true;
+    for (int t = 0; t < threads; t++) {
+        if (started[t]) pthread_join(ids[t], NULL);
+        ok &= slices[t].ok;
+        if (t > 0) ok = ok && sum_accumulator_merge(&slices[0].aggregate.sum, &slices[t].aggregate.sum);
+    }
+    ok = ok && sum_accumulator_format(&slices[0].aggregate.sum, out, size);
+
+    for (int t = 0; t < threads; t++) local_aggregate_free(&slices[t].aggregate);
+    free(slices);
+    free(ids);
+    free(started);
+    return ok;
+}
+
+typedef struct {
+    const columnar_subregion_t *region;
+    local_aggregate_t *aggregates;   // One per worker
+} pool_sum_t;
+
+static bool sum_block(void *args, size_t begin, size_t end, int worker) {
+    pool_sum_t *job = (pool_sum_t *)args;
+    return compute_local_aggregate(&job->aggregates[worker], AGGREGATE_SUM, job->region, begin, end, NULL, NULL);
+}
+
+static bool sum_pool(const columnar_subregion_t *region, size_t count, int threads, char *out, size_t size) {
+    pool_sum_t job = { region, calloc(threads, sizeof(local_aggregate_t)) };
+    if (!job.aggregates) return false;
+    for (int t = 0; t < threads; t++) local_aggregate_init(&job.aggregates[t]);
+
+    bool ok = thread_pool_for(count, POOL_BLOCK_VALUES, threads, sum_block, &job);
+    for (int t = 1; ok && t < threads; t++) ok = sum_accumulator_merge(&job.aggregates[0].sum, &job.aggregates[t].sum);
+    ok = ok && sum_accumulator_format(&job.aggregates[0].sum, out, size);
+
+    for (int t = 0; t < threads; t++) local_aggregate_free(&job.aggregates[t]);
+    free(job.aggregates);
+    return ok;
+}
+
+typedef bool (*summer_t)(const columnar_subregion_t *, size_t, int, char *, size_t);
+
+// Best of repeats, the sum of the last run goes to out
+static double time_sum(summer_t summer, const columnar_subregion_t *region, size_t count, int threads,
+                       int repeats, char *out, size_t size) {
+    double best = -1;
+    for (int r = 0; r < repeats; r++) {
+        double start = now_seconds();
+        if (!summer(region, count, threads, out, size)) return -1;
+        double elapsed = now_seconds() - start;
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <values> [threads...]\n", argv[0]);
+        return 1;
+    }
+
+    size_t count = strtoull(argv[1], NULL, 10);
+    if (count == 0) count = DEFAULT_VALUES;
+    int repeats = getenv("BENCH_REPEATS") ? atoi(getenv("BENCH_REPEATS")) : DEFAULT_REPEATS;
+
+    columnar_subregion_t region;
+    if (!build_values(count, &region)) {
+        fprintf(stderr, "[ERROR] Failed to build %zu values\n", count);
+        return 1;
+    }
+
+    char expected[MAX_NUMBER_LENGTH];
+    char actual[MAX_NUMBER_LENGTH];
+
+    printf("%-8s %12s %8s %12s %10s %10s\n", "split", "values", "threads", "seconds", "Mvals/s", "speedup");
+    for (int a = 2; a < argc || a == 2; a++) {
+        int threads = a < argc ? atoi(argv[a]) : 4;
+        if (threads < 1) threads = 1;
+        if (threads > THREAD_POOL_MAX_WORKERS) threads = THREAD_POOL_MAX_WORKERS;
+
+        double baseline = time_sum(sum_static, &region, count, threads, repeats, expected, sizeof(expected));
+        double pooled = time_sum(sum_pool, &region, count, threads, repeats, actual, sizeof(actual));
+        if (baseline < 0 || pooled < 0) {
+            fprintf(stderr, "[ERROR] Sum failed with %d threads\n", threads);
+            return 1;
+        }
+        if (strcmp(expected, actual) != 0) {
+            fprintf(stderr, "[ERROR] Pool sum %s disagrees with static sum %s\n", actual, expected);
+            return 1;
+        }
+
+        printf("%-8s %12zu %8d %12.4f %10.2f %9.1fx\n", "static", count, threads, baseline,
+               count / baseline / 1e6, 1.0);
+        printf("%-8s %12zu %8d %12.4f %10.2f %9.1fx\n", "pool", count, threads, pooled,
+               count / pooled / 1e6, baseline / pooled);
+    }
+
+    free_columnar_subregion(&region);
+    return 0;
+}
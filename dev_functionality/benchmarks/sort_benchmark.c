@@ -0,0 +1,214 @@
+// benchmarks/sort_benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "../../data_preperation/cli_ops/tokenizer/tokenizer.h"
+#include "../../data_preperation/arithmetic_lib/columnar/columnar.h"
+#include "../../data_preperation/arithmetic_lib/fat_data/fat_data.h"
+#include "../../data_preperation/arithmetic_lib/sorting/sort_key/sort_key.h"
+#include "../../data_preperation/arithmetic_lib/sorting/merge/merge.h"
+#include "../../data_preperation/arithmetic_lib/sorting/radix/radix.h"
+
+#define DEFAULT_REPEATS 3
+
+// The string sort takes minutes past a few million values
+#define LEGACY_MAX_VALUES 3000000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+    The merge sort the median used before sort keys, kept here as the baseline.
+    It sorts string pointers with compare_big_numbers and allocates both halves on every merge.
+ */
+static void legacy_merge(char **chunk, int left, int mid, int right) {
+    int n1 = mid - left + 1;
+    int n2 = right - mid;
+
+    char **L = malloc(n1 * sizeof(char *));
+    char **R = malloc(n2 * sizeof(char *));
+    if (!L || !R) {
+        fprintf(stderr, "malloc failed in merge\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < n1; i++) L[i] = chunk[left + i];
+    for (int j = 0; j < n2; j++) R[j] = chunk[mid + 1 + j];
+
+    int i = 0, j = 0, k = left;
+    while (i < n1 && j < n2) {
+        if (compare_big_numbers(L[i], R[j]) <= 0) {
+            chunk[k++] = L[i++];
+        } else {
+            chunk[k++] = R[j++];
+        }
+    }
+
+    while (i < n1) chunk[k++] = L[i++];
+    while (j < n2) chunk[k++] = R[j++];
+
+    free(L);
+    free(R);
+}
+
+static void legacy_merge_sort(char **chunk, int left, int right) {
+    if (left < right) {
+        int mid = left + (right - left) / 2;
+        legacy_merge_sort(chunk, left, mid);
+        legacy_merge_sort(chunk, mid + 1, right);
+        legacy_merge(chunk, left, mid, right);
+    }
+}
+
+typedef enum { SORT_LEGACY, SORT_MERGE, SORT_RADIX } sort_kind_t;
+
+typedef struct {
+    const char *name;
+    sort_kind_t kind;
+} contender_t;
+
+static const contender_t contenders[] = {
+    { "legacy", SORT_LEGACY },
+    { "merge",  SORT_MERGE },
+    { "radix",  SORT_RADIX },
+};
+
+// Append every cell of a window to the chunk's single column
+static bool append_cells(void *context, const char *data, const cell_view_t *cells, int num_rows, int data_width) {
+    columnar_builder_t *builder = context;
+    for (size_t i = 0; i < (size_t)num_rows * data_width; i++) {
+        if (!columnar_builder_append(builder, 0, data + cells[i].offset, cells[i].length)) return false;
+    }
+    return true;
+}
+
+// Every cell of the file as a single column, the way the marshaller sees a subregion
+static bool load_values(const char *file, columnar_subregion_t *region) {
+    header_strings no_headers = {0};
+    header_integers indeces = { -1, -1, -1, -1 };
+    table_layout_t layout;
+    if (!scan_table_layout(file, no_headers, &indeces, &layout, 1)) return false;
+
+    int num_chunks = layout.num_chunks;
+    size_t count = (size_t)layout.num_lines * layout.data_width;
+    columnar_builder_t *builders = calloc(num_chunks ? num_chunks : 1, sizeof(columnar_builder_t));
+    void **contexts = malloc((num_chunks ? num_chunks : 1) * sizeof(void *));
+    bool ok = builders && contexts && count > 0 && count <= INT_MAX;
+    for (int i = 0; ok && i < num_chunks; i++) {
+        ok = columnar_builder_init(&builders[i], 1);
+        contexts[i] = &builders[i];
+    }
+
+    ok = ok && stream_table_rows(&layout, 0, layout.num_lines - 1, append_cells, contexts);
+    ok = ok && columnar_from_builders(builders, num_chunks, (int)count, 1, region);
+
+    for (int i = 0; builders && i < num_chunks; i++) columnar_builder_free(&builders[i]);
+    free(builders);
+    free(contexts);
+    free_table_layout(&layout);
+    return ok;
+}
+
+// Best of repeats, each on a fresh copy of the unsorted input
+static double time_sort(const contender_t *c, const sort_keys_t *keys, const columnar_subregion_t *region,
+                        int repeats, sort_key_t *work, sort_key_t *scratch, char **strings) {
+    int count = keys->count;
+    double best = -1;
+
+    for (int r = 0; r < repeats; r++) {
+        if (c->kind == SORT_LEGACY) {
+            for (int i = 0; i < count; i++) strings[i] = region->bytes + keys->entries[i].value;
+        } else {
+            memcpy(work, keys->entries, count * sizeof(sort_key_t));
+        }
+
+        double start = now_seconds();
+        switch (c->kind) {
+            case SORT_LEGACY: legacy_merge_sort(strings, 0, count - 1); break;
+            case SORT_MERGE:  merge_sort(work, count); break;
+            case SORT_RADIX:  radix_sort(work, scratch, count); break;
+        }
+        double elapsed = now_seconds() - start;
+
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <csv> [csv...]\n", argv[0]);
+        return 1;
+    }
+
+    int repeats = getenv("BENCH_REPEATS") ? atoi(getenv("BENCH_REPEATS")) : DEFAULT_REPEATS;
+
+    printf("%-60s %-8s %12s %12s %10s %10s\n", "file", "sort", "values", "seconds", "Mkeys/s", "speedup");
+    for (int f = 1; f < argc; f++) {
+        columnar_subregion_t region;
+        sort_keys_t keys;
+        if (!load_values(argv[f], &region)) {
+            fprintf(stderr, "[ERROR] Failed to load %s\n", argv[f]);
+            return 1;
+        }
+        size_t num_values = (size_t)region.num_rows;
+        if (!sort_keys_build(&keys, &region, 0, num_values)) return 1;
+
+        int count = keys.count;
+        sort_key_t *work = malloc((count ? count : 1) * sizeof(sort_key_t));
+        sort_key_t *scratch = malloc((count ? count : 1) * sizeof(sort_key_t));
+        sort_key_t *expected = malloc((count ? count : 1) * sizeof(sort_key_t));
+        char **strings = malloc((count ? count : 1) * sizeof(char *));
+        if (!work || !scratch || !expected || !strings) {
+            fprintf(stderr, "[ERROR] Failed to allocate %d keys\n", count);
+            return 1;
+        }
+
+        // Both key sorts are stable so their orders match exactly, the string sort matches by value
+        memcpy(expected, keys.entries, count * sizeof(sort_key_t));
+        merge_sort(expected, count);
+
+        // compare_big_numbers orders text by length, keys put it after the numbers, so only numbers are checked
+        bool all_numeric = true;
+        for (int k = 0; k < count && all_numeric; k++) all_numeric = is_valid_double(region.bytes + keys.entries[k].value);
+
+        double baseline = -1;
+        for (size_t i = 0; i < sizeof(contenders) / sizeof(contenders[0]); i++) {
+            const contender_t *c = &contenders[i];
+            if (c->kind == SORT_LEGACY && count > LEGACY_MAX_VALUES) continue;
+
+            double seconds = time_sort(c, &keys, &region, repeats, work, scratch, strings);
+
+            bool agrees = true;
+            for (int k = 0; k < count && agrees; k++) {
+                if (c->kind != SORT_LEGACY) agrees = work[k].value == expected[k].value;
+                else if (all_numeric) agrees = compare_big_numbers(strings[k], region.bytes + expected[k].value) == 0;
+            }
+            if (!agrees) {
+                fprintf(stderr, "[ERROR] %s disagrees with merge on %s\n", c->name, argv[f]);
+                return 1;
+            }
+
+            if (baseline < 0) baseline = seconds;
+            printf("%-60s %-8s %12d %12.4f %10.2f %9.1fx\n", argv[f], c->name, count, seconds,
+                   count / seconds / 1e6, baseline / seconds);
+        }
+
+        free(work);
+        free(scratch);
+        free(expected);
+        free(strings);
+        sort_keys_free(&keys);
+        free_columnar_subregion(&region);
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+// benchmarks/tokenizer_benchmark.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../data_preperation/cli_ops/tokenizer/tokenizer.h"
+#include "../../data_preperation/cli_ops/tokenizer/structural_scan.h"
+
+#define DEFAULT_REPEATS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool count_cells(void *context, const char *data, const cell_view_t *cells, int num_rows, int data_width) {
+    *(size_t *)context += (size_t)num_rows * data_width;
+    return true;
+}
+
+// Best of repeats wall time to scan the layout and stream every row on one thread, the path the CLI runs
+static double time_tokenize(const char *file, int repeats, size_t *bytes, size_t *cells) {
+    header_strings no_headers = {0};
+    double best = -1;
+
+    for (int r = 0; r < repeats; r++) {
+        header_integers indeces = { -1, -1, -1, -1 };
+        table_layout_t layout;
+        size_t counted = 0;
+        void *context = &counted;
+
+        double start = now_seconds();
+        if (!scan_table_layout(file, no_headers, &indeces, &layout, 1)) return -1;
+        bool ok = layout.num_lines == 0 || stream_table_rows(&layout, 0, layout.num_lines - 1, count_cells, &context);
+        double elapsed = now_seconds() - start;
+
+        *bytes = layout.data_size;
+        *cells = counted;
+        free_table_layout(&layout);
+        if (!ok) return -1;
+
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <csv> [csv...]\n", argv[0]);
+        return 1;
+    }
+
+    int repeats = getenv("BENCH_REPEATS") ? atoi(getenv("BENCH_REPEATS")) : DEFAULT_REPEATS;
+    scan_isa_t best_isa = scan_active_isa();
+
+    printf("%-60s %-8s %12s %10s\n", "file", "isa", "cells", "GB/s");
+    for (int f = 1; f < argc; f++) {
+        size_t expected_cells = 0;
+
+        for (scan_isa_t isa = SCAN_SCALAR; isa <= best_isa; isa++) {
+            size_t bytes = 0, cells = 0;
+            scan_set_isa(isa);
+
+            double seconds = time_tokenize(argv[f], repeats, &bytes, &cells);
+            if (seconds < 0) {
+                fprintf(stderr, "[ERROR] Failed to tokenize %s\n", argv[f]);
+                return 1;
+            }
+
+            if (isa == SCAN_SCALAR) expected_cells = cells;
+            else if (cells != expected_cells) {
+                fprintf(stderr, "[ERROR] %s produced %zu cells, scalar produced %zu\n", scan_isa_name(isa), cells, expected_cells);
+                return 1;
+            }
+
+            printf("%-60s %-8s %12zu %10.3f\n", argv[f], scan_isa_name(isa), cells, bytes / seconds / 1e9);
+        }
+    }
+
+    scan_set_isa(best_isa);
+    return 0;
+}
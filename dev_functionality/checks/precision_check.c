@@ -0,0 +1,104 @@
+// checks/precision_check.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../../data_preperation/cli_ops/martix_lib.h"
+
+typedef struct {
+    const char *csv;
+    int precision;
+    const char *mean;
+    const char *median;
+    const char *quantiles[3];   // At 0.25, 0.5 and 0.9
+} precision_case_t;
+
+// Results that truncate to zero, below one, negative, and exact, at precision 0 and with a fraction
+static const precision_case_t CASES[] = {
+    { "a,b,c\n1,1,0\n0,1,1\n", 0, "0", "1", { "0", "1", "1" } },
+    { "a,b\n-1,0\n0,0\n", 0, "0", "0", { "0", "0", "0" } },
+    { "a,b\n0,0\n0,0\n", 0, "0", "0", { "0", "0", "0" } },
+    { "a,b\n1,2\n1,2\n", 0, "1", "1", { "1", "1", "2" } },
+    { "a,b\n-3,-4\n-5,-6\n", 0, "-4", "-4", { "-5", "-4", "-3" } },
+    { "a,b,c\n1,1,0\n0,1,1\n", 3, "0.666", "1.000", { "0.250", "1.000", "1.000" } },
+    { "a,b\n-1,0\n0,0\n", 2, "-0.25", "0.00", { "-0.25", "0.00", "0.00" } },
+    { "a,b\n0,0\n0,0\n", 1, "0.0", "0.0", { "0.0", "0.0", "0.0" } },
+};
+
+static bool write_csv(const char *path, const char *contents) {
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+    bool written = fputs(contents, file) >= 0;
+    return (fclose(file) == 0) && written;
+}
+
+static int expect(int number, const char *what, const char *actual, const char *expected) {
+    if (strcmp(actual, expected) == 0) return 0;
+    fprintf(stderr, "[FAIL] case %d %s: got \"%s\", expected \"%s\"\n", number, what, actual, expected);
+    return 1;
+}
+
+int main(void) {
+    char path[] = "/tmp/precision_checkXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "[ERROR] Could not create a temporary CSV\n");
+        return 1;
+    }
+    close(fd);
+
+    // The queries print their subregions and results, only failures go to the terminal
+    int terminal = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (terminal < 0 || null_fd < 0) {
+        fprintf(stderr, "[ERROR] Could not redirect stdout\n");
+        return 1;
+    }
+
+    int num_cases = sizeof(CASES) / sizeof(CASES[0]);
+    int failures = 0;
+    for (int i = 0; i < num_cases; i++) {
+        const precision_case_t *test = &CASES[i];
+        if (!write_csv(path, test->csv)) {
+            fprintf(stderr, "[ERROR] Could not write %s\n", path);
+            failures++;
+            break;
+        }
+
+        query_options_t options = QUERY_OPTIONS_DEFAULT;
+        options.precision = test->precision;
+        options.quantiles = "0.25,0.5,0.9";
+        final_args_t results;
+
+        fflush(stdout);
+        dup2(null_fd, STDOUT_FILENO);
+        dataframe_t *frame = fd_open(path, 1);
+        int status = frame ? fd_query(frame, "full", "full", "full", "full", OP_MEAN | OP_MEDIAN | OP_QUANTILES, 1,
+                                      &options, &results) : 1;
+        fd_close(frame);
+        fflush(stdout);
+        dup2(terminal, STDOUT_FILENO);
+
+        if (status != 0) {
+            fprintf(stderr, "[FAIL] case %d: query failed\n", i);
+            failures++;
+            continue;
+        }
+
+        failures += expect(i, "mean", results.mean_result, test->mean);
+        failures += expect(i, "median", results.median_result, test->median);
+        for (int q = 0; q < 3; q++) {
+            failures += expect(i, results.quantiles[q].text, results.quantile_results[q], test->quantiles[q]);
+        }
+    }
+
+    unlink(path);
+    close(null_fd);
+    close(terminal);
+
+    printf("%d cases, %d failures\n", num_cases, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Exit on error
+set -e
+
+if [ "$#" -lt 1 ]; then
+    echo "Usage: $0 <check>"
+    echo "Example: $0 precision"
+    exit 1
+fi
+
+CHECK="$1"
+shift
+
+CHECK_DIR="./dev_functionality/checks"
+CHECK_SOURCE="$CHECK_DIR/${CHECK}_check.c"
+CHECK_EXEC="$CHECK_DIR/${CHECK}_check"
+SHARED_LIB_DIR="./shared_libraries"
+SHARED_LIB_NAME="libmatrix_lib.so"
+
+if [ ! -f "$CHECK_SOURCE" ]; then
+    echo "[❌] Error: no check named '$CHECK' ($CHECK_SOURCE)"
+    exit 1
+fi
+
+mkdir -p "$SHARED_LIB_DIR"
+
+# Reuse the source list from the analysis script so the library matches what the CLI runs
+eval "$(sed -n '/^# Define paths/,/^# Create necessary folders/p' ./dev_functionality/run_analysis.sh)"
+
+echo "[🔧] Building $SHARED_LIB_NAME..."
+gcc -shared -fPIC -g -O2 -o "$SHARED_LIB_DIR/$SHARED_LIB_NAME" \
+    "$MATRIX_LIB_SOURCE" "$TOKENIZER_SOURCE" "$STRUCTURAL_SCAN_SOURCE" "$FAT_DATA_SOURCE" "$BIGNUM_SOURCE" "$DECIMAL_SOURCE" "$MARSHALLER_SOURCE" "$STREAMER_SOURCE" "$PIPELINE_SOURCE" "$SIDECAR_SOURCE" "$HEADER_INDEX_SOURCE" "$STATISTICAL_OPS_SOURCE" "$SORT_KEY_SOURCE" "$MERGE_SORT_SOURCE" "$RADIX_SORT_SOURCE" "$SELECT_SOURCE" "$HASHMAP_SOURCE" "$FREQUENCY_SUMMARY_SOURCE" "$COLUMNAR_SOURCE" "$THREAD_POOL_SOURCE" "$RING_BUFFER_SOURCE" -lpthread
+
+gcc -g -O2 -o "$CHECK_EXEC" "$CHECK_SOURCE" -L"$SHARED_LIB_DIR" -lmatrix_lib -lpthread
+export LD_LIBRARY_PATH="$SHARED_LIB_DIR:$LD_LIBRARY_PATH"
+
+echo "[🧪] Running $CHECK check..."
+"$CHECK_EXEC" "$@"
@@ -16,15 +16,29 @@ SHARED_LIB_NAME="libmatrix_lib.so"
 STATISTICAL_OPS_SOURCE="./data_preperation/arithmetic_lib/statistical_ops/statistical_ops.c"
 MATRIX_LIB_SOURCE="./data_preperation/cli_ops/matrix_lib.c"
 FAT_DATA_SOURCE="./data_preperation/arithmetic_lib/fat_data/fat_data.c"
+BIGNUM_SOURCE="./data_preperation/arithmetic_lib/bignum/bignum.c"
+DECIMAL_SOURCE="./data_preperation/arithmetic_lib/decimal/decimal.c"
 MARSHALLER_SOURCE="./data_preperation/cli_ops/marshaller/marshaller.c"
+TOKENIZER_SOURCE="./data_preperation/cli_ops/tokenizer/tokenizer.c"
+STRUCTURAL_SCAN_SOURCE="./data_preperation/cli_ops/tokenizer/structural_scan.c"
+STREAMER_SOURCE="./data_preperation/cli_ops/streamer/streamer.c"
+PIPELINE_SOURCE="./data_preperation/cli_ops/pipeline/pipeline.c"
+SIDECAR_SOURCE="./data_preperation/cli_ops/sidecar/sidecar.c"
+HEADER_INDEX_SOURCE="./data_preperation/cli_ops/header_index/header_index.c"
+SORT_KEY_SOURCE="./data_preperation/arithmetic_lib/sorting/sort_key/sort_key.c"
 MERGE_SORT_SOURCE="./data_preperation/arithmetic_lib/sorting/merge/merge.c"
+RADIX_SORT_SOURCE="./data_preperation/arithmetic_lib/sorting/radix/radix.c"
+SELECT_SOURCE="./data_preperation/arithmetic_lib/sorting/select/select.c"
 HASHMAP_SOURCE="./data_preperation/arithmetic_lib/hashmap/hashmap.c"
+FREQUENCY_SUMMARY_SOURCE="./data_preperation/arithmetic_lib/frequency_summary/frequency_summary.c"
+COLUMNAR_SOURCE="./data_preperation/arithmetic_lib/columnar/columnar.c"
+THREAD_POOL_SOURCE="./data_preperation/arithmetic_lib/thread_pool/thread_pool.c"
+RING_BUFFER_SOURCE="./data_preperation/arithmetic_lib/ring_buffer/ring_buffer.c"
 PYTHON_SCRIPT="./cli_parser.py"
 HOOK_C="./dev_functionality/valgrind/valgrind_driver.c"
 HOOK_EXEC="./dev_functionality/valgrind/valgrind_runner"
 valgrind_LOG_DIR="./memory_logs"
 valgrind_LOG_PREFIX="$valgrind_LOG_DIR/valgrind_log"
-K_WAY_MERGE_SOURCE="./data_preperation/arithmetic_lib/sorting/k_way/k_way.c"
 
 
 # Create necessary folders
@@ -72,7 +86,7 @@ if [ "$MEMCHECK" = true ]; then
 
     # Compile shared lib WITHOUT valgrind (no sanitizer needed for Valgrind)
     gcc -shared -fPIC -g -O2 -o "$SHARED_LIB_DIR/$SHARED_LIB_NAME" \
-        "$MATRIX_LIB_SOURCE" "$FAT_DATA_SOURCE" "$MARSHALLER_SOURCE" "$STATISTICAL_OPS_SOURCE" "$MERGE_SORT_SOURCE" "$K_WAY_MERGE_SOURCE" "$HASHMAP_SOURCE" -lpthread
+        "$MATRIX_LIB_SOURCE" "$TOKENIZER_SOURCE" "$STRUCTURAL_SCAN_SOURCE" "$FAT_DATA_SOURCE" "$BIGNUM_SOURCE" "$DECIMAL_SOURCE" "$MARSHALLER_SOURCE" "$STREAMER_SOURCE" "$PIPELINE_SOURCE" "$SIDECAR_SOURCE" "$HEADER_INDEX_SOURCE" "$STATISTICAL_OPS_SOURCE" "$SORT_KEY_SOURCE" "$MERGE_SORT_SOURCE" "$RADIX_SORT_SOURCE" "$SELECT_SOURCE" "$HASHMAP_SOURCE" "$FREQUENCY_SUMMARY_SOURCE" "$COLUMNAR_SOURCE" "$THREAD_POOL_SOURCE" "$RING_BUFFER_SOURCE" -lpthread
 
     # Compile the hook runner (C entry point)
     gcc -g -O2 -o "$HOOK_EXEC" "$HOOK_C" -L"$SHARED_LIB_DIR" -lmatrix_lib
@@ -122,7 +136,7 @@ else
 
     # Compile shared lib without Valgrind
     gcc -shared -fPIC -g -O2 -o "$SHARED_LIB_DIR/$SHARED_LIB_NAME" \
-        "$MATRIX_LIB_SOURCE" "$FAT_DATA_SOURCE" "$MARSHALLER_SOURCE" "$STATISTICAL_OPS_SOURCE" "$MERGE_SORT_SOURCE" "$K_WAY_MERGE_SOURCE" "$HASHMAP_SOURCE" -lpthread
+        "$MATRIX_LIB_SOURCE" "$TOKENIZER_SOURCE" "$STRUCTURAL_SCAN_SOURCE" "$FAT_DATA_SOURCE" "$BIGNUM_SOURCE" "$DECIMAL_SOURCE" "$MARSHALLER_SOURCE" "$STREAMER_SOURCE" "$PIPELINE_SOURCE" "$SIDECAR_SOURCE" "$HEADER_INDEX_SOURCE" "$STATISTICAL_OPS_SOURCE" "$SORT_KEY_SOURCE" "$MERGE_SORT_SOURCE" "$RADIX_SORT_SOURCE" "$SELECT_SOURCE" "$HASHMAP_SOURCE" "$FREQUENCY_SUMMARY_SOURCE" "$COLUMNAR_SOURCE" "$THREAD_POOL_SOURCE" "$RING_BUFFER_SOURCE" -lpthread
 
     # Run Python script as usual, passing operations and thread count
     python3 "$PYTHON_SCRIPT" "${ARGS[@]}"
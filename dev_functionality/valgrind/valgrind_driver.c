@@ -4,13 +4,19 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Your shared library's entry point
+// Your shared library's entry points
+typedef struct dataframe dataframe_t;
+
 extern int load_data(const char *, const char *, const char *, const char *, const char *, int, int);
+extern dataframe_t *fd_open(const char *, int);
+extern int fd_query(dataframe_t *, const char *, const char *, const char *, const char *, int, int,
+                    const void *, void *);
+extern void fd_close(dataframe_t *);
 
 int main(int argc, char *argv[]) {
     // Probably redundant
-    if (argc != 8) {
-        fprintf(stderr, "Usage: %s <file> <y0> <y1> <x0> <x1> <operations> <thread_count>\n", argv[0]);
+    if (argc < 8 || (argc - 8) % 4 != 0) {
+        fprintf(stderr, "Usage: %s <file> <y0> <y1> <x0> <x1> <operations> <thread_count> [<y0> <y1> <x0> <x1>]...\n", argv[0]);
         return 1;
     }
 
@@ -25,13 +31,36 @@ int main(int argc, char *argv[]) {
     printf("--------------------\n");
     printf("[RUNNING] %s %s %s %s %s\n", file, y0, y1, x0, x1);
 
-    int result = load_data(file, y0, y1, x0, x1, operations, thread_count);
+    // One range is a one-off load_data, more ranges are queried on one dataframe handle
+    if (argc == 8) {
+        int result = load_data(file, y0, y1, x0, x1, operations, thread_count);
+
+        if (result != 0) {
+            fprintf(stderr, "[ERROR] Command failed with error code: %d\n", result);
+        }
 
-    if (result != 0) {
-        fprintf(stderr, "[ERROR] Command failed with error code: %d\n", result);
+        return result;
     }
 
-    return result;
-}
+    dataframe_t *frame = fd_open(file, thread_count);
+    if (!frame) {
+        fprintf(stderr, "[ERROR] Could not open %s\n", file);
+        return 1;
+    }
+
+    // The first range sits before the operations and thread count, the rest follow them
+    int failures = 0;
+    for (int arg = 2; arg < argc; arg = (arg == 2) ? 8 : arg + 4) {
+        char **range = argv + arg;
+        if (arg != 2) printf("[RUNNING] %s %s %s %s %s\n", file, range[0], range[1], range[2], range[3]);
 
+        int result = fd_query(frame, range[0], range[1], range[2], range[3], operations, thread_count, NULL, NULL);
+        if (result != 0) {
+            fprintf(stderr, "[ERROR] Query failed with error code: %d\n", result);
+            failures++;
+        }
+    }
 
+    fd_close(frame);
+    return failures ? 1 : 0;
+}